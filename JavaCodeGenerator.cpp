@@ -1,4 +1,7 @@
 #include "JavaCodeGenerator.hpp"
+#include "log.hpp"
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <unordered_map>
 #include <stdexcept>
@@ -7,106 +10,96 @@
 #include <algorithm> // For std::find
 
 
-JavaCodeGenerator::JavaCodeGenerator() {
-    logFile.open("OUTPUT/jcg_logs.txt", std::ios::out | std::ios::trunc);
-    if (!logFile.is_open()) {
-        throw std::runtime_error("Failed to open OUTPUT/jcg_logs.txt for writing");
-    }
-    logFile << "[JCG] Log file opened successfully.\n";
-}
-JavaCodeGenerator::~JavaCodeGenerator() {
-    if (logFile.is_open()) {
-        logFile.close();
-    }
-}
+JavaCodeGenerator::JavaCodeGenerator() {}
 
 
 // --- STL Container Method Mapping Table ---
-static const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> stlMethodMap = {
-    {"ArrayList", {
-        {"push_back", "add"},
-        {"pop_back", "remove"}, // Java: remove(size()-1)
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
-        {"at", "get"},
-        {"front", "get"}, // Java: get(0)
-        {"back", "get"},  // Java: get(size()-1)
-        {"insert", "add"}, // Java: add(index, value)
-        {"erase", "remove"}, // Java: remove(index)
-        {"begin", "iterator"},
-        {"end", "iterator"},
+// Keyed by the Java container type and the C++ member name
+static const std::unordered_map<Symbol, std::unordered_map<Symbol, std::string>> stlMethodMap = {
+    {sym::ArrayList, {
+        {sym::push_back, "add"},
+        {sym::pop_back, "remove"}, // Java: remove(size()-1)
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
+        {sym::at, "get"},
+        {sym::front, "get"}, // Java: get(0)
+        {sym::back, "get"},  // Java: get(size()-1)
+        {sym::insert, "add"}, // Java: add(index, value)
+        {sym::erase, "remove"}, // Java: remove(index)
+        {sym::begin, "iterator"},
+        {sym::end, "iterator"},
     }},
-    {"LinkedList", {
-        {"push_back", "addLast"},
-        {"push_front", "addFirst"},
-        {"pop_back", "removeLast"},
-        {"pop_front", "removeFirst"},
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
-        {"front", "getFirst"},
-        {"back", "getLast"},
-        {"insert", "add"},
-        {"erase", "remove"},
+    {sym::LinkedList, {
+        {sym::push_back, "addLast"},
+        {sym::push_front, "addFirst"},
+        {sym::pop_back, "removeLast"},
+        {sym::pop_front, "removeFirst"},
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
+        {sym::front, "getFirst"},
+        {sym::back, "getLast"},
+        {sym::insert, "add"},
+        {sym::erase, "remove"},
     }},
-    {"HashSet", {
-        {"insert", "add"},
-        {"erase", "remove"},
-        {"find", "contains"},
-        {"count", "contains"},
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
+    {sym::HashSet, {
+        {sym::insert, "add"},
+        {sym::erase, "remove"},
+        {sym::find, "contains"},
+        {sym::count, "contains"},
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
     }},
-    {"HashMap", {
-        {"insert", "put"},
-        {"erase", "remove"},
-        {"find", "containsKey"},
-        {"count", "containsKey"},
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
-        {"at", "get"},
-        {"[]", "get"},
+    {sym::HashMap, {
+        {sym::insert, "put"},
+        {sym::erase, "remove"},
+        {sym::find, "containsKey"},
+        {sym::count, "containsKey"},
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
+        {sym::at, "get"},
+        {sym::subscript, "get"},
     }},
-    {"Stack", {
-        {"push", "push"},
-        {"pop", "pop"},
-        {"top", "peek"},
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
+    {sym::Stack, {
+        {sym::push, "push"},
+        {sym::pop, "pop"},
+        {sym::top, "peek"},
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
     }},
-    {"Queue", {
-        {"push", "add"},
-        {"pop", "remove"},
-        {"front", "peek"},
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
+    {sym::Queue, {
+        {sym::push, "add"},
+        {sym::pop, "remove"},
+        {sym::front, "peek"},
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
     }},
-    {"PriorityQueue", {
-        {"push", "add"},
-        {"pop", "remove"},
-        {"top", "peek"},
-        {"size", "size"},
-        {"empty", "isEmpty"},
-        {"clear", "clear"},
+    {sym::PriorityQueue, {
+        {sym::push, "add"},
+        {sym::pop, "remove"},
+        {sym::top, "peek"},
+        {sym::size, "size"},
+        {sym::empty, "isEmpty"},
+        {sym::clear, "clear"},
     }},
-    {"BitSet", {
-        {"set", "set"},
-        {"reset", "clear"},
-        {"flip", "flip"},
-        {"size", "size"},
-        {"count", "cardinality"},
-        {"any", "length"},
-        {"none", "isEmpty"},
+    {sym::BitSet, {
+        {sym::set, "set"},
+        {sym::reset, "clear"},
+        {sym::flip, "flip"},
+        {sym::size, "size"},
+        {sym::count, "cardinality"},
+        {sym::any, "length"},
+        {sym::none, "isEmpty"},
     }}
 };
 
 // Helper: Map ASTNodeType to string for debug
-static std::string astNodeTypeToString(ASTNodeType type) {
+std::string astNodeTypeToString(ASTNodeType type) {
     switch(type) {
         case ASTNodeType::PROGRAM: return "PROGRAM";
         case ASTNodeType::USING_DIRECTIVE: return "USING_DIRECTIVE";
@@ -176,6 +169,19 @@ static std::string astNodeTypeToString(ASTNodeType type) {
         case ASTNodeType::VECTOR_ACCESS: return "VECTOR_ACCESS";
         case ASTNodeType::ASSIGNMENT_EXPR: return "ASSIGNMENT_EXPR";
         case ASTNodeType::IDENTIFIER: return "IDENTIFIER";
+        case ASTNodeType::UNION_DECL: return "UNION_DECL";
+        case ASTNodeType::TYPEDEF_DECL: return "TYPEDEF_DECL";
+        case ASTNodeType::ELSE_STMT: return "ELSE_STMT";
+        case ASTNodeType::GOTO_STMT: return "GOTO_STMT";
+        case ASTNodeType::TEMPLATE_TYPE: return "TEMPLATE_TYPE";
+        case ASTNodeType::POINTER_TYPE: return "POINTER_TYPE";
+        case ASTNodeType::REFERENCE_TYPE: return "REFERENCE_TYPE";
+        case ASTNodeType::QUALIFIED_TYPE: return "QUALIFIED_TYPE";
+        case ASTNodeType::QUALIFIED_NAME: return "QUALIFIED_NAME";
+        case ASTNodeType::TEMPLATE_PARAM: return "TEMPLATE_PARAM";
+        case ASTNodeType::TEMPLATE_ARG: return "TEMPLATE_ARG";
+        case ASTNodeType::TYPE: return "TYPE";
+        case ASTNodeType::STREAM_EXPR: return "STREAM_EXPR";
         // case ASTNodeType::CONDITION: return "CONDITION";
         default: return "UNKNOWN/INVALID";
     }
@@ -183,7 +189,20 @@ static std::string astNodeTypeToString(ASTNodeType type) {
 
 // --- Program Node ---
 std::string JavaCodeGenerator::generateProgram(const Program* node, const std::string& className) {
-    logFile << "[JCG] Starting Java code generation for class: " << className << std::endl;
+    MemorySink out;
+    generateProgram(node, className, out);
+    return out.take();
+}
+
+void JavaCodeGenerator::generateProgram(const Program* node, const std::string& className, OutputSink& out) {
+    LOG_INFO(LogCategory::Codegen, "Starting Java code generation for class: " << className);
+    out.write(generateProgramHeader(className));
+    generateGlobals(node, className, out);
+    out.write("}\n");
+    LOG_INFO(LogCategory::Codegen, "Finished generating Java program for class: " << className);
+}
+
+std::string JavaCodeGenerator::generateProgramHeader(const std::string& className) const {
     std::ostringstream oss;
     // Emit required imports at the top
     for (const auto& imp : requiredImports) {
@@ -191,39 +210,50 @@ std::string JavaCodeGenerator::generateProgram(const Program* node, const std::s
     }
     oss << "\n";
     oss << "public class " << className << " {\n";
+    return oss.str();
+}
+
+std::string JavaCodeGenerator::generateGlobals(const Program* node, const std::string& className) {
+    MemorySink out;
+    generateGlobals(node, className, out);
+    return out.take();
+}
+
+void JavaCodeGenerator::generateGlobals(const Program* node, const std::string& className, OutputSink& out) {
+    std::string indented;
     int idx = 0;
     for (const auto& global : node->globals) {
         if (!global) {
-            logFile << "[JCG][ERROR] Null global node at index " << idx << std::endl;
+            LOG_ERROR(LogCategory::Codegen, "Null global node at index " << idx);
             continue;
         }
-        logFile << "[JCG] Generating code for global node type: " << astNodeTypeToString(global->type) << std::endl;
+        LOG_DEBUG(LogCategory::Codegen, "Generating code for global node type: " << astNodeTypeToString(global->type));
         std::string code = generate(global.get(), className);
-        // Indent each line of code inside the class
-        std::istringstream codeStream(code);
-        std::string line;
-        while (std::getline(codeStream, line)) {
-            if (!line.empty())
-                oss << "    " << line << "\n";
-            else
-                oss << "\n";
+        // Indent each line of code inside the class; every line ends in '\n'
+        indented.clear();
+        size_t pos = 0;
+        while (pos < code.size()) {
+            size_t end = code.find('\n', pos);
+            if (end == std::string::npos) end = code.size();
+            if (end > pos) {
+                indented += "    ";
+                indented.append(code, pos, end - pos);
+            }
+            indented += '\n';
+            pos = end + 1;
         }
+        out.write(indented);
         idx++;
     }
-    oss << "}\n";
-    logFile << "[JCG] Finished generating Java program for class: " << className << std::endl;
-    return oss.str();
 }
 
 // --- Main dispatcher ---
 std::string JavaCodeGenerator::generate(const ASTNode* node, const std::string& className) {
     if (!node) {
-        logFile << "[JCG][ERROR] generate called with null node" << std::endl;
+        LOG_ERROR(LogCategory::Codegen, "generate called with null node");
         return "";
     }
-    logFile << "[JCG] Generating node type: " << astNodeTypeToString(node->type) << std::endl;
-    logFile.flush();
-    std::cout << "[JCG] Generating node type: " << astNodeTypeToString(node->type)  << std::endl;
+    LOG_DEBUG(LogCategory::Codegen, "Generating node type: " << astNodeTypeToString(node->type));
     switch (node->type) {
         case ASTNodeType::FUNCTION_DECL:
             return generateFunctionDecl(static_cast<const FunctionDecl*>(node), className);
@@ -329,6 +359,7 @@ std::string JavaCodeGenerator::generate(const ASTNode* node, const std::string&
         case ASTNodeType::DELETE_EXPR:
             return generateDeleteExpr(static_cast<const DeleteExpr*>(node), className);
         case ASTNodeType::PREPROCESSOR_DIRECTIVE:
+            return generatePreprocessorDirective(static_cast<const PreprocessorDirective*>(node));
         case ASTNodeType::PREPROCESSOR_INCLUDE:
         case ASTNodeType::PREPROCESSOR_DEFINE:
         case ASTNodeType::PREPROCESSOR_IFDEF:
@@ -340,7 +371,7 @@ std::string JavaCodeGenerator::generate(const ASTNode* node, const std::string&
         case ASTNodeType::PREPROCESSOR_UNDEF:
         case ASTNodeType::PREPROCESSOR_PRAGMA:
         case ASTNodeType::PREPROCESSOR_UNKNOWN:
-            return generatePreprocessorDirective(static_cast<const PreprocessorDirective*>(node));
+            return generatePreprocessorNode(node);
         case ASTNodeType::NAMESPACE_DECL:
             return generateNamespaceDecl(static_cast<const NamespaceDecl*>(node), className);
         case ASTNodeType::USING_DIRECTIVE:
@@ -355,7 +386,7 @@ std::string JavaCodeGenerator::generate(const ASTNode* node, const std::string&
             // For the root, call generateProgram
             return generateProgram(static_cast<const Program*>(node), className);
         default:
-            logFile << "[JCG][ERROR] Unsupported or invalid AST node type: (raw value), astNodeTypeToString: '" << astNodeTypeToString(node->type) << "'\n";
+            LOG_ERROR(LogCategory::Codegen, "Unsupported or invalid AST node type: (raw value), astNodeTypeToString: '" << astNodeTypeToString(node->type) << "'");
             return "";
     }
 }
@@ -377,48 +408,47 @@ std::string JavaCodeGenerator::generateExpressionStmt(const ExpressionStmt* node
 
 std::string JavaCodeGenerator::generateAssignmentExpr(const AssignmentExpr* node, const std::string& className) {
     //impelement
-    std::cout<<" assignment"  <<std::endl<< std::endl;
+    LOG_DEBUG(LogCategory::Codegen, "assignment");
 
 }
 
 std::string JavaCodeGenerator::generateBinaryExpr(const BinaryExpr* node, const std::string& className) {
     if (!node) {
-        logFile << "[JCG][ERROR] generateBinaryExpr called with null node" << std::endl;
+        LOG_ERROR(LogCategory::Codegen, "generateBinaryExpr called with null node");
         return "";
     }
     if (!node->left) {
-        logFile << "[JCG][ERROR] generateBinaryExpr: left operand is null for op '" ;//<< node->op << "'" << std::endl;
+        LOG_ERROR(LogCategory::Codegen, "generateBinaryExpr: left operand is null for op '"); //<< node->op << "'" << std::endl;
         return "";
     }
     if (!node->right && node->op != "=") { // allow assignment with missing right for error reporting
-        logFile << "[JCG][ERROR] generateBinaryExpr: right operand is null for op '" ;//<< node->op << "'" << std::endl;
+        LOG_ERROR(LogCategory::Codegen, "generateBinaryExpr: right operand is null for op '"); //<< node->op << "'" << std::endl;
         return "";
     }
     if (node->op.empty()) {
-        logFile << "[JCG][ERROR] generateBinaryExpr: op is empty" << std::endl;
+        LOG_ERROR(LogCategory::Codegen, "generateBinaryExpr: op is empty");
         return "";
     }
     // Special case: map[key] = value  ==>  map.put(key, value)
     if (node->op == "=" && node->left && node->left->type == ASTNodeType::ARRAY_ACCESS) {
         const ArrayAccess* arr = static_cast<const ArrayAccess*>(node->left.get());
         if (!arr->arrayExpr) {
-            logFile << "[JCG][ERROR] generateBinaryExpr: arr->arrayExpr is null" << std::endl;
+            LOG_ERROR(LogCategory::Codegen, "generateBinaryExpr: arr->arrayExpr is null");
             return "";
         }
         // Try to get the type from the symbol table if arrayExpr is an Identifier
         const ASTNode* typeNode = nullptr;
         if (arr->arrayExpr->type == ASTNodeType::IDENTIFIER) {
-            std::string varName = static_cast<const Identifier*>(arr->arrayExpr.get())->name;
-            auto it = symbolTable.find(varName);
+            auto it = symbolTable.find(static_cast<const Identifier*>(arr->arrayExpr.get())->symbol);
             if (it != symbolTable.end()) {
                 typeNode = it->second;
             }
         }
         if (typeNode && typeNode->type == ASTNodeType::TEMPLATE_TYPE) {
             const TemplateType* tt = static_cast<const TemplateType*>(typeNode);
-            std::string javaType = mapCppTypeNameToJava(tt->baseTypeName, false);
-            if (javaType == "HashMap" || javaType == "Map") {
-                logFile << "[JCG] Detected map assignment in generateBinaryExpr" << std::endl;
+            Symbol javaType = mapCppTypeNameToJava(tt->baseSymbol, false);
+            if (javaType == sym::HashMap || javaType == sym::Map) {
+                LOG_DEBUG(LogCategory::Codegen, "Detected map assignment in generateBinaryExpr");
                 return generate(arr->arrayExpr.get(), className) + ".put(" +
                        generate(arr->indexExpr.get(), className) + ", " +
                        generate(node->right.get(), className) + ")";
@@ -431,7 +461,7 @@ std::string JavaCodeGenerator::generateBinaryExpr(const BinaryExpr* node, const
     if (std::find(assignOps.begin(), assignOps.end(), opStr) != assignOps.end()) {
         std::string left = node->left ? generate(node->left.get(), className) : "";
         std::string right = node->right ? generate(node->right.get(), className) : "";
-        logFile << "[JCG] Assignment op: '" << opStr << "', left: '" << left << "', right: '" << right << "'" << std::endl;
+        LOG_DEBUG(LogCategory::Codegen, "Assignment op: '" << opStr << "', left: '" << left << "', right: '" << right << "'");
         if (right == "nullptr") right = "null";
         if (left == "nullptr") left = "null";
         return left + " " + opStr + " " + right;
@@ -439,7 +469,7 @@ std::string JavaCodeGenerator::generateBinaryExpr(const BinaryExpr* node, const
     // All other binary operators (arithmetic, logical, comparison)
     std::string left = generate(node->left.get(), className);
     std::string right = node->right ? generate(node->right.get(), className) : "";
-    logFile << "[JCG] Binary op: '" << node->op << "', left: '" << left << "', right: '" << right << "'" << std::endl;
+    LOG_DEBUG(LogCategory::Codegen, "Binary op: '" << node->op << "', left: '" << left << "', right: '" << right << "'");
     if (right == "nullptr") right = "null";
     if (left == "nullptr") left = "null";
     return "(" + left + " " + node->op + " " + right + ")";
@@ -466,12 +496,19 @@ std::string JavaCodeGenerator::generateTernaryExpr(const TernaryExpr* node, cons
 
 // --- Literal ---
 std::string JavaCodeGenerator::generateLiteral(const Literal* node)  {
-    if (node->literalType == "float") {
+    if (node->literalType == "int" || node->literalType == "float") {
+        // Java spells digit separators '_' and only knows the L and f suffixes; the lexer
+        // decoded the suffix, so it is dropped by length and respelled
         std::string val = node->value;
-        if (val.empty() || (val.back() != 'f' && val.back() != 'F')) {
-            val += "f";
-        }
-        return val;
+        std::replace(val.begin(), val.end(), '\'', '_');
+        if (node->suffix == NumberSuffix::Other) return val;
+        val.resize(val.size() - std::strlen(numberSuffixName(node->suffix)));
+        if (node->literalType == "float") return val + "f";
+        bool isLong = node->suffix == NumberSuffix::L || node->suffix == NumberSuffix::UL ||
+                      node->suffix == NumberSuffix::LL || node->suffix == NumberSuffix::ULL ||
+                      node->suffix == NumberSuffix::Z || node->suffix == NumberSuffix::UZ;
+        // A negative value is an unsigned one past 2^63
+        return isLong || node->intValue > INT32_MAX || node->intValue < 0 ? val + "L" : val;
     }
     if (node->literalType == "char" || node->literalType == "character") {
         // Ensure the value is wrapped in single quotes
@@ -511,12 +548,12 @@ std::string JavaCodeGenerator::mapTypeNodeToJava(const ASTNode* typeNode, bool f
     switch (typeNode->type) {
         case ASTNodeType::QUALIFIED_TYPE: {
             const QualifiedType* qt = static_cast<const QualifiedType*>(typeNode);
-            return mapCppTypeNameToJava(qt->name, forGeneric);
+            return javaTypeName(qt->symbol, qt->name, forGeneric);
         }
         case ASTNodeType::TEMPLATE_TYPE: {
             const TemplateType* tt = static_cast<const TemplateType*>(typeNode);
             std::ostringstream oss;
-            oss << mapCppTypeNameToJava(tt->baseTypeName, forGeneric) << "<";
+            oss << javaTypeName(tt->baseSymbol, tt->baseTypeName, forGeneric) << "<";
             for (size_t i = 0; i < tt->typeArgs.size(); ++i) {
                 oss << mapTypeNodeToJava(tt->typeArgs[i].get(), true);
                 if (i + 1 < tt->typeArgs.size()) oss << ", ";
@@ -538,7 +575,7 @@ std::string JavaCodeGenerator::mapTypeNodeToJava(const ASTNode* typeNode, bool f
             // Handle identifier as a type (primitive or user-defined)
             const Identifier* id = static_cast<const Identifier*>(typeNode);
             // Try to map to Java primitive/wrapper, else use as-is
-            std::string mapped = mapCppTypeNameToJava(id->name, forGeneric);
+            std::string mapped = javaTypeName(id->symbol, id->name, forGeneric);
             return mapped.empty() ? id->name : mapped;
         }
         default:
@@ -547,51 +584,46 @@ std::string JavaCodeGenerator::mapTypeNodeToJava(const ASTNode* typeNode, bool f
 }
 
 // --- Type Mapping: C++ type name to Java type name ---
-std::string JavaCodeGenerator::mapCppTypeNameToJava(const std::string& cppType, bool forGeneric) const {
-    static const std::unordered_map<std::string, std::string> primitiveMap = {
-        {"int", "int"}, {"float", "float"}, {"double", "double"}, {"char", "char"}, {"bool", "boolean"}
-    };
-    static const std::unordered_map<std::string, std::string> wrapperMap = {
-        {"int", "Integer"}, {"float", "Float"}, {"double", "Double"}, {"char", "Character"}, {"bool", "Boolean"}
-    };
-    static const std::unordered_map<std::string, std::string> typeMap = {
-        {"std::string", "String"}, {"string", "String"}, {"void", "void"},
-        {"vector", "ArrayList"}, {"std::vector", "ArrayList"},
-        {"deque", "ArrayDeque"}, {"std::deque", "ArrayDeque"},
-        {"list", "LinkedList"}, {"std::list", "LinkedList"},
-        {"map", "HashMap"}, {"std::map", "HashMap"},
-        {"unordered_map", "HashMap"}, {"std::unordered_map", "HashMap"},
-        {"set", "HashSet"}, {"std::set", "HashSet"},
-        {"unordered_set", "HashSet"}, {"std::unordered_set", "HashSet"},
-        {"multimap", "HashMap"}, {"std::multimap", "HashMap"},
-        {"multiset", "HashSet"}, {"std::multiset", "HashSet"},
-        {"stack", "Stack"}, {"std::stack", "Stack"},
-        {"queue", "Queue"}, {"std::queue", "Queue"},
-        {"priority_queue", "PriorityQueue"}, {"std::priority_queue", "PriorityQueue"},
-        {"bitset", "BitSet"}, {"std::bitset", "BitSet"},
-        {"array", "ArrayList"}, {"std::array", "ArrayList"},
-        {"pair", "AbstractMap.SimpleEntry"}, {"std::pair", "AbstractMap.SimpleEntry"},
-        {"tuple", "Object[]"}, {"std::tuple", "Object[]"},
-        {"optional", "Optional"}, {"std::optional", "Optional"},
-        {"variant", "Object"}, {"std::variant", "Object"},
-        {"any", "Object"}, {"std::any", "Object"},
-    };
-
-    if (forGeneric) {
-        auto it = wrapperMap.find(cppType);
-        if (it != wrapperMap.end()) return it->second;
-    } else {
-        auto it = primitiveMap.find(cppType);
-        if (it != primitiveMap.end()) return it->second;
-    }
-    auto it = typeMap.find(cppType);
-    if (it != typeMap.end()) return it->second;
-    return cppType;
+Symbol JavaCodeGenerator::mapCppTypeNameToJava(Symbol cppType, bool forGeneric) const {
+    switch (cppType) {
+        case sym::int_: return forGeneric ? sym::Integer : sym::int_;
+        case sym::float_: return forGeneric ? sym::Float : sym::float_;
+        case sym::double_: return forGeneric ? sym::Double : sym::double_;
+        case sym::char_: return forGeneric ? sym::Character : sym::char_;
+        case sym::bool_: return forGeneric ? sym::Boolean : sym::boolean;
+        case sym::string: case sym::std_string: return sym::String;
+        case sym::void_: return sym::void_;
+        case sym::vector: case sym::std_vector: return sym::ArrayList;
+        case sym::array: case sym::std_array: return sym::ArrayList;
+        case sym::deque: case sym::std_deque: return sym::ArrayDeque;
+        case sym::list: case sym::std_list: return sym::LinkedList;
+        case sym::map: case sym::std_map: return sym::HashMap;
+        case sym::unordered_map: case sym::std_unordered_map: return sym::HashMap;
+        case sym::multimap: case sym::std_multimap: return sym::HashMap;
+        case sym::set: case sym::std_set: return sym::HashSet;
+        case sym::unordered_set: case sym::std_unordered_set: return sym::HashSet;
+        case sym::multiset: case sym::std_multiset: return sym::HashSet;
+        case sym::stack: case sym::std_stack: return sym::Stack;
+        case sym::queue: case sym::std_queue: return sym::Queue;
+        case sym::priority_queue: case sym::std_priority_queue: return sym::PriorityQueue;
+        case sym::bitset: case sym::std_bitset: return sym::BitSet;
+        case sym::pair: case sym::std_pair: return sym::SimpleEntry;
+        case sym::tuple: case sym::std_tuple: return sym::ObjectArray;
+        case sym::optional: case sym::std_optional: return sym::Optional;
+        case sym::variant: case sym::std_variant: return sym::Object;
+        case sym::any: case sym::std_any: return sym::Object;
+        default: return sym::None;
+    }
+}
+
+std::string JavaCodeGenerator::javaTypeName(Symbol cppType, const std::string& cppName, bool forGeneric) const {
+    Symbol javaType = mapCppTypeNameToJava(cppType, forGeneric);
+    return javaType ? std::string(spellingOf(javaType)) : cppName;
 }
 
 // --- Function Declaration ---
 std::string JavaCodeGenerator::generateFunctionDecl(const FunctionDecl* node, const std::string& className, bool isClassMethod)  {
-    logFile << "[JCG] Entering generateFunctionDecl for function: " << node->name << ", returnType: \n";// << mapTypeNodeToJava(node->returnType.get()) << std::endl;
+    LOG_DEBUG(LogCategory::Codegen, "Entering generateFunctionDecl for function: " << node->name << ", returnType:"); // << mapTypeNodeToJava(node->returnType.get()) << std::endl;
     std::ostringstream oss;
     std::string returnType = mapTypeNodeToJava(node->returnType.get());
     if (!isClassMethod && !node->isConstructor && !node->isDestructor) {
@@ -622,13 +654,13 @@ std::string JavaCodeGenerator::generateFunctionDecl(const FunctionDecl* node, co
     } else {
         oss << " {}";
     }
-    logFile << "[JCG] Exiting generateFunctionDecl for function: " << node->name << std::endl;
+    LOG_DEBUG(LogCategory::Codegen, "Exiting generateFunctionDecl for function: " << node->name);
     return oss.str();
 }
 
 // --- Variable Declaration ---
 std::string JavaCodeGenerator::generateVarDecl(const VarDecl* node, const std::string& className) {
-    logFile << "[JCG] Generating variable: " << node->name << ", type: \n" ;// << mapTypeNodeToJava(node->type.get()) << std::endl;
+    LOG_DEBUG(LogCategory::Codegen, "Generating variable: " << node->name << ", type:"); // << mapTypeNodeToJava(node->type.get()) << std::endl;
     std::ostringstream oss;
     std::string typeStr = mapTypeNodeToJava(node->type.get());
     oss << typeStr << " " << node->name;
@@ -879,6 +911,53 @@ std::string JavaCodeGenerator::generatePreprocessorDirective(const PreprocessorD
     return oss.str();
 }
 
+// The lexer has already evaluated these (and left out dead #if branches); each node type
+// has its own fields, so the directive is spelled again from them
+std::string JavaCodeGenerator::generatePreprocessorNode(const ASTNode* node) {
+    std::ostringstream oss;
+    oss << "// #";
+    switch (node->type) {
+        case ASTNodeType::PREPROCESSOR_INCLUDE:
+            oss << "include " << static_cast<const PreprocessorInclude*>(node)->file;
+            break;
+        case ASTNodeType::PREPROCESSOR_DEFINE: {
+            const auto* define = static_cast<const PreprocessorDefine*>(node);
+            oss << "define " << define->macro;
+            if (!define->value.empty()) oss << " " << define->value;
+            break;
+        }
+        case ASTNodeType::PREPROCESSOR_UNDEF:
+            oss << "undef " << static_cast<const PreprocessorUndef*>(node)->macro;
+            break;
+        case ASTNodeType::PREPROCESSOR_IFDEF:
+            oss << "ifdef " << static_cast<const PreprocessorIfdef*>(node)->macro;
+            break;
+        case ASTNodeType::PREPROCESSOR_IFNDEF:
+            oss << "ifndef " << static_cast<const PreprocessorIfndef*>(node)->macro;
+            break;
+        case ASTNodeType::PREPROCESSOR_IF:
+            oss << "if " << static_cast<const PreprocessorIf*>(node)->condition;
+            break;
+        case ASTNodeType::PREPROCESSOR_ELIF:
+            oss << "elif " << static_cast<const PreprocessorElif*>(node)->condition;
+            break;
+        case ASTNodeType::PREPROCESSOR_ELSE:
+            oss << "else";
+            break;
+        case ASTNodeType::PREPROCESSOR_ENDIF:
+            oss << "endif";
+            break;
+        case ASTNodeType::PREPROCESSOR_PRAGMA:
+            oss << "pragma " << static_cast<const PreprocessorPragma*>(node)->pragma;
+            break;
+        default:
+            oss << static_cast<const PreprocessorUnknown*>(node)->text;
+            break;
+    }
+    oss << "\n";
+    return oss.str();
+}
+
 
 
 
@@ -999,24 +1078,28 @@ std::string JavaCodeGenerator::generateMemberAccess(const MemberAccess* node, co
     // Try to get type from symbol table
     const ASTNode* typeNode = nullptr;
     if (node->object->type == ASTNodeType::IDENTIFIER) {
-        std::string varName = static_cast<const Identifier*>(node->object.get())->name;
-        auto it = symbolTable.find(varName);
+        auto it = symbolTable.find(static_cast<const Identifier*>(node->object.get())->symbol);
         if (it != symbolTable.end()) {
             typeNode = it->second;
         }
     }
-    std::string javaType;
+    Symbol javaType = sym::None;
     if (typeNode && typeNode->type == ASTNodeType::TEMPLATE_TYPE) {
         const TemplateType* tt = static_cast<const TemplateType*>(typeNode);
-        javaType = mapCppTypeNameToJava(tt->baseTypeName, false);
+        javaType = mapCppTypeNameToJava(tt->baseSymbol, false);
+    }
+    const std::string* javaMethod = nullptr;
+    auto container = stlMethodMap.find(javaType);
+    if (container != stlMethodMap.end()) {
+        auto it = container->second.find(node->memberSymbol);
+        if (it != container->second.end()) javaMethod = &it->second;
     }
-    if (!javaType.empty() && stlMethodMap.count(javaType) && stlMethodMap.at(javaType).count(method)) {
-        std::string javaMethod = stlMethodMap.at(javaType).at(method);
-        logFile << "[JCG] Mapping member access: " << object << "." << method << "() to Java method: " << javaMethod << "()" << std::endl;
-        return object + "." + javaMethod + "()";
+    if (javaMethod) {
+        LOG_DEBUG(LogCategory::Codegen, "Mapping member access: " << object << "." << method << "() to Java method: " << *javaMethod << "()");
+        return object + "." + *javaMethod + "()";
     }
     // Fallback: emit as-is with a warning
-    logFile << "[JCG][WARN] Unmapped member access: " << object << "." << method << "()" << std::endl;
+    LOG_WARN(LogCategory::Codegen, "Unmapped member access: " << object << "." << method << "()");
     return "// WARNING: Unmapped member access: " + object + "." + method + "()";
 }
 std::string JavaCodeGenerator::generateArrayAccess(const ArrayAccess* node, const std::string& className)  {
@@ -1026,8 +1109,7 @@ std::string JavaCodeGenerator::generateArrayAccess(const ArrayAccess* node, cons
     // Try to get the type from the symbol table if arrayExpr is an Identifier
     const ASTNode* typeNode = nullptr;
     if (node->arrayExpr->type == ASTNodeType::IDENTIFIER) {
-        std::string varName = static_cast<const Identifier*>(node->arrayExpr.get())->name;
-        auto it = symbolTable.find(varName);
+        auto it = symbolTable.find(static_cast<const Identifier*>(node->arrayExpr.get())->symbol);
         if (it != symbolTable.end()) {
             typeNode = it->second;
         }
@@ -1036,8 +1118,8 @@ std::string JavaCodeGenerator::generateArrayAccess(const ArrayAccess* node, cons
     bool isMap = false;
     if (typeNode && typeNode->type == ASTNodeType::TEMPLATE_TYPE) {
         const TemplateType* tt = static_cast<const TemplateType*>(typeNode);
-        std::string javaType = mapCppTypeNameToJava(tt->baseTypeName, false);
-        if (javaType == "HashMap" || javaType == "Map") {
+        Symbol javaType = mapCppTypeNameToJava(tt->baseSymbol, false);
+        if (javaType == sym::HashMap || javaType == sym::Map) {
             isMap = true;
         }
     }
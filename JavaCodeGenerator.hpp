@@ -8,19 +8,29 @@
 #include <vector>
 #include <fstream>
 #include "ast.hpp"
+#include "output_sink.hpp"
+
+// Name of an AST node type for logs and --stats ("UNKNOWN/INVALID" for unnamed types)
+std::string astNodeTypeToString(ASTNodeType type);
 
 class JavaCodeGenerator {
 public:
     std::string generateProgram(const Program* node, const std::string& className = "Main");
-    mutable std::unordered_map<std::string, const ASTNode*> symbolTable;
+    // Streams the program into out one top-level declaration at a time
+    void generateProgram(const Program* node, const std::string& className, OutputSink& out);
+    // Pieces of generateProgram, used when a file is generated in independent chunks:
+    // imports + class opening line, and the indented class body for node's globals
+    std::string generateProgramHeader(const std::string& className) const;
+    std::string generateGlobals(const Program* node, const std::string& className);
+    void generateGlobals(const Program* node, const std::string& className, OutputSink& out);
+    mutable std::unordered_map<Symbol, const ASTNode*> symbolTable;
     mutable std::set<std::string> requiredImports;
     std::set<std::string> userDefinedTemplates;
     mutable std::vector<std::string> JCG_logs;
+    // Logs go to LogCategory::Codegen; see log.hpp
     JavaCodeGenerator();
-    ~JavaCodeGenerator();
 
 private:
-    std::ofstream logFile;
 
     std::string generate(const ASTNode* node, const std::string& className );
     // Main generators for top-level constructs
@@ -38,7 +48,10 @@ private:
 
     // Type mapping
     std::string mapTypeNodeToJava(const ASTNode* typeNode, bool forGeneric = false) const;
-    std::string mapCppTypeNameToJava(const std::string& cppType, bool forGeneric = false) const;    
+    // Java type for a C++ type name, or sym::None if it has no mapping
+    Symbol mapCppTypeNameToJava(Symbol cppType, bool forGeneric = false) const;
+    // Java spelling of a type name: the mapped type, or cppName unchanged
+    std::string javaTypeName(Symbol cppType, const std::string& cppName, bool forGeneric = false) const;
 
     std::string generateClassDecl(const ClassDecl* node, const std::string& className);
     std::string generateStructDecl(const StructDecl* node, const std::string& className);
@@ -89,6 +102,7 @@ private:
     std::string generateUnsupportedFeature(const std::string& feature, const std::string& details);
     // std::string generateProgram(const Program* node, const std::string& className) const;
     std::string generatePreprocessorDirective(const PreprocessorDirective* node);
+    std::string generatePreprocessorNode(const ASTNode* node);   // PreprocessorInclude ... PreprocessorUnknown
     std::string generateNamespaceDecl(const NamespaceDecl* node, const std::string& className);
     std::string generateUsingDirective(const UsingDirective* node, const std::string& className);
     std::string generateCatchStmt(const CatchStmt* node, const std::string& className);
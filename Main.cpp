@@ -1,130 +1,236 @@
-#include "lexer.hpp"
-#include "parser.hpp"
-#include "JavaCodeGenerator.hpp"
+#include "pipeline.hpp"
+#include "batch.hpp"
+#include "server.hpp"
+#include "cache.hpp"
+#include "header_cache.hpp"
+#include "log.hpp"
+#include "prelude.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
+#include <set>
 #include <string>
-std::string getBaseName(const std::string& path) {
-    // Find last slash or backslash (Windows or Unix paths)
-    size_t lastSlash = path.find_last_of("/\\");
-    std::string filename = (lastSlash == std::string::npos) ? path : path.substr(lastSlash + 1);
+#include <thread>
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " <source_file> [--emit=java,tokens,ast,lexer-log,parser-log,codegen-log] [--lex-jobs N]\n"
+              << "                [--include-dir <dir>]... [--prelude <header>]\n"
+              << "                [--cache-dir <dir>] [--cache-max-bytes N] [--stats[=text|json]] [--trace=<file>]\n"
+              << "       " << program << " --batch <dir|filelist> [--jobs N] [--out <dir>] [--split-bytes N]\n"
+              << "                [--include-dir <dir>]... [--prelude <header>]\n"
+              << "                [--cache-dir <dir>] [--cache-max-bytes N] [--stats[=text|json]] [--trace=<file>]\n"
+              << "       " << program << " --serve [--socket <path>] [--cache-entries N]\n"
+              << "                [--include-dir <dir>]... [--prelude <header>]\n";
+}
 
-    // Find last dot to remove extension
-    size_t dot = filename.find_last_of('.');
-    if (dot != std::string::npos) {
-        return filename.substr(0, dot);
+// Parse a comma-separated --emit list; throws std::runtime_error on an unknown artifact
+static std::set<std::string> parseEmitList(const std::string& list) {
+    static const std::set<std::string> known = {"java", "tokens", "ast", "lexer-log", "parser-log", "codegen-log"};
+    std::set<std::string> emit;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        std::string item = list.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) continue;
+        if (!known.count(item)) {
+            throw std::runtime_error("Unknown --emit artifact '" + item + "'");
+        }
+        emit.insert(item);
     }
-    return filename; // No extension found
+    return emit;
 }
-// ...existing code...
 
 int main(int argc, char* argv[]) {
+    auto startTime = std::chrono::steady_clock::now();
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <source_file>\n";
-        return 1;
-    }
-
-    std::ifstream file(argv[1]);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open source file '" << argv[1] << "'\n";
+        printUsage(argv[0]);
         return 1;
     }
 
-    std::string inputFilePath = argv[1];
-    std::string baseName = getBaseName(inputFilePath);
-    std::string javaOutputPath = "OUTPUT/" + baseName + ".java";
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
-    file.close();
-
-    std::cout << "Running transpiler on source file: " << argv[1] << "\n\n";
-
-    try {
-        // Lexing
-        Lexer lexer(source);
-        std::vector<std::unique_ptr<Token>> tokens = lexer.tokenize();
-
-        {
-            std::ofstream lexerOut("OUTPUT/lexer_output.txt", std::ios::trunc);
-            if (!lexerOut) {
-                std::cerr << "Error: Could not open OUTPUT/lexer_output.txt for writing\n";
+    std::string inputFilePath;
+    BatchOptions batch;
+    ServeOptions serve;
+    bool batchMode = false;
+    bool serveMode = false;
+    // Without --emit a single-file run writes every artifact and echoes progress, as it always has
+    bool emitGiven = false;
+    std::set<std::string> emit;
+    std::string cacheDir;
+    uint64_t cacheMaxBytes = 256ull * 1024 * 1024;
+    std::string tracePath;
+    unsigned lexJobs = 0;
+    std::vector<std::string> includeDirs;
+    std::string preludePath;
+    bool statsEnabled = false;
+    StatsFormat statsFormat = StatsFormat::Text;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--batch" && hasValue) {
+            batchMode = true;
+            batch.input = argv[++i];
+        } else if (arg == "--jobs" && hasValue) {
+            try {
+                batch.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for --jobs: '" << argv[i] << "'\n";
                 return 1;
             }
-            for (const auto& token : tokens) {
-                lexerOut << token->toString() << std::endl;
+        } else if (arg == "--lex-jobs" && hasValue) {
+            try {
+                lexJobs = static_cast<unsigned>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for --lex-jobs: '" << argv[i] << "'\n";
+                return 1;
             }
-        }
-
-        // Parsing
-        Parser parser(std::move(tokens));
-        std::unique_ptr<Program> ast = parser.parse();
-
-        // {
-        //     std::ofstream logFile("OUTPUT/parser_logs.txt", std::ios::trunc);
-        //     if (!logFile) {
-        //         std::cerr << "Error: Could not open OUTPUT/parser_logs.txt for writing\n";
-        //         return 1;
-        //     }
-        //     for (const auto& log : parser.getParseLogs()) {
-        //         logFile << log << std::endl;
-        //     }
-        // }
-
-        std::cout << "\n--- AST Output ---\n";
-        if (ast) {
-            // Write AST output to file instead of terminal
-            std::ofstream astOut("OUTPUT/ast_output.txt", std::ios::trunc);
-            if (!astOut) {
-                std::cerr << "Error: Could not open OUTPUT/ast_output.txt for writing\n";
+        } else if (arg == "--include-dir" && hasValue) {
+            includeDirs.push_back(argv[++i]);
+        } else if (arg == "--prelude" && hasValue) {
+            preludePath = argv[++i];
+        } else if (arg == "--split-bytes" && hasValue) {
+            try {
+                batch.splitBytes = std::stoull(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for --split-bytes: '" << argv[i] << "'\n";
+                return 1;
+            }
+        } else if (arg == "--serve") {
+            serveMode = true;
+        } else if (arg == "--socket" && hasValue) {
+            serve.socketPath = argv[++i];
+        } else if (arg == "--cache-entries" && hasValue) {
+            try {
+                serve.cacheEntries = std::stoul(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for --cache-entries: '" << argv[i] << "'\n";
+                return 1;
+            }
+        } else if (arg.rfind("--emit=", 0) == 0 || (arg == "--emit" && hasValue)) {
+            try {
+                emit = parseEmitList(arg == "--emit" ? argv[++i] : arg.substr(7));
+                emitGiven = true;
+            } catch (const std::exception& ex) {
+                std::cerr << "Error: " << ex.what() << "\n";
+                return 1;
+            }
+        } else if (arg == "--stats" || arg == "--stats=text") {
+            statsEnabled = true;
+            statsFormat = StatsFormat::Text;
+        } else if (arg == "--stats=json") {
+            statsEnabled = true;
+            statsFormat = StatsFormat::Json;
+        } else if (arg.rfind("--trace=", 0) == 0 || (arg == "--trace" && hasValue)) {
+            tracePath = arg == "--trace" ? argv[++i] : arg.substr(8);
+        } else if (arg == "--cache-dir" && hasValue) {
+            cacheDir = argv[++i];
+        } else if (arg == "--cache-max-bytes" && hasValue) {
+            try {
+                cacheMaxBytes = std::stoull(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for --cache-max-bytes: '" << argv[i] << "'\n";
                 return 1;
             }
-            astOut << ast->toString() << std::endl;
-            astOut.flush();
-            astOut.close();
-        } else {
-            std::cerr << "Error: AST is null. Aborting code generation.\n";
+        } else if (arg == "--out" && hasValue) {
+            batch.outputRoot = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Error: Unknown or incomplete option '" << arg << "'\n";
+            printUsage(argv[0]);
             return 1;
+        } else if (inputFilePath.empty()) {
+            inputFilePath = arg;
         }
+    }
 
-        // Java Code Generation
-        std::cout << "\n About to generate Java code...\n";
-        JavaCodeGenerator codegen;
-        std::string javaCode = codegen.generateProgram(ast.get(), baseName);
-        std::cout << "Java code generation complete.\n";
-
-        std::cout << "\n--- Generated Java Code ---\n";
-        std::cout << javaCode << std::endl;
+    // Lexer and preprocessor warnings (unterminated literals, bad macros, missing headers, ...)
+    // go to stderr unless --emit=lexer-log sends the whole lexer log to a file
+    Logger::openSink(LogCategory::Lexer, "-", LogLevel::Warn);
+
+    std::unique_ptr<ResultCache> cache;
+    if (!cacheDir.empty()) cache = std::make_unique<ResultCache>(cacheDir, cacheMaxBytes);
+    // Headers are lexed once per run; with --cache-dir, once per content and macro state
+    HeaderCache headers(includeDirs, cacheDir.empty() ? "" : cacheDir + "/headers");
+    if (!tracePath.empty()) Trace::start();
+    // Stats go to stderr so they never mix with the generated Java echoed on stdout
+    std::vector<FileStats> stats;
+    auto reportStats = [&] {
+        if (!statsEnabled) return;
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        printStats(std::cerr, statsFormat, stats, wall);
+    };
 
-        {
-            std::ofstream javaOut(javaOutputPath, std::ios::trunc);
-            if (!javaOut) {
-                std::cerr << "Error: Could not open " << javaOutputPath << " for writing\n";
+    try {
+        // Lexed once here (or loaded from the cache directory); every file starts from its state
+        std::unique_ptr<Prelude> prelude;
+        if (!preludePath.empty()) {
+            prelude = std::make_unique<Prelude>(preludePath, headers, cacheDir.empty() ? "" : cacheDir + "/headers");
+        }
+        if (serveMode) {
+            serve.headers = &headers;
+            serve.prelude = prelude.get();
+            return runServer(serve);
+        }
+        if (batchMode) {
+            if (emitGiven && (emit.size() != 1 || !emit.count("java"))) {
+                std::cerr << "Error: Batch mode only emits Java (--emit=java)\n";
                 return 1;
             }
-            javaOut << javaCode;
-            javaOut.flush();
+            batch.cache = cache.get();
+            batch.headers = &headers;
+            batch.prelude = prelude.get();
+            if (statsEnabled) batch.stats = &stats;
+            int result = runBatch(batch);
+            if (cache) {
+                cache->evict();
+                cache->printStats(std::cout);
+                headers.printStats(std::cout);
+            }
+            reportStats();
+            if (!tracePath.empty()) Trace::write(tracePath);
+            return result;
+        }
+        if (inputFilePath.empty()) {
+            printUsage(argv[0]);
+            return 1;
         }
 
-        // {
-        //     std::ofstream jcgLogOut("OUTPUT/JCG_logs.txt", std::ios::trunc);
-        //     if (!jcgLogOut) {
-        //         std::cerr << "Error: Could not open OUTPUT/JCG_logs.txt for writing\n";
-        //         return 1;
-        //     }
-        //     for (const auto& log : codegen.JCG_logs) {
-        //         jcgLogOut << log << std::endl;
-        //     }
-        //     jcgLogOut.flush();
-        // }
-    } 
+        if (!emitGiven) emit = {"java", "tokens", "ast", "parser-log", "codegen-log"};
+        PipelineOptions options;
+        options.verbose = !emitGiven;
+        if (emit.count("tokens")) options.tokenDumpPath = "OUTPUT/lexer_output.txt";
+        if (emit.count("ast")) options.astDumpPath = "OUTPUT/ast_output.txt";
+        if (emit.count("lexer-log")) options.lexerLogPath = "OUTPUT/lexer_logs.txt";
+        if (emit.count("parser-log")) options.parserLogPath = "OUTPUT/parser_logs.txt";
+        if (emit.count("codegen-log")) options.codegenLogPath = "OUTPUT/jcg_logs.txt";
+        options.cache = cache.get();
+        options.headers = &headers;
+        options.prelude = prelude.get();
+        options.lexJobs = lexJobs ? lexJobs : std::max(1u, std::thread::hardware_concurrency());
+        if (statsEnabled) {
+            stats.resize(1);
+            options.stats = &stats[0];
+        }
+        std::string javaOutputPath;
+        if (emit.count("java")) javaOutputPath = "OUTPUT/" + getBaseName(inputFilePath) + ".java";
+        transpileFile(inputFilePath, javaOutputPath, options);
+        if (cache) {
+            cache->evict();
+            cache->printStats(std::cout);
+            headers.printStats(std::cout);
+        }
+        reportStats();
+        if (!tracePath.empty()) Trace::write(tracePath);
+    }
     catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << std::endl;
         return 1;
     }
 
-    std::cout << "\nTranspiler run completed.\n";
+    if (!emitGiven) std::cout << "\nTranspiler run completed.\n";
     return 0;
 }
@@ -1,13 +1,15 @@
 #ifndef AST_HPP
 #define AST_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <iostream>
 
 // #include <optional>
-#include "tokens.hpp"  // your existing token types for reference if needed
+#include "token.hpp"  // your existing token types for reference if needed
 
 // Enumerate all node types in AST
 enum class ASTNodeType {
@@ -266,6 +268,12 @@ enum class ASTNodeType {
     // Additional nodes as needed
 };
 
+// Keep in sync with the last enumerator above
+constexpr size_t kASTNodeTypeCount = static_cast<size_t>(ASTNodeType::REINTERPRET_CAST_KEYWORD) + 1;
+
+// Nodes constructed on this thread per ASTNodeType; --stats reads the deltas around a parse
+inline thread_local uint64_t astNodesBuilt[kASTNodeTypeCount] = {};
+
 
 class TemplateType;
 class ASTNode;
@@ -362,7 +370,7 @@ class PreprocessorUnknown;
 class ASTNode {
 public:
     ASTNodeType type;
-    explicit ASTNode(ASTNodeType t) : type(t) {}
+    explicit ASTNode(ASTNodeType t) : type(t) { ++astNodesBuilt[static_cast<size_t>(t)]; }
     virtual ~ASTNode() = default;
     virtual std::string toString(int indent = 0) const {
         return std::string(indent, ' ') ;
@@ -522,8 +530,10 @@ public:
     bool isDestructor = false;
     bool isInline = false;
     bool isFriend = false;
-    explicit FunctionDecl(std::string funcName)
-        : ASTNode(ASTNodeType::FUNCTION_DECL), name(std::move(funcName)) {}
+    Symbol symbol;
+    explicit FunctionDecl(std::string funcName, Symbol funcSymbol = sym::None)
+        : ASTNode(ASTNodeType::FUNCTION_DECL), name(std::move(funcName)),
+          symbol(funcSymbol ? funcSymbol : intern(name)) {}
     std::string toString(int indent = 0) const override {
         std::string s = std::string(indent, ' ') + "FunctionDecl: " + name;
         if (returnType) s += " returns " + returnType->toString(0);
@@ -895,10 +905,20 @@ class Literal : public Expression {
 public:
     std::string value;
     std::string literalType;
+    // Numbers ("int" and "float"): the value and suffix the lexer decoded from value
+    long long intValue = 0;
+    double floatValue = 0;
+    NumberSuffix suffix = NumberSuffix::None;
     explicit Literal(std::string val)
         : Expression(ASTNodeType::LITERAL), value(std::move(val)), literalType("") {}
     Literal(std::string val, std::string type)
         : Expression(ASTNodeType::LITERAL), value(std::move(val)), literalType(std::move(type)) {}
+    // An INTEGER or FLOAT token
+    explicit Literal(const Token& number)
+        : Expression(ASTNodeType::LITERAL), value(number.text()),
+          literalType(number.type() == TokenType::FLOAT ? "float" : "int"),
+          intValue(number.type() == TokenType::FLOAT ? 0 : number.int_value()),
+          floatValue(number.type() == TokenType::FLOAT ? number.float_value() : 0), suffix(number.suffix()) {}
     std::string toString(int indent = 0) const override {
         return std::string(indent, ' ') + "Literal: " + literalType + " " + value;
     }
@@ -907,8 +927,10 @@ public:
 class Identifier : public Expression {
 public:
     std::string name;
-    explicit Identifier(std::string idName)
-        : Expression(ASTNodeType::IDENTIFIER), name(std::move(idName)) {}
+    Symbol symbol;   // Interned name; pass the token's symbol to skip a lookup
+    explicit Identifier(std::string idName, Symbol idSymbol = sym::None)
+        : Expression(ASTNodeType::IDENTIFIER), name(std::move(idName)),
+          symbol(idSymbol ? idSymbol : intern(name)) {}
     std::string toString(int indent = 0) const override {
         return std::string(indent, ' ') + "Identifier: " + name;
     }
@@ -947,9 +969,11 @@ class MemberAccess : public Expression {
 public:
     std::unique_ptr<ASTNode> object;
     std::string memberName;
+    Symbol memberSymbol;
     bool isArrow;
-    MemberAccess(std::unique_ptr<ASTNode> obj, std::string member, bool arrow)
-        : Expression(ASTNodeType::MEMBER_ACCESS), object(std::move(obj)), memberName(std::move(member)), isArrow(arrow) {}
+    MemberAccess(std::unique_ptr<ASTNode> obj, std::string member, bool arrow, Symbol symbol = sym::None)
+        : Expression(ASTNodeType::MEMBER_ACCESS), object(std::move(obj)), memberName(std::move(member)),
+          memberSymbol(symbol ? symbol : intern(memberName)), isArrow(arrow) {}
     std::string toString(int indent = 0) const override {
         return std::string(indent, ' ') + "MemberAccess: " + (object ? object->toString(0) : "null") + (isArrow ? "->" : ".") + memberName;
     }
@@ -1070,9 +1094,11 @@ public:
 class TemplateType : public ASTNode {
 public:
     std::string baseTypeName;
+    Symbol baseSymbol;
     std::vector<std::unique_ptr<ASTNode>> typeArgs;
     TemplateType(std::string base, std::vector<std::unique_ptr<ASTNode>> args)
-        : ASTNode(ASTNodeType::TEMPLATE_TYPE), baseTypeName(std::move(base)), typeArgs(std::move(args)) {}
+        : ASTNode(ASTNodeType::TEMPLATE_TYPE), baseTypeName(std::move(base)), baseSymbol(intern(baseTypeName)),
+          typeArgs(std::move(args)) {}
     std::string toString(int indent = 0) const override {
         std::string s = std::string(indent, ' ') + "TemplateType: " + baseTypeName + "<";
         for (const auto& t : typeArgs) if (t) s += t->toString(0) + ", ";
@@ -1084,10 +1110,11 @@ public:
 class QualifiedType : public ASTNode {
 public:
     std::string name;
+    Symbol symbol;
     bool isConst = false;
     bool isPointer = false;
     bool isReference = false;
-    QualifiedType(std::string n) : ASTNode(ASTNodeType::QUALIFIED_TYPE), name(std::move(n)) {}
+    QualifiedType(std::string n) : ASTNode(ASTNodeType::QUALIFIED_TYPE), name(std::move(n)), symbol(intern(name)) {}
     std::string toString(int indent = 0) const override {
         std::string s = std::string(indent, ' ') + "QualifiedType: " + name;
         if (isConst) s += " const";
@@ -0,0 +1,260 @@
+#include "batch.hpp"
+#include "cache.hpp"
+#include "header_cache.hpp"
+#include "output_sink.hpp"
+#include "pipeline.hpp"
+#include "prelude.hpp"
+#include "scheduler.hpp"
+#include "source_file.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool isCppSource(const fs::path& path) {
+    return path.extension() == ".cpp";
+}
+
+// Output path for a source, mirroring its position relative to the input root
+std::string mirrorPath(const fs::path& relative, const std::string& outputRoot) {
+    fs::path out = fs::path(outputRoot) / relative.parent_path();
+    out /= relative.stem().string() + ".java";
+    return out.string();
+}
+
+} // unnamed namespace
+
+std::vector<BatchJob> collectBatchJobs(const BatchOptions& options) {
+    std::vector<BatchJob> jobs;
+    fs::path input(options.input);
+    std::error_code ec;
+
+    if (fs::is_directory(input, ec)) {
+        for (auto it = fs::recursive_directory_iterator(input, ec);
+             it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (!it->is_regular_file(ec) || !isCppSource(it->path())) continue;
+            fs::path relative = it->path().lexically_relative(input);
+            jobs.push_back({it->path().string(), mirrorPath(relative, options.outputRoot)});
+        }
+        if (ec) {
+            throw std::runtime_error("Could not scan directory '" + options.input + "': " + ec.message());
+        }
+    } else {
+        std::ifstream list(options.input);
+        if (!list.is_open()) {
+            throw std::runtime_error("Could not open batch input '" + options.input + "'");
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            // Trim surrounding whitespace; skip blank lines and '#' comments
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            size_t last = line.find_last_not_of(" \t\r");
+            fs::path source(line.substr(first, last - first + 1));
+            fs::path relative = source.is_absolute() ? source.relative_path() : source.lexically_normal();
+            jobs.push_back({source.string(), mirrorPath(relative, options.outputRoot)});
+        }
+    }
+
+    std::sort(jobs.begin(), jobs.end(),
+              [](const BatchJob& a, const BatchJob& b) { return a.inputPath < b.inputPath; });
+    for (auto& job : jobs) {
+        uintmax_t size = fs::file_size(job.inputPath, ec);
+        job.sizeBytes = ec ? 0 : static_cast<uint64_t>(size);
+    }
+    return jobs;
+}
+
+namespace {
+
+// Tokens per subtask when a large file is split; keeps per-task overhead negligible
+constexpr size_t kMinChunkTokens = 4096;
+
+// Shared state of a file whose declarations are generated as separate subtasks
+struct SplitFile {
+    const BatchJob* job = nullptr;
+    std::string className;
+    ResultCache* cache = nullptr;
+    ResultCache::Key cacheKey;
+    std::vector<std::string> bodies;
+    std::vector<std::string> errors;
+    FileStats* stats = nullptr;            // Whole-file stats; each chunk fills its own entry below
+    std::vector<FileStats> chunkStats;
+    std::atomic<size_t> remaining{0};
+};
+
+// Called by whichever subtask finishes last: stitch the chunks together and write the file
+void finishSplitFile(SplitFile& file, std::string& error) {
+    for (const auto& e : file.errors) {
+        if (!e.empty()) { error = e; return; }
+    }
+    if (file.stats) {
+        for (const auto& chunk : file.chunkStats) file.stats->add(chunk);
+    }
+    PhaseTimer timer(file.stats, Phase::Write);
+    FileSink out(file.job->outputPath);
+    writeJavaProgram(out, file.className, file.bodies);
+    out.close();
+    if (file.stats) file.stats->outputBytes = out.bytesWritten();
+    if (file.cache) file.cache->storeFile(file.cacheKey, file.job->outputPath);
+}
+
+// Lex a large file, then hand its top-level declarations to the scheduler as stealable subtasks
+void transpileSplit(WorkStealingScheduler& scheduler, unsigned worker, const BatchJob& job,
+                    ResultCache* cache, HeaderCache* headers, const Prelude* prelude, FileStats* stats,
+                    std::string& error) {
+    TraceSpan span("split file", job.inputPath);
+    // Shared so the chunks' token views keep the mapping alive after this returns
+    std::shared_ptr<SourceFile> input;
+    {
+        PhaseTimer timer(stats, Phase::Read);
+        input = std::make_shared<SourceFile>(job.inputPath);
+    }
+    std::string_view source = input->text();
+    if (stats) stats->inputBytes = source.size();
+    std::string className = getBaseName(job.inputPath);
+    ResultCache::Key cacheKey;
+    uint64_t dependencies = cache && headers ? headers->dependencyHash(source, job.inputPath) : 0;
+    // A computed #include names a header only lexing can tell: such files are not cached
+    if (cache && (!headers || dependencies) && (!prelude || prelude->cacheable())) {
+        cacheKey = cache->key(source, className, dependencies, prelude ? prelude->hash() : 0);
+        std::string javaCode;
+        if (cache->lookup(cacheKey, javaCode)) {
+            PhaseTimer timer(stats, Phase::Write);
+            writeJavaFile(job.outputPath, javaCode);
+            if (stats) {
+                stats->cacheHit = true;
+                stats->outputBytes = javaCode.size();
+            }
+            return;
+        }
+    }
+
+    TokenBuffer tokens;
+    {
+        PhaseTimer timer(stats, Phase::Lex);
+        Lexer lexer(source, input);
+        if (headers) lexer.enableIncludes(*headers, job.inputPath);
+        if (prelude) lexer.restoreState(prelude->state());
+        tokens = lexer.tokenize();
+    }
+    if (stats) stats->tokens = tokens.size();
+    auto chunks = splitTopLevelDeclarations(std::move(tokens), kMinChunkTokens);
+    if (chunks.empty()) {
+        throw std::runtime_error("Lexer produced no tokens");
+    }
+
+    auto file = std::make_shared<SplitFile>();
+    file->job = &job;
+    file->className = className;
+    file->cache = cacheKey.name.empty() ? nullptr : cache;
+    file->cacheKey = cacheKey;
+    file->bodies.resize(chunks.size());
+    file->errors.resize(chunks.size());
+    file->stats = stats;
+    if (stats) file->chunkStats.resize(chunks.size());
+    file->remaining = chunks.size();
+
+    uint64_t chunkCost = job.sizeBytes / chunks.size();
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        auto tokens = std::make_shared<TokenBuffer>(std::move(chunks[c]));
+        scheduler.spawn(worker, {chunkCost, [file, tokens, c, &error](unsigned) {
+            TraceSpan span("chunk", Trace::enabled() ? file->job->inputPath + " #" + std::to_string(c) : "");
+            try {
+                FileStats* chunkStats = file->stats ? &file->chunkStats[c] : nullptr;
+                file->bodies[c] = generateChunk(std::move(*tokens), file->className, chunkStats);
+            } catch (const std::exception& ex) {
+                file->errors[c] = ex.what();
+            }
+            *tokens = TokenBuffer();   // Drop the chunk's hold on the source now, not when the task is destroyed
+            if (--file->remaining == 0) {
+                try {
+                    finishSplitFile(*file, error);
+                } catch (const std::exception& ex) {
+                    error = ex.what();
+                }
+            }
+        }});
+    }
+}
+
+} // unnamed namespace
+
+int runBatch(const BatchOptions& options) {
+    std::vector<BatchJob> jobs = collectBatchJobs(options);
+    if (jobs.empty()) {
+        std::cerr << "Error: No .cpp files found in '" << options.input << "'\n";
+        return 1;
+    }
+
+    unsigned workers = options.jobs ? options.jobs : std::thread::hardware_concurrency();
+    if (workers == 0) workers = 1;
+    // More workers than files only helps when some file is big enough to be split
+    bool anySplittable = options.splitBytes && std::any_of(jobs.begin(), jobs.end(),
+        [&](const BatchJob& job) { return job.sizeBytes >= options.splitBytes; });
+    if (!anySplittable) workers = std::min<unsigned>(workers, static_cast<unsigned>(jobs.size()));
+
+    // Batch runs only produce the .java files; no console echo or per-file logs
+    PipelineOptions pipeline;
+    pipeline.verbose = false;
+    pipeline.cache = options.cache;
+    pipeline.headers = options.headers;
+    pipeline.prelude = options.prelude;
+
+    if (options.stats) {
+        options.stats->assign(jobs.size(), FileStats());
+        for (size_t i = 0; i < jobs.size(); ++i) (*options.stats)[i].path = jobs[i].inputPath;
+    }
+
+    WorkStealingScheduler scheduler(workers);
+    std::vector<std::string> errors(jobs.size());
+    std::vector<SchedulerTask> tasks;
+    tasks.reserve(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BatchJob& job = jobs[i];
+        std::error_code ec;
+        fs::create_directories(fs::path(job.outputPath).parent_path(), ec);
+        // Splitting only pays off when another worker can pick up the pieces
+        bool split = workers > 1 && options.splitBytes && job.sizeBytes >= options.splitBytes;
+        tasks.push_back({job.sizeBytes, [&, i, split](unsigned worker) {
+            FileStats* stats = options.stats ? &(*options.stats)[i] : nullptr;
+            try {
+                if (split) {
+                    transpileSplit(scheduler, worker, jobs[i], options.cache, options.headers, options.prelude, stats,
+                                   errors[i]);
+                } else {
+                    PipelineOptions fileOptions = pipeline;
+                    fileOptions.stats = stats;
+                    transpileFile(jobs[i].inputPath, jobs[i].outputPath, fileOptions);
+                }
+            } catch (const std::exception& ex) {
+                errors[i] = ex.what();
+            }
+        }});
+    }
+    scheduler.submit(std::move(tasks));
+    scheduler.run();
+
+    size_t failed = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (errors[i].empty()) continue;
+        std::cerr << "Error: " << jobs[i].inputPath << ": " << errors[i] << "\n";
+        ++failed;
+    }
+    std::cout << "Batch: " << (jobs.size() - failed) << "/" << jobs.size() << " files transpiled into "
+              << options.outputRoot << " using " << workers << " worker(s) in "
+              << scheduler.wallSeconds() << "s\n";
+    scheduler.printUtilisation(std::cout);
+    return failed ? 1 : 0;
+}
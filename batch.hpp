@@ -0,0 +1,39 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ResultCache;
+class HeaderCache;
+class Prelude;
+struct FileStats;
+
+// Options for --batch mode
+struct BatchOptions {
+    std::string input;                 // Directory to scan, or a file listing one source path per line
+    std::string outputRoot = "OUTPUT"; // Root the input tree is mirrored into
+    unsigned jobs = 0;                 // Worker threads (0: hardware concurrency)
+    uint64_t splitBytes = 256 * 1024;  // Files at least this big are split into per-declaration subtasks (0: never)
+    ResultCache* cache = nullptr;      // On-disk result cache shared by all workers (null: disabled)
+    HeaderCache* headers = nullptr;    // Header cache shared by all workers (null: includes are not followed)
+    const Prelude* prelude = nullptr;  // Preprocessor state every file starts from (null: none)
+    std::vector<FileStats>* stats = nullptr; // Receives one entry per file for --stats (null: not collected)
+};
+
+// One source file scheduled for transpilation
+struct BatchJob {
+    std::string inputPath;
+    std::string outputPath;            // <outputRoot>/<relative dir>/<base>.java
+    uint64_t sizeBytes = 0;            // Input size, used to schedule the largest files first
+};
+
+// Expand options.input into the list of jobs; throws std::runtime_error if it cannot be read
+std::vector<BatchJob> collectBatchJobs(const BatchOptions& options);
+
+// Transpile every discovered file on a work-stealing worker pool and print per-worker
+// utilisation. Returns 0 if all files succeeded, 1 otherwise.
+int runBatch(const BatchOptions& options);
+
+#endif // BATCH_HPP
@@ -0,0 +1,142 @@
+// Benchmark: lexing a platform header that is 90% code under #ifdef _WIN32, which is dead
+// here. Checks that the tokens equal those of the same header with the dead lines blanked
+// out, then reports how fast the dead code is skipped. Standalone; see README for the build line.
+#include "lexer.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+// Dead-code lines with everything the skip must not trip over: quotes, comments, '#' that
+// does not start a directive, nested groups and directives other than #if/#else/#endif
+const char* const kDeadLines[] = {
+    "typedef struct _WIN_HANDLE_%d { void* unused; } *HANDLE_%d;\n",
+    "WINAPI BOOL CloseHandle_%d(HANDLE hObject); /* \"quoted\" and 'single */\n",
+    "static const char* path_%d = \"C:\\\\Windows\\\\System32\"; // it's # not a directive\n",
+    "#define WIN_FLAG_%d (1 << %d)\n",
+    "#  if defined(_M_X64) && WINVER > %d\n  typedef __int64 LONG_PTR_%d;\n#  else\n  typedef long LONG_PTR_%d;\n#  endif\n",
+    "#pragma comment(lib, \"kernel32_%d.lib\")\n",
+    "  x = a # b; y = '#'; z = \"#endif\";   // %d\n",
+    "#include <windows_%d.h>\n",
+    "#define SPLICED_%d \\\n#endif\n",
+    "/* disabled %d:\n#endif\n#else\n*/ int commented_%d;\n",
+    "static const char* open_%d = \"/*\"; // see /* here\n#pragma pack(%d)\n",
+    "#error don't use /* with %d\n",
+};
+
+const char* const kLiveLines[] = {
+    "int posix_value_%d = %d;\n",
+    "static inline long posix_call_%d(long x) { return x + %d; }\n",
+};
+
+// Header with about deadShare of its bytes in #ifdef _WIN32 groups; blanked has the same
+// lines, with those of the dead groups (and their directives) left empty
+void makeHeader(size_t targetBytes, double deadShare, std::string& header, std::string& blanked) {
+    std::mt19937 rng(11);
+    char line[512];
+    int n = 0;
+    size_t deadBytes = 0;
+    auto add = [&](const std::string& text, bool dead) {
+        header += text;
+        if (!dead) {
+            blanked += text;
+            return;
+        }
+        deadBytes += text.size();
+        for (char c : text) {
+            if (c == '\n') blanked += '\n';
+        }
+    };
+    while (header.size() < targetBytes) {
+        if (header.empty() || deadBytes < deadShare * header.size()) {
+            add("#ifdef _WIN32\n", true);
+            for (int i = 0; i < 40; ++i) {
+                const char* pattern = kDeadLines[rng() % (sizeof(kDeadLines) / sizeof(kDeadLines[0]))];
+                std::snprintf(line, sizeof(line), pattern, n, n, n);
+                add(line, true);
+                ++n;
+            }
+            add("#endif // _WIN32\n", true);
+        } else {
+            const char* pattern = kLiveLines[rng() % (sizeof(kLiveLines) / sizeof(kLiveLines[0]))];
+            std::snprintf(line, sizeof(line), pattern, n, n);
+            add(line, false);
+            ++n;
+        }
+    }
+}
+
+bool sameTokens(const TokenBuffer& a, const TokenBuffer& b) {
+    // The blanked header has no directives, so its tokens must equal a's minus directives
+    size_t j = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].type() == TokenType::HASH) {
+            // HASH, directive keyword, optional argument: the #ifdef/#endif pair of a dead group
+            i += a[i + 1].type() == TokenType::PREPROCESSOR_IFDEF ? 2 : 1;
+            continue;
+        }
+        if (j >= b.size() || a[i].type() != b[j].type() || a[i].text() != b[j].text() ||
+            a[i].line() != b[j].line() || a[i].column() != b[j].column()) {
+            std::fprintf(stderr, "token %zu differs: %s\n", i, a[i].toString().c_str());
+            return false;
+        }
+        ++j;
+    }
+    return j == b.size();
+}
+
+// An #endif inside a block comment of a dead group does not close the group
+bool commentHidesEndif() {
+    Logger::Capture warnings(LogCategory::Lexer);
+    TokenBuffer tokens = Lexer("#if 0\n/*\n#endif\n*/\nint a;\n#endif\nint b;\n").tokenize();
+    std::string live;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].type() == TokenType::IDENTIFIER || tokens[i].type() == TokenType::STAR) {
+            live += std::string(tokens[i].text()) + " ";
+        }
+    }
+    if (live != "b " || !warnings.messages().empty()) {
+        std::fprintf(stderr, "comment in a dead group: live tokens \"%s\", %zu warnings\n", live.c_str(),
+                     warnings.messages().size());
+        return false;
+    }
+    return true;
+}
+
+template <typename Lex>
+double bestSeconds(Lex lex) {
+    double best = 1e30;
+    for (int round = 0; round < 5; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        lex();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+} // unnamed namespace
+
+int main() {
+    std::string header;
+    std::string blanked;
+    makeHeader(32 << 20, 0.9, header, blanked);
+    if (!commentHidesEndif() || !sameTokens(Lexer(header).tokenize(), Lexer(blanked).tokenize())) return 1;
+    std::printf("disabled regions: tokens identical to the blanked header\n");
+
+    double mb = header.size() / 1e6;
+    double skipping = bestSeconds([&] { return Lexer(header).tokenize(); });
+    double live = bestSeconds([&] { return Lexer(blanked).tokenize(); });
+    std::string enabled = "#define _WIN32\n" + header;
+    double all = bestSeconds([&] { return Lexer(enabled).tokenize(); });
+    std::printf("%.0f MB header, 90%% under #ifdef _WIN32\n", mb);
+    std::printf("  _WIN32 undefined:        %8.1f MB/s\n", mb / skipping);
+    std::printf("  live lines only:         %8.1f MB/s of the header (%.2fx the skip's cost)\n", mb / live,
+                live / skipping);
+    std::printf("  _WIN32 defined (no skip):%8.1f MB/s\n", mb / all);
+    std::printf("  dead code skipped at     %8.1f MB/s\n", 0.9 * mb / std::max(skipping - live, 1e-9));
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Microbenchmark: perfect-hash keyword lookup (keywords.hpp) against the
+// unordered_map<std::string, TokenType> it replaced. Standalone; see README for the build line.
+#include "keywords.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Identifiers that are not keywords, several sharing a length and end bytes with one
+const char* const kPlainIdentifiers[] = {
+    "i", "j", "n", "x", "it", "id", "idx", "len", "size", "count", "value", "result", "buffer",
+    "node", "left", "right", "parent", "index", "total", "vec", "matrix", "stream", "reader",
+    "swap", "sort", "find", "sqrt", "printf", "strlen", "main", "argc", "argv", "self", "other",
+    "maps", "sets", "stacks", "strings", "intx", "iff", "dob", "cases", "cinx", "couts",
+    "unordered_mapx", "priorityqueue", "lexer_state", "tokenStartPos", "JavaCodeGenerator",
+};
+
+template <typename Lookup>
+double nsPerLookup(const std::vector<std::string>& words, int rounds, Lookup lookup, unsigned& checksum) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& word : words) checksum += static_cast<unsigned>(lookup(word));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / (double(words.size()) * rounds);
+}
+
+} // unnamed namespace
+
+int main() {
+    std::unordered_map<std::string, TokenType> map;
+    for (const auto& keyword : kKeywords) map.emplace(std::string(keyword.text), keyword.type);
+    auto mapLookup = [&map](const std::string& word) {
+        auto it = map.find(word);
+        return it == map.end() ? TokenType::IDENTIFIER : it->second;
+    };
+
+    // Source-like mix: roughly one identifier in three is a keyword
+    std::vector<std::string> words;
+    std::mt19937 rng(42);
+    for (int i = 0; i < 4096; ++i) {
+        if (rng() % 3 == 0) {
+            words.emplace_back(kKeywords[rng() % keyword_hash::kKeywordCount].text);
+        } else {
+            words.emplace_back(kPlainIdentifiers[rng() % (sizeof(kPlainIdentifiers) / sizeof(kPlainIdentifiers[0]))]);
+        }
+    }
+
+    for (const auto& word : words) {
+        if (lookupKeyword(word) != mapLookup(word)) {
+            std::fprintf(stderr, "mismatch for '%s'\n", word.c_str());
+            return 1;
+        }
+    }
+
+    const int rounds = 2000;
+    unsigned checksum = 0;
+    double perfect = nsPerLookup(words, rounds, [](const std::string& w) { return lookupKeyword(w); }, checksum);
+    double hashed = nsPerLookup(words, rounds, mapLookup, checksum);
+    std::printf("%zu keywords, %d-slot table\n", keyword_hash::kKeywordCount, int(keyword_hash::kTableSize));
+    std::printf("perfect hash:  %6.2f ns/lookup\n", perfect);
+    std::printf("unordered_map: %6.2f ns/lookup (%.1fx slower)\n", hashed, hashed / perfect);
+    std::printf("checksum %u\n", checksum);
+    return 0;
+}
@@ -0,0 +1,251 @@
+// Benchmark: Lexer::tokenize throughput on synthetic corpora, each heavy in one kind of
+// token (identifiers, operators, comments, literals, preprocessor directives) plus a mix,
+// or on given files. Reports MB/s, tokens/s, heap allocations per token and cycles per byte.
+// Standalone; see README for the build line.
+#include "lexer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#endif
+
+// --- Heap allocation counting (as in stats.cpp, which this does not link) ---
+
+namespace {
+uint64_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++allocationCount;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+// --- Synthetic corpora ---
+// Each line is a printf pattern given the line number (as often as it has %d); every line
+// is complete on its own, so a corpus can be cut after any of them.
+
+struct CorpusKind {
+    const char* name;
+    std::vector<const char*> lines;
+};
+
+const std::vector<CorpusKind>& corpusKinds() {
+    static const std::vector<CorpusKind> kinds = {
+        {"identifiers", {
+            "static unsigned long long request_counter_%d = initial_request_count + offset_%d;\n",
+            "const std::vector<std::string>& configuration_entries_%d = registry.lookup(section_name, key_%d);\n",
+            "template <typename Container> inline auto first_element_%d(const Container& items) { return items.front(); }\n",
+            "virtual bool handle_incoming_message_%d(MessageHeader header, PayloadBuffer payload) override;\n",
+            "namespace service_layer_%d { using connection_pool_type = pool_allocator<connection_handle>; }\n",
+        }},
+        {"operators", {
+            "x%d = (a << 2) | (b >> 3) & ~c ^ d; p->q.r[i++] -= --j * k / l %% m;\n",
+            "if (a%d <= b && c >= d || e != f) { g <<= h; i >>= j; k &= l; m |= n; o ^= p; }\n",
+            "r%d = s ? t->*u : v.*w; x += y; z -= a; b *= c; d /= e; f %%= g;\n",
+            "std::cout << (a%d <=> b) << !c << (d == e) << (f < g) << (h > i);\n",
+            "auto f%d = [&](int* p, int& q) -> int { return *p++ + q-- - ::global; };\n",
+        }},
+        {"comments", {
+            "// Line comment %d: explains what the next declaration is for, in some detail.\n",
+            "/* Block comment %d on one line, with \"quotes\" and 'apostrophes' inside. */\n",
+            "/**\n * Doxygen block %d.\n * @param value  the input, which must not be negative\n * @return the adjusted value\n */\n",
+            "int commented_%d = 1;   // trailing comment after a short declaration\n",
+            "    /* indented block comment %d\n       spanning two lines */\n",
+        }},
+        {"literals", {
+            "const char* message_%d = \"a string literal with \\\"escapes\\\" \\t\\n and some length\";\n",
+            "int values_%d[] = { 0x1F2E3D4C, 0b1011'0110, 1'000'000, 0777, 42u, 42ull };\n",
+            "double ratios_%d[] = { 3.14159, 2.5e-3, .125f, 6.02e23L, 1e10, 0x1.8p3 };\n",
+            "char chars_%d[] = { 'a', '\\n', '\\'', '\\\\', '\"', '0' };\n",
+            "auto raw_%d = R\"delim(raw string with \"quotes\" and \\backslashes)delim\";\n",
+        }},
+        {"preprocessor", {
+            "#define CONFIG_VALUE_%d (%d * 4 + 1)\n",
+            "#ifdef FEATURE_ENABLED_%d\nint feature_%d = 1;\n#else\nint feature_%d = 0;\n#endif\n",
+            "#if CONFIG_VALUE_%d > 10 && defined(CONFIG_VALUE_%d)\nint big_%d = CONFIG_VALUE_%d;\n#endif\n",
+            "#define SQUARE_%d(x) ((x) * (x))\nint squared_%d = SQUARE_%d(3);\n#undef SQUARE_%d\n",
+            "#pragma pack(push, %d)\n#include <header_%d.h>\n#pragma pack(pop)\n",
+        }},
+    };
+    return kinds;
+}
+
+std::string generate(const std::vector<const char*>& lines, size_t targetBytes) {
+    std::mt19937 rng(7);
+    std::string out;
+    out.reserve(targetBytes + 512);
+    char line[512];
+    for (int n = 0; out.size() < targetBytes; ++n) {
+        const char* pattern = lines[rng() % lines.size()];
+        std::snprintf(line, sizeof(line), pattern, n, n, n, n, n, n);
+        out += line;
+    }
+    return out;
+}
+
+struct Corpus {
+    std::string name;
+    std::string text;
+};
+
+// Every kind's lines, interleaved
+Corpus mixedCorpus(size_t targetBytes) {
+    std::vector<const char*> all;
+    for (const auto& kind : corpusKinds()) all.insert(all.end(), kind.lines.begin(), kind.lines.end());
+    return {"mixed", generate(all, targetBytes)};
+}
+
+// --- Measurement ---
+
+struct Result {
+    double seconds = 1e30;   // Best round
+    uint64_t cycles = 0;     // Time-stamp counter ticks of the best round (0: not available)
+    uint64_t tokens = 0;
+    uint64_t allocations = 0;
+};
+
+uint64_t readCycles() {
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+Result measure(const std::string& text, int rounds) {
+    Result result;
+    for (int round = 0; round < rounds; ++round) {
+        uint64_t allocationsBefore = allocationCount;
+        uint64_t cyclesBefore = readCycles();
+        auto start = std::chrono::steady_clock::now();
+        TokenBuffer tokens = Lexer(text).tokenize();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t cycles = readCycles() - cyclesBefore;
+        uint64_t allocations = allocationCount - allocationsBefore;
+        if (seconds < result.seconds) {
+            result.seconds = seconds;
+            result.cycles = cycles;
+            result.tokens = tokens.size();
+            result.allocations = allocations;
+        }
+    }
+    return result;
+}
+
+// "64K", "16M", "1G" or a plain byte count; 0 if it is not a size
+size_t parseSize(const char* text) {
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || value <= 0) return 0;
+    switch (*end) {
+        case 'k': case 'K': value *= 1e3; break;
+        case 'm': case 'M': value *= 1e6; break;
+        case 'g': case 'G': value *= 1e9; break;
+        case '\0': break;
+        default: return 0;
+    }
+    return static_cast<size_t>(value);
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [--size N[K|M|G]] [--kind identifiers,operators,comments,literals,preprocessor,mixed]\n"
+                 "          [--rounds N] [file...]\n"
+                 "Without files, lexes one synthetic corpus of each kind (default 4M each, best of 3 rounds).\n",
+                 program);
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[]) {
+    size_t size = 4000000;
+    int rounds = 3;
+    std::string kinds;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue) {
+            size = parseSize(argv[++i]);
+            if (size == 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--kind" && hasValue) {
+            kinds = argv[++i];
+        } else if (arg == "--rounds" && hasValue) {
+            rounds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg.rfind("--", 0) == 0) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    std::vector<Corpus> corpora;
+    for (const auto& path : files) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::fprintf(stderr, "cannot read %s\n", path.c_str());
+            return 1;
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        corpora.push_back({path, buffer.str()});
+    }
+    if (files.empty()) {
+        auto wanted = [&kinds](const std::string& name) {
+            return kinds.empty() || ("," + kinds + ",").find("," + name + ",") != std::string::npos;
+        };
+        for (const auto& kind : corpusKinds()) {
+            if (wanted(kind.name)) corpora.push_back({kind.name, generate(kind.lines, size)});
+        }
+        if (wanted("mixed")) corpora.push_back(mixedCorpus(size));
+        if (corpora.empty()) {
+            std::fprintf(stderr, "no corpus kind matches '%s'\n", kinds.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("%-14s %10s %9s %10s %10s %9s %9s\n", "corpus", "MB", "MB/s", "Mtokens/s", "bytes/tok",
+                "alloc/tok", "cycles/B");
+    for (const auto& corpus : corpora) {
+        Result result = measure(corpus.text, rounds);
+        double bytes = static_cast<double>(corpus.text.size());
+        double tokens = static_cast<double>(std::max<uint64_t>(result.tokens, 1));
+        char cycles[32] = "-";
+        if (result.cycles) std::snprintf(cycles, sizeof(cycles), "%.1f", result.cycles / bytes);
+        std::printf("%-14s %10.2f %9.1f %10.2f %10.1f %9.3f %9s\n", corpus.name.c_str(), bytes / 1e6,
+                    bytes / 1e6 / result.seconds, tokens / 1e6 / result.seconds, bytes / tokens,
+                    result.allocations / tokens, cycles);
+    }
+#ifdef BENCH_HAS_TSC
+    std::printf("cycles are time-stamp counter ticks, which run at the nominal clock rate\n");
+#endif
+    return 0;
+}
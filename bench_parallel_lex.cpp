@@ -0,0 +1,171 @@
+// Differential check and benchmark: Lexer::tokenizeParallel against Lexer::tokenize.
+// Standalone; see README for the build line. With no arguments a synthetic corpus is used;
+// otherwise each argument is a source file to check.
+#include "lexer.hpp"
+#include "header_cache.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Lines that end constructs in every way the split scan has to agree with the lexer on
+const char* const kLines[] = {
+    "int table_%d[] = { 1, 2, 3, 0x1F, 1'000'000, 3.5e+2f, .25, 0b1010 };\n",
+    "static const char* s%d = \"text with \\\"quotes\\\" and // not a comment\";\n",
+    "char c%d = '\\''; char d%d = '\"'; char e%d = '/';\n",
+    "/* block comment %d\n   spanning \"lines\" with ' quotes\n*/ int after%d = 1;\n",
+    "// line comment %d with a splice \\\n   still the comment\n",
+    "auto raw%d = R\"x(raw \"string\" over\n two lines // )\" not the end)x\";\n",
+    "const char* spliced%d = \"a string \\\n continued\";\n",
+    "char splicedChar%d = 'x\\\ny';\n",
+    "int sum%d = a \\\n + b;   // splice between tokens\n",
+    "x%d = y / z /* inline */ - w // tail\n",
+    "u8\"utf8 %d\"; L\"wide\"; LR\"(raw\nwide)\"; U'c';\n",
+    "if (a%d < b && c >= d || e != f) { g <<= 2; h->i::j; }\n",
+    "VALUE + LIMIT(%d) - EMPTY;\n",
+    "LOG(\"%d\", NAME(x, %d), LIMIT(LIMIT(1)));\n",
+    "int fn%d = LIMIT\n   (2) + LIMIT;\n",
+    "  \t\r\n",
+};
+
+std::string syntheticCorpus(size_t targetBytes) {
+    std::string out =
+        "#include <vector>\n"
+        "#define VALUE 42\n"
+        "#define EMPTY\n"
+        "#define LIMIT(n) ((n) * 2)\n"
+        "#define NAME(a, b) a ## b\n"
+        "#define LOG(fmt, ...) log(#fmt, fmt, __VA_ARGS__)\n"
+        "#if VALUE > 40\n"
+        "#define BIG 1\n"
+        "#else\n"
+        "int skipped = \"unterminated;\n"
+        "#endif\n";
+    std::mt19937 rng(7);
+    char line[512];
+    int n = 0;
+    while (out.size() < targetBytes) {
+        const char* pattern = kLines[rng() % (sizeof(kLines) / sizeof(kLines[0]))];
+        std::snprintf(line, sizeof(line), pattern, n, n, n);
+        out += line;
+        ++n;
+    }
+    return out;
+}
+
+bool sameTokens(const TokenBuffer& a, const TokenBuffer& b, const std::string& label) {
+    if (a.size() != b.size()) {
+        std::fprintf(stderr, "%s: %zu tokens sequentially, %zu in parallel\n", label.c_str(), a.size(), b.size());
+    }
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+        const Token& x = a[i];
+        const Token& y = b[i];
+        if (x.type() != y.type() || x.text() != y.text() || x.line() != y.line() ||
+            x.column() != y.column() || x.symbol() != y.symbol()) {
+            std::fprintf(stderr, "%s: token %zu differs:\n  sequential %s\n  parallel   %s\n", label.c_str(), i,
+                         x.toString().c_str(), y.toString().c_str());
+            return false;
+        }
+    }
+    return a.size() == b.size();
+}
+
+// Compare with small chunks and several thread counts, so many split points are exercised
+bool check(const std::string& source, const std::string& label) {
+    TokenBuffer expected = Lexer(source).tokenize();
+    for (unsigned jobs : {2u, 3u, 8u}) {
+        for (size_t chunk : {size_t(256), size_t(4096)}) {
+            TokenBuffer actual = Lexer(source).tokenizeParallel(jobs, chunk);
+            if (!sameTokens(expected, actual, label + " jobs=" + std::to_string(jobs) + " chunk=" + std::to_string(chunk))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Macros from an #include and from a restored prelude must survive when the parallel lexer
+// falls back to lexing in order: F at the end of the prefix looks for its '(' past the cut.
+bool contextCheck() {
+    const char* const definitions = "#define G 42\n#define F(x) (x + G)\n";
+    std::string uses;
+    for (int i = 0; i < 2000; ++i) uses += "int u" + std::to_string(i) + " = G + F(" + std::to_string(i) + ");\n";
+    // The long line puts the first split point after the directive right behind F
+    std::string body = uses + "#undef UNUSED\nint last =" + std::string(300, ' ') + "F\n(G);\n" + uses;
+
+    fs::path dir = fs::temp_directory_path() / "bench_parallel_lex";
+    fs::create_directories(dir);
+    std::ofstream(dir / "g.h") << definitions;
+    std::string includer = (dir / "main.cpp").string();
+    std::string included = "#include \"g.h\"\n" + body;
+    HeaderCache headers;
+    auto withInclude = [&](bool parallel) {
+        Lexer lexer(included);
+        lexer.enableIncludes(headers, includer);
+        return parallel ? lexer.tokenizeParallel(4, 4096) : lexer.tokenize();
+    };
+    bool ok = sameTokens(withInclude(false), withInclude(true), "include");
+    fs::remove_all(dir);
+
+    Lexer prelude(definitions);
+    prelude.tokenize();
+    PreprocessorState state = prelude.saveState();
+    auto withPrelude = [&](bool parallel) {
+        Lexer lexer(body);
+        lexer.restoreState(state);
+        return parallel ? lexer.tokenizeParallel(4, 4096) : lexer.tokenize();
+    };
+    return sameTokens(withPrelude(false), withPrelude(true), "prelude") && ok;
+}
+
+template <typename Lex>
+double seconds(Lex lex, size_t& tokens) {
+    auto start = std::chrono::steady_clock::now();
+    tokens = lex().size();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            std::ifstream file(argv[i], std::ios::binary);
+            if (!file) {
+                std::fprintf(stderr, "cannot open %s\n", argv[i]);
+                return 1;
+            }
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            if (!check(buffer.str(), argv[i])) return 1;
+            std::printf("%s: identical\n", argv[i]);
+        }
+        return 0;
+    }
+
+    if (!check(syntheticCorpus(256 * 1024), "synthetic")) return 1;
+    std::printf("synthetic corpus: identical\n");
+    if (!contextCheck()) return 1;
+    std::printf("include and prelude: identical\n");
+
+    std::string big = syntheticCorpus(64 << 20);
+    size_t sequentialTokens = 0;
+    size_t parallelTokens = 0;
+    double sequential = seconds([&] { return Lexer(big).tokenize(); }, sequentialTokens);
+    double mb = big.size() / 1e6;
+    std::printf("%.0f MB, %zu tokens\n", mb, sequentialTokens);
+    std::printf("tokenize:           %7.1f MB/s\n", mb / sequential);
+    for (unsigned jobs : {2u, 4u, 8u}) {
+        double parallel = seconds([&] { return Lexer(big).tokenizeParallel(jobs); }, parallelTokens);
+        std::printf("tokenizeParallel(%u): %6.1f MB/s (%.2fx)\n", jobs, mb / parallel, sequential / parallel);
+    }
+    return parallelTokens == sequentialTokens ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+// Benchmark: many small files that all start from the same large prelude of #defines.
+// Checks that macros read back from the header cache's and the prelude's disk entries are the
+// macros that were written, that header variants follow #pragma once skips, and that each file lexed from the prelude's saved state gives the tokens it gives
+// with the prelude pasted in front, then reports the per-file cost of pasting it in front,
+// #including it through the header cache and restoring its state. Standalone; see README
+// for the build line.
+#include "header_cache.hpp"
+#include "lexer.hpp"
+#include "log.hpp"
+#include "prelude.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kMacros = 3000;
+constexpr int kFiles = 400;
+
+std::string makePrelude() {
+    std::string text = "#pragma once\n";
+    char line[256];
+    for (int i = 0; i < kMacros; ++i) {
+        if (i % 3 == 0) {
+            std::snprintf(line, sizeof(line), "#define CONFIG_FLAG_%d (1u << %d)\n", i, i % 32);
+        } else if (i % 3 == 1) {
+            std::snprintf(line, sizeof(line), "#define CHECKED_CALL_%d(f, ...) do { if (!(f)(__VA_ARGS__)) fail(%d); } while (0)\n", i, i);
+        } else {
+            std::snprintf(line, sizeof(line), "#ifndef LIMIT_%d\n#define LIMIT_%d %d\n#endif\n", i, i, i * 7);
+        }
+        text += line;
+    }
+    return text;
+}
+
+std::string makeFile(int n) {
+    std::string text;
+    char line[256];
+    for (int i = 0; i < 20; ++i) {
+        int m = (n * 31 + i * 7) % kMacros;
+        std::snprintf(line, sizeof(line), "int value_%d_%d = CONFIG_FLAG_%d + LIMIT_%d;\n", n, i, m - m % 3,
+                      m - m % 3 + 2);
+        text += line;
+    }
+    return text;
+}
+
+// Types and texts of a's tokens after the first skip ones equal b's
+bool sameTokens(const TokenBuffer& a, size_t skip, const TokenBuffer& b) {
+    if (a.size() - skip != b.size()) return false;
+    for (size_t i = 0; i < b.size(); ++i) {
+        if (a[skip + i].type() != b[i].type() || a[skip + i].text() != b[i].text()) return false;
+    }
+    return true;
+}
+
+// Object-like bodies starting with '(' next to function-like and empty macros
+const char kParenMacros[] =
+    "#define ZERO (zero)\n#define FOUR (4)\n#define TWICE(x) ((x) * 2)\n#define EMPTY\n";
+const char kParenUses[] = "int a = ZERO + FOUR + TWICE(3) EMPTY;\n";
+
+// A header's macros lexed fresh and loaded from its disk entry in a later "run" must expand
+// alike, and the entry must load without being reported as damaged
+bool headerEntriesRoundTrip(const fs::path& dir) {
+    fs::remove_all(dir / "cache");
+    std::ofstream((dir / "paren.h").string()) << kParenMacros;
+    std::string file = std::string("#include \"paren.h\"\n") + kParenUses;
+    std::string includer = (dir / "paren.cpp").string();
+    auto lex = [&] {
+        HeaderCache headers({}, (dir / "cache").string());
+        Lexer lexer(file);
+        lexer.enableIncludes(headers, includer);
+        return lexer.tokenize();
+    };
+    TokenBuffer cold = lex();
+    Logger::Capture warnings(LogCategory::Lexer);
+    TokenBuffer warm = lex();
+    return warnings.messages().empty() && sameTokens(cold, 0, warm);
+}
+
+// The same for a prelude's saved state: the warm run must load it from disk
+bool preludeStatesRoundTrip(const fs::path& dir) {
+    fs::remove_all(dir / "cache");
+    std::string path = (dir / "paren_prelude.h").string();
+    std::ofstream(path) << kParenMacros;
+    auto lex = [&](bool& fromDisk) {
+        HeaderCache headers;
+        Prelude prelude(path, headers, (dir / "cache").string());
+        fromDisk = prelude.fromDisk();
+        Lexer lexer(kParenUses);
+        lexer.restoreState(prelude.state());
+        return lexer.tokenize();
+    };
+    bool coldFromDisk = true;
+    bool warmFromDisk = false;
+    TokenBuffer cold = lex(coldFromDisk);
+    TokenBuffer warm = lex(warmFromDisk);
+    return !coldFromDisk && warmFromDisk && sameTokens(cold, 0, warm);
+}
+
+// A header variant lexed while a nested #pragma once header was skipped, or while it was
+// included, must not be reused in a file where the opposite holds: each file lexed after the
+// other through one header cache must give the tokens it gives with a cache of its own
+bool onceVariants(const fs::path& dir) {
+    std::ofstream((dir / "once_a.h").string()) << "#pragma once\n#define A 1\n";
+    std::ofstream((dir / "once_b.h").string()) << "#include \"once_a.h\"\n#define B 2\n";
+    const std::string both = "#include \"once_a.h\"\n#include \"once_b.h\"\nint one() { return A + B; }\n";
+    const std::string onlyB = "#include \"once_b.h\"\nint yes() { return A + B; }\n";
+    std::string includer = (dir / "once.cpp").string();
+    auto lex = [&](HeaderCache& headers, const std::string& file) {
+        Lexer lexer(file);
+        lexer.enableIncludes(headers, includer);
+        return lexer.tokenize();
+    };
+    for (const auto& order : {std::make_pair(both, onlyB), std::make_pair(onlyB, both)}) {
+        HeaderCache shared;
+        lex(shared, order.first);
+        HeaderCache own;
+        if (!sameTokens(lex(shared, order.second), 0, lex(own, order.second))) return false;
+    }
+    return true;
+}
+
+template <typename Lex>
+double bestSeconds(Lex lex) {
+    double best = 1e30;
+    for (int round = 0; round < 5; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        lex();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+} // unnamed namespace
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / "bench_prelude";
+    fs::create_directories(dir);
+    std::string preludePath = (dir / "prelude.h").string();
+    std::string preludeText = makePrelude();
+    std::ofstream(preludePath) << preludeText;
+    std::vector<std::string> files;
+    for (int n = 0; n < kFiles; ++n) files.push_back(makeFile(n));
+
+    if (!headerEntriesRoundTrip(dir)) {
+        std::fprintf(stderr, "macros loaded from a header cache entry differ from the header's\n");
+        return 1;
+    }
+    std::printf("header cache entries: macros identical after a disk round trip\n");
+    if (!onceVariants(dir)) {
+        std::fprintf(stderr, "a header variant was reused across different #pragma once states\n");
+        return 1;
+    }
+    std::printf("header cache variants: #pragma once skips respected\n");
+    if (!preludeStatesRoundTrip(dir)) {
+        std::fprintf(stderr, "macros loaded from a saved prelude state differ from the prelude's\n");
+        return 1;
+    }
+    std::printf("prelude states: macros identical after a disk round trip\n");
+
+    HeaderCache headers;
+    Prelude prelude(preludePath, headers);
+    size_t preludeTokens = Lexer(preludeText).tokenize().size() - 1;   // Without END_OF_FILE
+    for (const auto& file : files) {
+        std::string pasted = preludeText + file;
+        Lexer lexer(file);
+        lexer.restoreState(prelude.state());
+        if (!sameTokens(Lexer(pasted).tokenize(), preludeTokens, lexer.tokenize())) {
+            std::fprintf(stderr, "tokens differ from the pasted prelude's\n");
+            return 1;
+        }
+    }
+    std::printf("prelude state: tokens identical to the prelude pasted in front (%zu macros)\n",
+                prelude.state().macros->size());
+
+    std::vector<std::string> pasted;
+    std::vector<std::string> included;
+    for (const auto& file : files) {
+        pasted.push_back(preludeText + file);
+        included.push_back("#include \"prelude.h\"\n" + file);
+    }
+    std::string includer = (dir / "file.cpp").string();
+    double pasting = bestSeconds([&] {
+        for (const auto& text : pasted) Lexer(text).tokenize();
+    });
+    double including = bestSeconds([&] {
+        for (const auto& text : included) {
+            Lexer lexer(text);
+            lexer.enableIncludes(headers, includer);
+            lexer.tokenize();
+        }
+    });
+    double restoring = bestSeconds([&] {
+        for (const auto& file : files) {
+            Lexer lexer(file);
+            lexer.restoreState(prelude.state());
+            lexer.tokenize();
+        }
+    });
+    double alone = bestSeconds([&] {
+        for (const auto& file : files) Lexer(file).tokenize();
+    });
+    std::printf("%d files of %zu bytes after a %zu byte prelude, per file:\n", kFiles, files[0].size(),
+                preludeText.size());
+    std::printf("  prelude pasted in front:   %8.1f us\n", 1e6 * pasting / kFiles);
+    std::printf("  #include through the cache:%8.1f us\n", 1e6 * including / kFiles);
+    std::printf("  prelude state restored:    %8.1f us\n", 1e6 * restoring / kFiles);
+    std::printf("  file alone, no macros:     %8.1f us\n", 1e6 * alone / kFiles);
+    fs::remove_all(dir);
+    return 0;
+}
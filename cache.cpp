@@ -0,0 +1,148 @@
+#include "cache.hpp"
+#include "hash.hpp"
+#include "version.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// First line of every entry; the key inputs and then the Java follow
+const char kMagic[] = "transpiler-result 1\n";
+// Seed of the second source hash stored in entries (any value other than FNV's offset basis)
+constexpr uint64_t kSecondSeed = 0x9e3779b97f4a7c15ULL;
+
+} // unnamed namespace
+
+ResultCache::ResultCache(std::string dir, uint64_t maxBytes)
+    : dir_(std::move(dir)), maxBytes_(maxBytes) {
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+}
+
+ResultCache::Key ResultCache::key(std::string_view source, const std::string& className, uint64_t headers,
+                                  uint64_t prelude) const {
+    // Build ID and options first, separated so "ab"+"c" and "a"+"bc" hash differently
+    uint64_t h = hashString(buildId());
+    h = hashBytes("\0", 1, h);
+    h = hashString(className, h);
+    h = hashBytes("\0", 1, h);
+    h = hashBytes(reinterpret_cast<const char*>(&headers), sizeof(headers), h);
+    h = hashBytes(reinterpret_cast<const char*>(&prelude), sizeof(prelude), h);
+    h = hashString(source, h);
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+
+    // The inputs themselves, with the source as its size and a hash started from another seed
+    std::ostringstream inputs;
+    inputs << kMagic << buildId() << '\n' << className << '\n' << std::hex << headers << ' ' << prelude << ' '
+           << std::dec << source.size() << ' ' << std::hex << hashString(source, kSecondSeed) << '\n';
+    return {hex, inputs.str()};
+}
+
+std::string ResultCache::entryPath(const Key& key) const {
+    return dir_ + "/" + key.name.substr(0, 2) + "/" + key.name + ".java";
+}
+
+bool ResultCache::lookup(const Key& key, std::string& javaCode) {
+    std::string path = entryPath(key);
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        misses_++;
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    std::string entry = buffer.str();
+    if (entry.compare(0, key.inputs.size(), key.inputs) != 0) {
+        // Another source (or an entry from before the inputs were stored) under the same name
+        misses_++;
+        return false;
+    }
+    javaCode = entry.substr(key.inputs.size());
+    hits_++;
+    bytesRead_ += javaCode.size();
+    // Refresh the entry so eviction sees it as recently used
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void ResultCache::storeFile(const Key& key, const std::string& javaPath) {
+    std::string path = entryPath(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    // Copy to a private temp file and rename, so concurrent readers never see a partial entry
+    std::ostringstream tmpName;
+    tmpName << path << ".tmp" << std::this_thread::get_id() << "." << tempCounter_++;
+    {
+        std::ifstream in(javaPath, std::ios::binary);
+        std::ofstream out(tmpName.str(), std::ios::binary | std::ios::trunc);
+        bool copied = in && out && out << key.inputs;
+        // Streaming an empty buffer sets failbit, so an empty file is copied by copying nothing
+        if (copied && in.peek() != std::char_traits<char>::eof()) copied = static_cast<bool>(out << in.rdbuf());
+        if (!copied || !out.flush()) {
+            out.close();
+            fs::remove(tmpName.str(), ec);
+            return;
+        }
+    }
+    uintmax_t size = fs::file_size(tmpName.str(), ec) - key.inputs.size();
+    fs::rename(tmpName.str(), path, ec);
+    if (ec) {
+        fs::remove(tmpName.str(), ec);
+        return;
+    }
+    bytesWritten_ += size;
+}
+
+void ResultCache::evict() {
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type time;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(dir_, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        // Header cache entries and prelude states (see HeaderCache, Prelude) may live under
+        // the same directory
+        auto extension = it->path().extension();
+        if (!it->is_regular_file(ec) || (extension != ".java" && extension != ".hdr" && extension != ".pch")) {
+            continue;
+        }
+        uint64_t size = it->file_size(ec);
+        if (ec) continue;
+        entries.push_back({it->path(), size, it->last_write_time(ec)});
+        total += size;
+    }
+    if (total <= maxBytes_) return;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const auto& entry : entries) {
+        if (total <= maxBytes_) break;
+        if (fs::remove(entry.path, ec)) {
+            total -= entry.size;
+            evictions_++;
+            evictedBytes_ += entry.size;
+        }
+    }
+}
+
+void ResultCache::printStats(std::ostream& out) const {
+    uint64_t hits = hits_.load();
+    uint64_t lookups = hits + misses_.load();
+    out << "Cache " << dir_ << ": " << hits << " hits, " << misses_.load() << " misses";
+    if (lookups) out << " (" << (100 * hits / lookups) << "% hit rate)";
+    out << ", " << bytesRead_.load() << " bytes read, " << bytesWritten_.load() << " bytes written, "
+        << evictions_.load() << " evicted (" << evictedBytes_.load() << " bytes)\n";
+}
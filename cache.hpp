@@ -0,0 +1,52 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Content-addressed on-disk store of generated Java.
+// Entries live at <dir>/<2 hex>/<16 hex>.java, named by a hash of the source bytes, the headers
+// it includes, the options that affect the output (the class name) and the transpiler build ID. A hit costs
+// two hashes of the source plus one open; entries are refreshed on every hit so evict()
+// removes the least recently used ones first. Safe to share between worker threads.
+class ResultCache {
+public:
+    // Where an entry lives, and the key inputs it starts with. An entry is only a hit when
+    // they match, so a collision of the 64-bit name never passes for one.
+    struct Key {
+        std::string name;     // 16 hex digits
+        std::string inputs;   // Build ID, class name, header and prelude hashes, source size and a second hash
+    };
+
+    ResultCache(std::string dir, uint64_t maxBytes);
+
+    // headers: HeaderCache::dependencyHash of the source, if its includes are followed;
+    // prelude: Prelude::hash, if one is used
+    Key key(std::string_view source, const std::string& className, uint64_t headers = 0,
+            uint64_t prelude = 0) const;
+    // On a hit, fills javaCode and returns true
+    bool lookup(const Key& key, std::string& javaCode);
+    // Store an already written output file without reading it into memory
+    void storeFile(const Key& key, const std::string& javaPath);
+    // Trim the cache directory to maxBytes, oldest entries first
+    void evict();
+    void printStats(std::ostream& out) const;
+
+private:
+    std::string dir_;
+    uint64_t maxBytes_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> bytesRead_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> evictedBytes_{0};
+    std::atomic<uint64_t> tempCounter_{0};
+
+    std::string entryPath(const Key& key) const;
+};
+
+#endif // CACHE_HPP
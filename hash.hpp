@@ -0,0 +1,22 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 64-bit FNV-1a over a byte range; seed chains several ranges into one hash
+inline uint64_t hashBytes(const char* data, size_t size, uint64_t seed = 0xcbf29ce484222325ULL) {
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+inline uint64_t hashString(std::string_view s, uint64_t seed = 0xcbf29ce484222325ULL) {
+    return hashBytes(s.data(), s.size(), seed);
+}
+
+#endif // HASH_HPP
@@ -0,0 +1,372 @@
+#include "header_cache.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+#include "serialize.hpp"
+#include "version.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// --- On-disk format ---
+// A magic line and the build ID, then the variants (see serialize.hpp for the encoding)
+
+const char kMagic[] = "transpiler-header-cache 4\n";
+
+void writeUnit(Writer& out, const HeaderUnit& unit) {
+    out.number(unit.dependencies.size());
+    for (const auto& dependency : unit.dependencies) {
+        out.string(dependency.name);
+        out.number(dependency.hash);
+    }
+    out.number(unit.defines.size());
+    for (const auto& macro : unit.defines) {
+        out.string(macro->name);
+        out.string(definitionText(*macro));
+    }
+    out.number(unit.undefines.size());
+    for (const auto& name : unit.undefines) out.string(name);
+    out.string(unit.guard);
+    out.number(unit.onceFiles.size());
+    for (const auto& path : unit.onceFiles) out.string(path);
+    out.number(unit.onceSkipped.size());
+    for (const auto& path : unit.onceSkipped) out.string(path);
+    out.number(unit.included.size());
+    for (const auto& header : unit.included) {
+        out.string(header.path);
+        out.number(header.hash);
+    }
+    out.number(unit.tokens.size());
+    for (const Token& token : unit.tokens) {
+        out.number(static_cast<uint64_t>(token.type()));
+        out.number(static_cast<uint64_t>(token.line()));
+        out.number(static_cast<uint64_t>(token.column()));
+        out.string(token.text());
+    }
+}
+
+std::shared_ptr<const HeaderUnit> readUnit(Reader& in) {
+    auto unit = std::make_shared<HeaderUnit>();
+    uint64_t count = 0;
+    if (!in.number(count)) return nullptr;
+    for (uint64_t i = 0; i < count; ++i) {
+        HeaderUnit::Dependency dependency;
+        if (!in.string(dependency.name) || !in.number(dependency.hash)) return nullptr;
+        dependency.symbol = intern(dependency.name);
+        unit->dependencies.push_back(std::move(dependency));
+    }
+    if (!in.number(count)) return nullptr;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        std::string definition;
+        std::string error;
+        if (!in.string(name) || !in.string(definition)) return nullptr;
+        auto macro = parseMacroDefinition(name, definition, error);
+        if (!macro) return nullptr;
+        unit->defines.push_back(std::move(macro));
+    }
+    if (!in.number(count)) return nullptr;
+    unit->undefines.resize(count);
+    for (auto& name : unit->undefines) {
+        if (!in.string(name)) return nullptr;
+    }
+    if (!in.string(unit->guard) || !in.number(count)) return nullptr;
+    unit->onceFiles.resize(count);
+    for (auto& path : unit->onceFiles) {
+        if (!in.string(path)) return nullptr;
+    }
+    if (!in.number(count)) return nullptr;
+    unit->onceSkipped.resize(count);
+    for (auto& path : unit->onceSkipped) {
+        if (!in.string(path)) return nullptr;
+    }
+    if (!in.number(count)) return nullptr;
+    unit->included.resize(count);
+    for (auto& header : unit->included) {
+        if (!in.string(header.path) || !in.number(header.hash)) return nullptr;
+    }
+    if (!in.number(count)) return nullptr;
+    unit->tokens = TokenBuffer(std::make_shared<TokenStorage>(nullptr));
+    unit->tokens.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t type = 0;
+        uint64_t line = 0;
+        uint64_t column = 0;
+        std::string_view text;
+        if (!in.number(type) || !in.number(line) || !in.number(column) || !in.string(text)) return nullptr;
+        if (type > static_cast<uint64_t>(TokenType::PREPROCESSOR_UNKNOWN)) return nullptr;
+        TokenType tokenType = static_cast<TokenType>(type);
+        text = unit->tokens.storage()->store(text);
+        Token token(tokenType, text, static_cast<int>(line), static_cast<int>(column),
+                    tokenType == TokenType::IDENTIFIER ? intern(text) : sym::None);
+        // Numbers' values are not stored; they decode from the text as when lexed
+        if (tokenType == TokenType::INTEGER || tokenType == TokenType::FLOAT) decodeNumber(token);
+        unit->tokens.push_back(token);
+    }
+    return unit;
+}
+
+// Header names on the #include lines of text, with whether each was quoted. Sets computed if
+// an #include names its header through a macro.
+std::vector<std::pair<std::string, bool>> includeLines(std::string_view text, bool& computed) {
+    std::vector<std::pair<std::string, bool>> names;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        size_t p = line.find_first_not_of(" \t");
+        if (p == std::string_view::npos || line[p] != '#') continue;
+        p = line.find_first_not_of(" \t", p + 1);
+        if (p == std::string_view::npos || line.compare(p, 7, "include") != 0) continue;
+        p += 7;
+        if (p < line.size() && (std::isalnum(static_cast<unsigned char>(line[p])) || line[p] == '_')) continue;
+        p = line.find_first_not_of(" \t\r", p);
+        if (p == std::string_view::npos) continue;
+        if (line[p] != '"' && line[p] != '<') {
+            computed = true;
+            continue;
+        }
+        size_t close = line.find(line[p] == '"' ? '"' : '>', p + 1);
+        if (close == std::string_view::npos) continue;
+        names.emplace_back(std::string(line.substr(p + 1, close - p - 1)), line[p] == '"');
+    }
+    return names;
+}
+
+} // unnamed namespace
+
+std::string detectIncludeGuard(const TokenBuffer& tokens) {
+    // #ifndef NAME  #define NAME ...  #endif, with the #endif closing the first group
+    size_t n = tokens.size();
+    if (n > 0 && tokens.type(n - 1) == TokenType::END_OF_FILE) --n;
+    if (n < 9 || tokens.type(0) != TokenType::HASH || tokens.type(1) != TokenType::PREPROCESSOR_IFNDEF ||
+        tokens.type(3) != TokenType::HASH || tokens.type(4) != TokenType::PREPROCESSOR_DEFINE ||
+        tokens[5].text() != tokens[2].text()) {
+        return "";
+    }
+    int depth = 0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        if (tokens.type(i) != TokenType::HASH) continue;
+        switch (tokens.type(i + 1)) {
+            case TokenType::PREPROCESSOR_IF:
+            case TokenType::PREPROCESSOR_IFDEF:
+            case TokenType::PREPROCESSOR_IFNDEF:
+                ++depth;
+                break;
+            case TokenType::PREPROCESSOR_ELIF:
+            case TokenType::PREPROCESSOR_ELSE:
+                if (depth == 1) return "";
+                break;
+            case TokenType::PREPROCESSOR_ENDIF:
+                if (--depth == 0 && i + 2 != n) return "";
+                break;
+            default:
+                break;
+        }
+    }
+    return depth == 0 ? std::string(tokens[2].text()) : "";
+}
+
+HeaderCache::HeaderCache(std::vector<std::string> includeDirs, std::string diskDir)
+    : includeDirs_(std::move(includeDirs)), diskDir_(std::move(diskDir)) {
+    if (!diskDir_.empty()) {
+        std::error_code ec;
+        fs::create_directories(diskDir_, ec);
+    }
+}
+
+std::string HeaderCache::resolve(const std::string& name, bool quoted, const std::string& includer) const {
+    std::error_code ec;
+    auto found = [&ec](const fs::path& candidate) {
+        return fs::is_regular_file(candidate, ec) ? fs::weakly_canonical(candidate, ec).string() : std::string();
+    };
+    if (quoted) {
+        std::string path = found(fs::path(includer).parent_path() / name);
+        if (!path.empty()) return path;
+    }
+    for (const auto& dir : includeDirs_) {
+        std::string path = found(fs::path(dir) / name);
+        if (!path.empty()) return path;
+    }
+    return "";
+}
+
+std::shared_ptr<const HeaderSource> HeaderCache::source(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sources_.find(path);
+        if (it != sources_.end()) return it->second;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return nullptr;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    auto header = std::make_shared<HeaderSource>();
+    header->path = path;
+    header->text = std::make_shared<const std::string>(buffer.str());
+    header->hash = hashString(*header->text);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sources_.emplace(path, std::move(header)).first->second;
+}
+
+std::string HeaderCache::entryKey(const HeaderSource& header) const {
+    uint64_t h = hashString(header.path);
+    h = hashBytes(reinterpret_cast<const char*>(&header.hash), sizeof(header.hash), hashBytes("\0", 1, h));
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+    return hex;
+}
+
+HeaderCache::Entry& HeaderCache::entry(const HeaderSource& header) {
+    Entry& found = entries_[entryKey(header)];
+    if (!found.loaded) {
+        found.loaded = true;
+        if (!diskDir_.empty()) load(header, found);
+    }
+    return found;
+}
+
+bool HeaderCache::guarded(const HeaderSource& header, const MacroExpander& macros) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The guard is a property of the contents, so any variant knows it
+    const Entry& found = entry(header);
+    if (found.variants.empty() || found.variants[0]->guard.empty()) return false;
+    return macros.isDefined(found.variants[0]->guard);
+}
+
+std::shared_ptr<const HeaderUnit> HeaderCache::find(const HeaderSource& header, const MacroExpander& macros,
+                                                   const std::unordered_set<std::string>& once) {
+    std::vector<std::shared_ptr<const HeaderUnit>> variants;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        variants = entry(header).variants;
+    }
+    auto included = [&once](const std::string& path) { return once.count(path) != 0; };
+    auto unchanged = [this](const HeaderUnit::Included& header) {
+        auto current = source(header.path);   // Read outside the lock
+        return current && current->hash == header.hash;
+    };
+    for (const auto& variant : variants) {
+        bool match = std::all_of(variant->onceSkipped.begin(), variant->onceSkipped.end(), included) &&
+                     std::none_of(variant->onceFiles.begin(), variant->onceFiles.end(), included);
+        for (const auto& dependency : variant->dependencies) {
+            const Macro* macro = macros.find(dependency.symbol);
+            if (!match || (macro ? macro->hash : 0) != dependency.hash) {
+                match = false;
+                break;
+            }
+        }
+        if (match && std::all_of(variant->included.begin(), variant->included.end(), unchanged)) {
+            hits_++;
+            return variant;
+        }
+    }
+    misses_++;
+    return nullptr;
+}
+
+void HeaderCache::insert(const HeaderSource& header, std::shared_ptr<const HeaderUnit> unit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& found = entry(header);
+    found.variants.push_back(std::move(unit));
+    if (!diskDir_.empty()) store(header, found);
+}
+
+void HeaderCache::load(const HeaderSource& header, Entry& entry) {
+    std::ifstream in(diskDir_ + "/" + entryKey(header) + ".hdr", std::ios::binary);
+    if (!in) return;
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string bytes = buffer.str();
+    Reader reader(bytes);
+    std::string_view magic;
+    std::string_view build;
+    std::string_view path;
+    uint64_t hash = 0;
+    uint64_t count = 0;
+    // Another build may lex differently, and a hash collision must not pass for a hit
+    if (!reader.string(magic) || magic != kMagic || !reader.string(build) || build != buildId() ||
+        !reader.string(path) || path != header.path || !reader.number(hash) || hash != header.hash ||
+        !reader.number(count)) {
+        return;
+    }
+    std::vector<std::shared_ptr<const HeaderUnit>> variants;
+    for (uint64_t i = 0; i < count; ++i) {
+        auto unit = readUnit(reader);
+        if (!unit) {
+            LOG_WARN(LogCategory::Lexer, "Ignoring damaged header cache entry for " << header.path);
+            return;
+        }
+        variants.push_back(std::move(unit));
+    }
+    entry.variants = std::move(variants);
+    diskLoads_++;
+}
+
+void HeaderCache::store(const HeaderSource& header, const Entry& entry) {
+    Writer out;
+    out.string(kMagic);
+    out.string(buildId());
+    out.string(header.path);
+    out.number(header.hash);
+    out.number(entry.variants.size());
+    for (const auto& unit : entry.variants) writeUnit(out, *unit);
+
+    // Write to a private temp file and rename, so readers never see a partial entry
+    std::string path = diskDir_ + "/" + entryKey(header) + ".hdr";
+    std::ostringstream tmpName;
+    tmpName << path << ".tmp" << std::this_thread::get_id();
+    {
+        std::ofstream file(tmpName.str(), std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(out.bytes().data(), out.bytes().size())) return;
+    }
+    std::error_code ec;
+    fs::rename(tmpName.str(), path, ec);
+    if (ec) fs::remove(tmpName.str(), ec);
+}
+
+uint64_t HeaderCache::dependencyHash(std::string_view source, const std::string& path) {
+    uint64_t h = hashString("headers");
+    std::unordered_set<std::string> seen;
+    std::vector<std::pair<std::string_view, std::string>> pending{{source, path}};
+    // Headers are kept alive by sources_ while their text is scanned
+    std::vector<std::shared_ptr<const HeaderSource>> headers;
+    bool computed = false;
+    while (!pending.empty()) {
+        auto [text, includer] = pending.back();
+        pending.pop_back();
+        for (const auto& [name, quoted] : includeLines(text, computed)) {
+            std::string resolved = resolve(name, quoted, includer);
+            if (resolved.empty() || !seen.insert(resolved).second) continue;
+            auto header = this->source(resolved);
+            if (!header) continue;
+            h = hashString(resolved, h);
+            h = hashBytes(reinterpret_cast<const char*>(&header->hash), sizeof(header->hash), h);
+            headers.push_back(header);
+            pending.emplace_back(*header->text, resolved);
+        }
+    }
+    return computed ? 0 : h;
+}
+
+void HeaderCache::forgetSources() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sources_.clear();
+}
+
+void HeaderCache::printStats(std::ostream& out) const {
+    out << "Header cache: " << hits_.load() << " hits, " << misses_.load() << " misses, "
+        << skipped_.load() << " skipped (include guard or #pragma once)";
+    if (!diskDir_.empty()) out << ", " << diskLoads_.load() << " loaded from " << diskDir_;
+    out << "\n";
+}
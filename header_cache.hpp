@@ -0,0 +1,122 @@
+#ifndef HEADER_CACHE_HPP
+#define HEADER_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "macro.hpp"
+#include "token.hpp"
+
+class HeaderCache;
+
+// A header's contents as read in this run
+struct HeaderSource {
+    std::string path;                        // Resolved path
+    std::shared_ptr<const std::string> text;
+    uint64_t hash = 0;
+};
+
+// What lexing a header under some macro state produced: its tokens, and its effect on the
+// macro table of the file that includes it
+struct HeaderUnit {
+    // A macro the header looked up, and the hash of its definition on entry (0: undefined).
+    // The unit is reused wherever all of these still hold.
+    struct Dependency {
+        std::string name;
+        Symbol symbol;
+        uint64_t hash;
+    };
+
+    TokenBuffer tokens;
+    std::vector<Dependency> dependencies;
+    std::vector<std::shared_ptr<const Macro>> defines;   // Defined or redefined by the header
+    std::vector<std::string> undefines;                  // Left undefined by the header
+    std::string guard;                 // Include guard macro (empty: the header has none)
+    std::vector<std::string> onceFiles;// Headers marked #pragma once it (or it itself) included
+    // #pragma once headers it skipped because they were included before it. The unit is only
+    // reused where these have been included and none of onceFiles has.
+    std::vector<std::string> onceSkipped;
+    // Every header it included, directly or not, and the content hash lexed. The unit is only
+    // reused while they are unchanged, which also covers computed #include lines.
+    struct Included {
+        std::string path;
+        uint64_t hash;
+    };
+    std::vector<Included> included;
+};
+
+// Per translation unit: headers already included with #pragma once, and those being lexed
+struct IncludeState {
+    HeaderCache* cache;
+    std::unordered_set<std::string> once;
+    std::vector<std::string> open;     // Innermost last; an #include of one of these is a cycle
+};
+
+// Include guard of a header's tokens: the whole header is one #ifndef NAME group that starts
+// with #define NAME. Empty if there is none.
+std::string detectIncludeGuard(const TokenBuffer& tokens);
+
+// Headers lexed in this run, keyed by resolved path and content hash, with one variant per
+// relevant incoming macro state. With a directory, variants are also kept on disk (as
+// <dir>/<16 hex>.hdr, tokens and macro effects but no expansion caches) for later runs.
+// Safe to share between worker threads; two workers may lex the same header once each.
+class HeaderCache {
+public:
+    explicit HeaderCache(std::vector<std::string> includeDirs = {}, std::string diskDir = "");
+
+    // Path of the header an #include names, or empty if there is none. A quoted name is
+    // looked for next to includer first, then like <name> in the include directories.
+    std::string resolve(const std::string& name, bool quoted, const std::string& includer) const;
+    // The header at a resolved path, read once per run; null if it cannot be read
+    std::shared_ptr<const HeaderSource> source(const std::string& path);
+
+    // True if the header has an include guard and macros define it: including it does nothing
+    bool guarded(const HeaderSource& header, const MacroExpander& macros);
+    // A variant of the header whose dependencies macros and the #pragma once headers already
+    // included satisfy, or null
+    std::shared_ptr<const HeaderUnit> find(const HeaderSource& header, const MacroExpander& macros,
+                                           const std::unordered_set<std::string>& once);
+    void insert(const HeaderSource& header, std::shared_ptr<const HeaderUnit> unit);
+    void noteSkipped() { skipped_++; }
+
+    // Hash over every header source may include, followed through #include lines whatever
+    // the conditions around them; part of the result cache key, so edited headers miss.
+    // 0 if a computed #include (#include MACRO) was found: which header it names is only known
+    // by lexing, so nothing built from source may be cached.
+    uint64_t dependencyHash(std::string_view source, const std::string& path);
+    // Read headers again from now on, for a process that outlives edits to them. Lexed
+    // variants are kept: they are keyed by content.
+    void forgetSources();
+
+    void printStats(std::ostream& out) const;
+
+private:
+    struct Entry {
+        bool loaded = false;           // The disk copy, if any, has been read
+        std::vector<std::shared_ptr<const HeaderUnit>> variants;
+    };
+
+    std::vector<std::string> includeDirs_;
+    std::string diskDir_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const HeaderSource>> sources_;
+    std::unordered_map<std::string, Entry> entries_;   // Keyed by path and content hash
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> diskLoads_{0};
+
+    std::string entryKey(const HeaderSource& header) const;
+    Entry& entry(const HeaderSource& header);   // Caller holds mutex_
+    void load(const HeaderSource& header, Entry& entry);
+    void store(const HeaderSource& header, const Entry& entry);
+};
+
+#endif // HEADER_CACHE_HPP
@@ -0,0 +1,337 @@
+#include "if_expression.hpp"
+#include "lexer.hpp"
+#include "log.hpp"
+#include "macro.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// Deepest operand stack a condition may need; deeper ones are rejected at compile time
+constexpr size_t kMaxDepth = 64;
+// Distinct conditions kept before the cache is dropped and refilled
+constexpr size_t kMaxCached = 4096;
+
+struct CompileError {
+    std::string message;
+};
+
+bool isIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Value of a character literal's text (without quotes)
+long long characterValue(std::string_view text) {
+    if (text.empty()) return 0;
+    if (text[0] != '\\' || text.size() < 2) return static_cast<unsigned char>(text[0]);
+    switch (text[1]) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case '0': return 0;
+        case 'a': return '\a';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        default: return static_cast<unsigned char>(text[1]);
+    }
+}
+
+} // unnamed namespace
+
+// Recursive descent over the condition's tokens, emitting postfix code. Precedence, loosest
+// first: ?: , || , && , | , ^ , & , == != , < > <= >= , << >> , + - , * / % , unary ! ~ - +
+class IfExpressionCompiler {
+public:
+    using Op = IfExpression::Op;
+
+    IfExpressionCompiler(IfExpression& out, std::vector<PPToken> tokens) : out_(out), tokens_(std::move(tokens)) {}
+
+    void run() {
+        try {
+            if (tokens_.empty()) throw CompileError{"Missing expression"};
+            conditional();
+            if (pos_ < tokens_.size()) out_.error_ = "Ignoring trailing text";
+        } catch (const CompileError& error) {
+            out_.error_ = error.message;
+            out_.code_ = {{Op::Push, 0}};
+            out_.identifiers_.clear();
+        }
+    }
+
+private:
+    IfExpression& out_;
+    std::vector<PPToken> tokens_;
+    size_t pos_ = 0;
+    size_t depth_ = 0;
+
+    const Token* peek() const { return pos_ < tokens_.size() ? &tokens_[pos_].token : nullptr; }
+
+    bool match(TokenType type) {
+        if (!peek() || peek()->type() != type) return false;
+        ++pos_;
+        return true;
+    }
+
+    size_t emit(Op op, long long operand = 0) {
+        switch (op) {
+            case Op::Push:
+            case Op::Defined:
+            case Op::Identifier:
+                if (++depth_ > kMaxDepth) throw CompileError{"Condition nested too deeply"};
+                break;
+            case Op::Not:
+            case Op::BitNot:
+            case Op::Negate:
+            case Op::Jump:
+            case Op::ToBool:
+                break;
+            default:
+                --depth_;   // Binary operators, and the fall-through path of the jumps
+                break;
+        }
+        out_.code_.push_back({op, operand});
+        return out_.code_.size() - 1;
+    }
+
+    void patch(size_t jump) { out_.code_[jump].operand = static_cast<long long>(out_.code_.size()); }
+
+    void conditional() {
+        logical(TokenType::OR_OR, Op::OrJump);
+        if (!match(TokenType::QUESTION)) return;
+        size_t toElse = emit(Op::JumpIfZero);
+        conditional();
+        size_t toEnd = emit(Op::Jump);
+        if (!match(TokenType::COLON)) throw CompileError{"Missing ':'"};
+        patch(toElse);
+        conditional();
+        --depth_;   // Only one of the branches' values is ever on the stack
+        patch(toEnd);
+    }
+
+    // a || b and a && b: the right side is only evaluated when the left does not decide
+    void logical(TokenType type, Op jump) {
+        if (type == TokenType::OR_OR) {
+            logical(TokenType::AND_AND, Op::AndJump);
+        } else {
+            binary(0);
+        }
+        while (match(type)) {
+            size_t skip = emit(jump);
+            if (type == TokenType::OR_OR) {
+                logical(TokenType::AND_AND, Op::AndJump);
+            } else {
+                binary(0);
+            }
+            emit(Op::ToBool);
+            patch(skip);
+        }
+    }
+
+    void binary(size_t level) {
+        struct Operator {
+            TokenType type;
+            Op op;
+        };
+        static const std::vector<std::vector<Operator>> kLevels = {
+            {{TokenType::PIPE, Op::BitOr}},
+            {{TokenType::CARET, Op::BitXor}},
+            {{TokenType::AMPERSAND, Op::BitAnd}},
+            {{TokenType::EQUAL_EQUAL, Op::Equal}, {TokenType::NOT_EQUAL, Op::NotEqual}},
+            {{TokenType::LESS, Op::Less}, {TokenType::GREATER, Op::Greater},
+             {TokenType::LESS_EQUAL, Op::LessEqual}, {TokenType::GREATER_EQUAL, Op::GreaterEqual}},
+            {{TokenType::LESS_LESS, Op::Shl}, {TokenType::GREATER_GREATER, Op::Shr}},
+            {{TokenType::PLUS, Op::Add}, {TokenType::MINUS, Op::Sub}},
+            {{TokenType::STAR, Op::Mul}, {TokenType::SLASH, Op::Div}, {TokenType::PERCENT, Op::Mod}},
+        };
+        if (level == kLevels.size()) {
+            unary();
+            return;
+        }
+        binary(level + 1);
+        while (true) {
+            const Operator* found = nullptr;
+            for (const Operator& candidate : kLevels[level]) {
+                if (peek() && peek()->type() == candidate.type) found = &candidate;
+            }
+            if (!found) return;
+            ++pos_;
+            binary(level + 1);
+            emit(found->op);
+        }
+    }
+
+    void unary() {
+        if (match(TokenType::EXCLAIM)) {
+            unary();
+            emit(Op::Not);
+        } else if (match(TokenType::TILDE)) {
+            unary();
+            emit(Op::BitNot);
+        } else if (match(TokenType::MINUS)) {
+            unary();
+            emit(Op::Negate);
+        } else if (match(TokenType::PLUS)) {
+            unary();
+        } else {
+            primary();
+        }
+    }
+
+    void primary() {
+        const Token* token = peek();
+        if (!token) throw CompileError{"Missing operand"};
+        ++pos_;
+        std::string_view text = token->text();
+        switch (token->type()) {
+            case TokenType::LEFT_PAREN:
+                conditional();
+                if (match(TokenType::RIGHT_PAREN)) return;
+                // A ')' missing at the very end is reported, and the condition still counts
+                if (peek()) throw CompileError{"Missing ')'"};
+                out_.error_ = "Missing ')'";
+                return;
+            case TokenType::INTEGER:
+                // Decoded by the lexer; Other marks a malformed number or a user-defined suffix
+                if (token->suffix() == NumberSuffix::Other) throw CompileError{"Bad number '" + std::string(text) + "'"};
+                emit(Op::Push, token->int_value());
+                return;
+            case TokenType::CHARACTER:
+                emit(Op::Push, characterValue(text));
+                return;
+            default:
+                break;
+        }
+        if (text.empty() || !isIdentifierStart(text[0])) {
+            throw CompileError{"Unexpected '" + std::string(text) + "'"};
+        }
+        if (text == "defined") {
+            bool paren = match(TokenType::LEFT_PAREN);
+            const Token* name = peek();
+            if (!name || name->text().empty() || !isIdentifierStart(name->text()[0])) {
+                throw CompileError{"Expected a macro name after defined"};
+            }
+            ++pos_;
+            if (paren && !match(TokenType::RIGHT_PAREN)) throw CompileError{"Missing ')'"};
+            emit(Op::Defined, intern(name->text()));
+            return;
+        }
+        // Identifiers left after macro expansion (keywords included) are 0, except true
+        if (text == "true" || text == "false") {
+            emit(Op::Push, text == "true");
+            return;
+        }
+        Symbol symbol = intern(text);
+        out_.identifiers_.push_back(symbol);
+        emit(Op::Identifier, symbol);
+    }
+};
+
+std::shared_ptr<const IfExpression> IfExpression::cached(std::string_view text) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const IfExpression>> cache;
+    std::string key(text);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) return it->second;
+    }
+    auto expression = std::make_shared<const IfExpression>(compile(text));
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cache.size() >= kMaxCached) cache.clear();
+    return cache.emplace(std::move(key), std::move(expression)).first->second;
+}
+
+IfExpression IfExpression::compile(std::string_view text) {
+    IfExpression expression;
+    expression.text_ = std::string(text);
+    TokenStorage storage(nullptr);
+    IfExpressionCompiler(expression, Lexer::lexFragment(expression.text_, storage)).run();
+    return expression;
+}
+
+bool IfExpression::needsExpansion(const MacroExpander& macros) const {
+    for (Symbol symbol : identifiers_) {
+        const Macro* macro = macros.find(symbol);
+        if (macro && !macro->integer) return true;
+    }
+    return false;
+}
+
+long long IfExpression::evaluate(const MacroExpander& macros) const {
+    // Arithmetic wraps (as unsigned) instead of overflowing; x / 0 and x % 0 are 0
+    long long stack[kMaxDepth];
+    size_t top = 0;
+    auto wrap = [](unsigned long long value) { return static_cast<long long>(value); };
+    for (size_t pc = 0; pc < code_.size(); ++pc) {
+        const Instruction& in = code_[pc];
+        switch (in.op) {
+            case Op::Push: stack[top++] = in.operand; continue;
+            case Op::Defined: stack[top++] = macros.find(static_cast<Symbol>(in.operand)) != nullptr; continue;
+            case Op::Identifier: {
+                const Macro* macro = macros.find(static_cast<Symbol>(in.operand));
+                stack[top++] = macro && macro->integer ? macro->value : 0;
+                continue;
+            }
+            case Op::Not: stack[top - 1] = !stack[top - 1]; continue;
+            case Op::BitNot: stack[top - 1] = ~stack[top - 1]; continue;
+            case Op::Negate: stack[top - 1] = wrap(0ull - static_cast<unsigned long long>(stack[top - 1])); continue;
+            case Op::ToBool: stack[top - 1] = stack[top - 1] != 0; continue;
+            case Op::Jump: pc = in.operand - 1; continue;
+            case Op::JumpIfZero:
+                if (stack[--top] == 0) pc = in.operand - 1;
+                continue;
+            case Op::AndJump:
+                if (stack[top - 1] == 0) {
+                    pc = in.operand - 1;
+                } else {
+                    --top;
+                }
+                continue;
+            case Op::OrJump:
+                if (stack[top - 1] != 0) {
+                    stack[top - 1] = 1;
+                    pc = in.operand - 1;
+                } else {
+                    --top;
+                }
+                continue;
+            default:
+                break;
+        }
+        long long b = stack[--top];
+        long long& a = stack[top - 1];
+        unsigned long long ua = static_cast<unsigned long long>(a);
+        unsigned long long ub = static_cast<unsigned long long>(b);
+        switch (in.op) {
+            case Op::Mul: a = wrap(ua * ub); break;
+            case Op::Div:
+            case Op::Mod:
+                if (b == 0) {
+                    LOG_WARN(LogCategory::Lexer, "Division by zero in #if condition '" << text_ << "'");
+                    a = 0;
+                } else if (b == -1) {
+                    a = in.op == Op::Div ? wrap(0ull - ua) : 0;
+                } else {
+                    a = in.op == Op::Div ? a / b : a % b;
+                }
+                break;
+            case Op::Add: a = wrap(ua + ub); break;
+            case Op::Sub: a = wrap(ua - ub); break;
+            case Op::Shl: a = b < 0 || b > 63 ? 0 : wrap(ua << b); break;
+            case Op::Shr: a = b < 0 || b > 63 ? (a < 0 ? -1 : 0) : a >> b; break;
+            case Op::Less: a = a < b; break;
+            case Op::Greater: a = a > b; break;
+            case Op::LessEqual: a = a <= b; break;
+            case Op::GreaterEqual: a = a >= b; break;
+            case Op::Equal: a = a == b; break;
+            case Op::NotEqual: a = a != b; break;
+            case Op::BitAnd: a = a & b; break;
+            case Op::BitXor: a = a ^ b; break;
+            case Op::BitOr: a = a | b; break;
+            default: break;
+        }
+    }
+    return top ? stack[top - 1] : 0;
+}
@@ -0,0 +1,57 @@
+#ifndef IF_EXPRESSION_HPP
+#define IF_EXPRESSION_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "interner.hpp"
+
+class MacroExpander;
+
+// An #if / #elif condition compiled to a small stack program: integer arithmetic, bitwise,
+// shift, comparison, logical (short-circuit) and ?: operators, defined NAME, and identifiers
+// (the value of a macro defined as an integer, 1 for true, else 0). Compile once per distinct
+// text with cached(); evaluate() only reads the macro table.
+class IfExpression {
+public:
+    // The compiled form of text, shared by every condition spelled the same way (thread-safe)
+    static std::shared_ptr<const IfExpression> cached(std::string_view text);
+    static IfExpression compile(std::string_view text);
+
+    // True if an identifier in the condition (not an operand of defined) names a macro that is
+    // not a plain integer, so the condition must be macro-expanded and the expansion compiled
+    bool needsExpansion(const MacroExpander& macros) const;
+    // Value of the condition; other identifiers than integer macros count as 0
+    long long evaluate(const MacroExpander& macros) const;
+
+    const std::string& error() const { return error_; }   // Empty if the condition is well formed
+    const std::string& text() const { return text_; }
+
+private:
+    enum class Op : uint8_t {
+        Push, Defined, Identifier,
+        Not, BitNot, Negate,
+        Mul, Div, Mod, Add, Sub, Shl, Shr,
+        Less, Greater, LessEqual, GreaterEqual, Equal, NotEqual,
+        BitAnd, BitXor, BitOr,
+        AndJump,     // 0 on top: jump (keeping the 0); else pop
+        OrJump,      // Non-zero on top: make it 1 and jump; else pop
+        JumpIfZero,  // Pop; jump if it was 0
+        Jump, ToBool,
+    };
+    struct Instruction {
+        Op op;
+        long long operand;   // Push: value; Defined, Identifier: symbol; jumps: target index
+    };
+
+    std::string text_;
+    std::vector<Instruction> code_;
+    std::vector<Symbol> identifiers_;   // Operands of Identifier
+    std::string error_;
+
+    friend class IfExpressionCompiler;
+};
+
+#endif // IF_EXPRESSION_HPP
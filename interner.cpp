@@ -0,0 +1,85 @@
+#include "interner.hpp"
+#include <functional>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::string_view kWellKnownSpellings[] = {
+    "",   // sym::None
+#define TRANSPILER_SYMBOL_SPELLING(name, text) text,
+    TRANSPILER_WELL_KNOWN_SYMBOLS(TRANSPILER_SYMBOL_SPELLING)
+#undef TRANSPILER_SYMBOL_SPELLING
+};
+static_assert(sizeof(kWellKnownSpellings) / sizeof(kWellKnownSpellings[0]) == sym::WellKnownCount,
+              "one spelling per well-known symbol");
+
+} // unnamed namespace
+
+Interner& Interner::global() {
+    static Interner* instance = new Interner();   // Never destroyed: symbols outlive static teardown
+    return *instance;
+}
+
+Interner::Interner() {
+    for (std::string_view text : kWellKnownSpellings) {
+        Symbol expected = next_.load(std::memory_order_relaxed);
+        if (intern(text) != expected) {
+            throw std::runtime_error("Duplicate well-known symbol '" + std::string(text) + "'");
+        }
+    }
+}
+
+Interner::~Interner() {
+    for (auto& page : pages_) delete[] page.load(std::memory_order_relaxed);
+}
+
+size_t Interner::shardOf(std::string_view text) {
+    return std::hash<std::string_view>()(text) % kShardCount;
+}
+
+Symbol Interner::intern(std::string_view text) {
+    Shard& shard = shards_[shardOf(text)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.ids.find(text);
+    if (it != shard.ids.end()) return it->second;
+
+    // Claim the next ID only below the limit, so failed calls cannot push next_ past it and
+    // eventually wrap around onto IDs in use
+    Symbol symbol = next_.load(std::memory_order_relaxed);
+    do {
+        if (symbol >= kMaxPages * kPageSize) {
+            throw std::runtime_error("Too many distinct identifiers to intern");
+        }
+    } while (!next_.compare_exchange_weak(symbol, symbol + 1, std::memory_order_relaxed));
+    std::string_view stored = shard.spellings.emplace_back(text);
+    publish(symbol, stored);
+    shard.ids.emplace(stored, symbol);
+    return symbol;
+}
+
+Symbol Interner::find(std::string_view text) const {
+    const Shard& shard = shards_[shardOf(text)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.ids.find(text);
+    return it == shard.ids.end() ? sym::None : it->second;
+}
+
+std::string_view Interner::spelling(Symbol symbol) const {
+    const std::string_view* page = pages_[symbol >> kPageBits].load(std::memory_order_acquire);
+    return page[symbol & (kPageSize - 1)];
+}
+
+void Interner::publish(Symbol symbol, std::string_view text) {
+    std::atomic<std::string_view*>& slot = pages_[symbol >> kPageBits];
+    std::string_view* page = slot.load(std::memory_order_acquire);
+    if (!page) {
+        // Two shards may start the same page at once; the loser frees its copy
+        auto* fresh = new std::string_view[kPageSize];
+        if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+            page = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    page[symbol & (kPageSize - 1)] = text;
+}
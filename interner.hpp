@@ -0,0 +1,113 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 32-bit ID of an interned spelling. Equal spellings always get the same Symbol, so names can
+// be compared and used as map keys as plain integers. 0 (sym::None) means "no symbol".
+using Symbol = uint32_t;
+
+// Names the parser and code generator test for, interned up front with fixed IDs so they can
+// be used as switch labels. X(enumerator, spelling); C++ keywords get a trailing underscore.
+#define TRANSPILER_WELL_KNOWN_SYMBOLS(X) \
+    /* Math and C string functions the parser turns into MathFunctionCall */ \
+    X(sqrt, "sqrt") X(pow, "pow") X(abs, "abs") X(fabs, "fabs") X(sin, "sin") X(cos, "cos") \
+    X(tan, "tan") X(floor, "floor") X(ceil, "ceil") X(round, "round") X(rand, "rand") \
+    X(srand, "srand") X(strcmp, "strcmp") X(strncmp, "strncmp") X(strcpy, "strcpy") \
+    X(strncpy, "strncpy") X(strlen, "strlen") X(strcat, "strcat") X(strncat, "strncat") \
+    /* STL algorithms */ \
+    X(sort, "sort") X(find, "find") X(accumulate, "accumulate") \
+    /* C++ type names the code generator maps to Java */ \
+    X(int_, "int") X(float_, "float") X(double_, "double") X(char_, "char") X(bool_, "bool") \
+    X(void_, "void") X(string, "string") X(vector, "vector") X(deque, "deque") X(list, "list") \
+    X(map, "map") X(unordered_map, "unordered_map") X(set, "set") X(unordered_set, "unordered_set") \
+    X(multimap, "multimap") X(multiset, "multiset") X(stack, "stack") X(queue, "queue") \
+    X(priority_queue, "priority_queue") X(bitset, "bitset") X(array, "array") X(pair, "pair") \
+    X(tuple, "tuple") X(optional, "optional") X(variant, "variant") X(any, "any") \
+    X(std_string, "std::string") X(std_vector, "std::vector") X(std_deque, "std::deque") \
+    X(std_list, "std::list") X(std_map, "std::map") X(std_unordered_map, "std::unordered_map") \
+    X(std_set, "std::set") X(std_unordered_set, "std::unordered_set") X(std_multimap, "std::multimap") \
+    X(std_multiset, "std::multiset") X(std_stack, "std::stack") X(std_queue, "std::queue") \
+    X(std_priority_queue, "std::priority_queue") X(std_bitset, "std::bitset") X(std_array, "std::array") \
+    X(std_pair, "std::pair") X(std_tuple, "std::tuple") X(std_optional, "std::optional") \
+    X(std_variant, "std::variant") X(std_any, "std::any") \
+    /* Java types they map to */ \
+    X(boolean, "boolean") X(Integer, "Integer") X(Float, "Float") X(Double, "Double") \
+    X(Character, "Character") X(Boolean, "Boolean") X(String, "String") X(ArrayList, "ArrayList") \
+    X(ArrayDeque, "ArrayDeque") X(LinkedList, "LinkedList") X(HashMap, "HashMap") X(HashSet, "HashSet") \
+    X(Map, "Map") X(Stack, "Stack") X(Queue, "Queue") X(PriorityQueue, "PriorityQueue") \
+    X(BitSet, "BitSet") X(SimpleEntry, "AbstractMap.SimpleEntry") X(ObjectArray, "Object[]") \
+    X(Optional, "Optional") X(Object, "Object") \
+    /* STL container members mapped to Java methods */ \
+    X(push_back, "push_back") X(pop_back, "pop_back") X(push_front, "push_front") \
+    X(pop_front, "pop_front") X(size, "size") X(empty, "empty") X(clear, "clear") X(at, "at") \
+    X(front, "front") X(back, "back") X(insert, "insert") X(erase, "erase") X(begin, "begin") \
+    X(end, "end") X(count, "count") X(push, "push") X(pop, "pop") X(top, "top") X(reset, "reset") \
+    X(flip, "flip") X(none, "none") X(subscript, "[]")
+
+namespace sym {
+enum : Symbol {
+    None = 0,
+#define TRANSPILER_SYMBOL_ENUMERATOR(name, text) name,
+    TRANSPILER_WELL_KNOWN_SYMBOLS(TRANSPILER_SYMBOL_ENUMERATOR)
+#undef TRANSPILER_SYMBOL_ENUMERATOR
+    WellKnownCount   // First ID handed out at run time
+};
+} // namespace sym
+
+// Process-wide, thread-safe string interner. The lexer interns every identifier once; the
+// parser and code generator then work with Symbols. Spellings are never freed, so the views
+// spelling() returns stay valid for the life of the process.
+class Interner {
+public:
+    static Interner& global();
+
+    // ID for text, assigning the next free one on first sight
+    Symbol intern(std::string_view text);
+    // ID for text if it was ever interned, else sym::None; never adds an entry
+    Symbol find(std::string_view text) const;
+    // Spelling of an ID returned by intern or find ("" for sym::None)
+    std::string_view spelling(Symbol symbol) const;
+    size_t size() const { return next_.load(std::memory_order_relaxed); }
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+private:
+    Interner();
+    ~Interner();
+
+    // Lookups are split over shards by hash so lexer threads rarely contend
+    static constexpr size_t kShardCount = 16;
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string_view, Symbol> ids;
+        std::deque<std::string> spellings;   // Deque elements never move; ids' keys view them
+    };
+    Shard shards_[kShardCount];
+
+    // ID -> spelling, in fixed-size pages that are allocated once and never move, so
+    // spelling() does not lock. A Symbol can only reach another thread after intern()
+    // returned it, which happens after its entry was written.
+    static constexpr size_t kPageBits = 12;
+    static constexpr size_t kPageSize = size_t(1) << kPageBits;
+    static constexpr size_t kMaxPages = 4096;   // 16M distinct spellings
+    std::atomic<std::string_view*> pages_[kMaxPages] = {};
+    std::atomic<Symbol> next_{0};
+
+    static size_t shardOf(std::string_view text);
+    void publish(Symbol symbol, std::string_view text);
+};
+
+// Shorthands for the global interner
+inline Symbol intern(std::string_view text) { return Interner::global().intern(text); }
+inline std::string_view spellingOf(Symbol symbol) { return Interner::global().spelling(symbol); }
+
+#endif // INTERNER_HPP
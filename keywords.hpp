@@ -0,0 +1,132 @@
+#ifndef KEYWORDS_HPP
+#define KEYWORDS_HPP
+
+#include "token.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Identifier spellings the lexer turns into their own TokenType. Library functions (sqrt,
+// sort, printf, ...) are deliberately absent: the parser recognizes those by name on
+// IDENTIFIER tokens.
+struct KeywordSpelling {
+    std::string_view text;
+    TokenType type;
+};
+
+inline constexpr KeywordSpelling kKeywords[] = {
+    {"int", TokenType::INT}, {"void", TokenType::VOID}, {"char", TokenType::CHAR},
+    {"float", TokenType::FLOAT_TYPE}, {"double", TokenType::DOUBLE}, {"bool", TokenType::BOOL},
+    {"class", TokenType::CLASS}, {"struct", TokenType::STRUCT}, {"enum", TokenType::ENUM},
+    {"union", TokenType::UNION}, {"const", TokenType::CONST}, {"unsigned", TokenType::UNSIGNED},
+    {"signed", TokenType::SIGNED}, {"short", TokenType::SHORT}, {"long", TokenType::LONG},
+    {"static", TokenType::STATIC}, {"extern", TokenType::EXTERN}, {"register", TokenType::REGISTER},
+    {"inline", TokenType::INLINE}, {"virtual", TokenType::VIRTUAL}, {"explicit", TokenType::EXPLICIT},
+    {"friend", TokenType::FRIEND}, {"private", TokenType::PRIVATE}, {"public", TokenType::PUBLIC},
+    {"protected", TokenType::PROTECTED}, {"if", TokenType::IF}, {"else", TokenType::ELSE},
+    {"for", TokenType::FOR}, {"while", TokenType::WHILE}, {"do", TokenType::DO},
+    {"switch", TokenType::SWITCH}, {"case", TokenType::CASE}, {"default", TokenType::DEFAULT},
+    {"break", TokenType::BREAK}, {"continue", TokenType::CONTINUE}, {"return", TokenType::RETURN},
+    {"goto", TokenType::GOTO}, {"new", TokenType::NEW}, {"delete", TokenType::DELETE},
+    {"try", TokenType::TRY}, {"catch", TokenType::CATCH}, {"throw", TokenType::THROW},
+    {"typeid", TokenType::TYPEID}, {"static_cast", TokenType::STATIC_CAST},
+    {"dynamic_cast", TokenType::DYNAMIC_CAST}, {"const_cast", TokenType::CONST_CAST},
+    {"reinterpret_cast", TokenType::REINTERPRET_CAST}, {"template", TokenType::TEMPLATE},
+    {"typedef", TokenType::TYPEDEF}, {"using", TokenType::USING}, {"namespace", TokenType::NAMESPACE},
+
+    // STL types the parser treats as type names
+    {"vector", TokenType::VECTOR}, {"map", TokenType::MAP}, {"set", TokenType::SET},
+    {"list", TokenType::LIST}, {"deque", TokenType::DEQUE}, {"unordered_map", TokenType::UNORDERED_MAP},
+    {"unordered_set", TokenType::UNORDERED_SET}, {"multimap", TokenType::MULTIMAP},
+    {"multiset", TokenType::MULTISET}, {"stack", TokenType::STACK}, {"queue", TokenType::QUEUE},
+    {"priority_queue", TokenType::PRIORITY_QUEUE}, {"bitset", TokenType::BITSET},
+    {"array", TokenType::ARRAY}, {"forward_list", TokenType::FORWARD_LIST}, {"pair", TokenType::PAIR},
+    {"tuple", TokenType::TUPLE}, {"string", TokenType::STRING_LIB}, {"optional", TokenType::OPTIONAL},
+    {"variant", TokenType::VARIANT}, {"any", TokenType::ANY}, {"span", TokenType::SPAN},
+    {"valarray", TokenType::VALARRAY},
+
+    // I/O streams
+    {"cin", TokenType::CIN}, {"cout", TokenType::COUT}, {"cerr", TokenType::CERR},
+};
+
+namespace keyword_hash {
+
+constexpr size_t kKeywordCount = sizeof(kKeywords) / sizeof(kKeywords[0]);
+constexpr int kTableBits = 10;
+constexpr size_t kTableSize = size_t(1) << kTableBits;
+static_assert(kKeywordCount < 255, "slots store keyword index + 1 in a byte");
+
+constexpr size_t maxLength() {
+    size_t longest = 0;
+    for (const auto& keyword : kKeywords) longest = keyword.text.size() > longest ? keyword.text.size() : longest;
+    return longest;
+}
+constexpr size_t kMaxLength = maxLength();
+static_assert(kMaxLength < 32, "lengthMask holds one bit per length");
+
+// Bit n set when some keyword is n bytes long; rejects most identifiers before hashing
+constexpr uint32_t lengthMask() {
+    uint32_t mask = 0;
+    for (const auto& keyword : kKeywords) mask |= uint32_t(1) << keyword.text.size();
+    return mask;
+}
+constexpr uint32_t kLengthMask = lengthMask();
+static_assert(!(kLengthMask & 3), "keyOf reads two bytes from each end, so keywords need 2+ bytes");
+
+// Length plus the first two, middle and last two bytes, packed into one word
+constexpr uint64_t keyOf(const char* s, size_t length) {
+    return uint64_t(length) | uint64_t(uint8_t(s[0])) << 8 | uint64_t(uint8_t(s[1])) << 16 |
+           uint64_t(uint8_t(s[length / 2])) << 24 | uint64_t(uint8_t(s[length - 2])) << 32 |
+           uint64_t(uint8_t(s[length - 1])) << 40;
+}
+
+constexpr size_t slotOf(uint64_t key, uint64_t seed) {
+    return size_t((key * seed) >> (64 - kTableBits));
+}
+
+struct Table {
+    uint64_t seed = 0;
+    uint8_t slots[kTableSize] = {};   // keyword index + 1, or 0 for empty
+};
+
+// Try multipliers until one maps every keyword to its own slot. Runs entirely at compile
+// time; a keyword list with no perfect seed in range fails the static_assert below.
+constexpr Table build() {
+    uint64_t candidate = 0x9E3779B97F4A7C15ull;
+    for (int attempt = 0; attempt < 4096; ++attempt) {
+        Table table;
+        table.seed = candidate | 1;
+        bool perfect = true;
+        for (size_t i = 0; i < kKeywordCount && perfect; ++i) {
+            const auto& text = kKeywords[i].text;
+            uint8_t& slot = table.slots[slotOf(keyOf(text.data(), text.size()), table.seed)];
+            if (slot) perfect = false;
+            slot = uint8_t(i + 1);
+        }
+        if (perfect) return table;
+        candidate = candidate * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    return Table{};
+}
+
+inline constexpr Table kTable = build();
+static_assert(kTable.seed != 0, "no collision-free seed found; widen kTableBits or mix in another byte");
+
+} // namespace keyword_hash
+
+// TokenType for an identifier spelling, or IDENTIFIER. One multiply, one table load and a
+// single memcmp; no hashing of heap strings and no allocation.
+inline TokenType lookupKeyword(std::string_view word) {
+    using namespace keyword_hash;
+    size_t length = word.size();
+    if (length > kMaxLength || !(kLengthMask >> length & 1)) return TokenType::IDENTIFIER;
+    uint8_t slot = kTable.slots[slotOf(keyOf(word.data(), length), kTable.seed)];
+    if (!slot) return TokenType::IDENTIFIER;
+    const KeywordSpelling& keyword = kKeywords[slot - 1];
+    if (keyword.text.size() != length || std::memcmp(keyword.text.data(), word.data(), length) != 0) {
+        return TokenType::IDENTIFIER;
+    }
+    return keyword.type;
+}
+
+#endif // KEYWORDS_HPP
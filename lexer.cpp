@@ -1,1559 +1,1278 @@
-#include "parser.hpp"
-#include <stdexcept>
-#include <iostream>
-#include <sstream>
-#include <vector>
-
-
-// --- Constructor ---
-Parser::Parser(std::vector<std::unique_ptr<Token>>&& tokens)
-    : tokens(std::move(tokens)), currentIndex(0) {
-    
-    if (!this->tokens.empty()) {
-        current = *this->tokens[0];
-    }
-    // Initialize log storage
-    parseLogs.clear();
-    logFile.open("OUTPUT/parser_logs.txt", std::ios::out | std::ios::trunc);
-    if (!logFile.is_open()) {
-        throw std::runtime_error("Failed to open OUTPUT/parser_logs.txt for writing");
-    }
-    logFile<< "[Parser] Log file opened successfully." << std::endl;
-}
-Parser::~Parser() {
-    
-    logFile.flush();
-    if (logFile.is_open()) {
-        logFile.close();
-    }
+#include "lexer.hpp"
+#include "header_cache.hpp"
+#include "if_expression.hpp"
+#include "keywords.hpp"
+#include "log.hpp"
+#include "simd_scan.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// --- Character classes ---
+// Every byte is classified by one table load, so the dispatch in lexToken() is a single
+// switch rather than a chain of isalpha/isdigit/... tests.
+
+enum CharClass : uint8_t {
+    kOther,        // Not valid outside literals and comments
+    kSpace,        // ' ', '\t', '\r', '\v', '\f'
+    kNewline,
+    kIdent,        // Letters, '_', '$' and UTF-8 bytes
+    kDigit,
+    kDoubleQuote,
+    kSingleQuote,
+    kHash,
+    kDot,          // Operator, or the start of a number like .5
+    kPunct         // Starts an operator or punctuator
+};
+
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 256; ++c) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') table[c] = kSpace;
+        else if (c == '\n') table[c] = kNewline;
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || c >= 0x80) table[c] = kIdent;
+        else if (c >= '0' && c <= '9') table[c] = kDigit;
+        else if (c == '"') table[c] = kDoubleQuote;
+        else if (c == '\'') table[c] = kSingleQuote;
+        else if (c == '#') table[c] = kHash;
+        else if (c == '.') table[c] = kDot;
+        else if (c != '\\' && c != '@' && c != '`' && c > ' ' && c < 0x7f) table[c] = kPunct;
+    }
+    return table;
 }
 
-// --- Token helpers ---
-void Parser::advance() {
-    
-    prev = current;
-    if (currentIndex + 1 < tokens.size()) {
-        currentIndex++;
-        current = *tokens[currentIndex];
-    } else {
-        // Stay at END_OF_FILE
-        current = *tokens.back();
+constexpr std::array<bool, 256> makeIdentChars() {
+    std::array<bool, 256> table{};
+    for (int c = 0; c < 256; ++c) {
+        table[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                   c == '_' || c == '$' || c >= 0x80;
     }
-    // Store the token log instead of printing
-    // parseLogs.push_back("[Parser] : " + current.toString());
-    logFile << "[Parser] : " << current.toString() << std::endl;
-    std::cout << "[Parser] : ";
-    std::cout << current.toString() << std::endl;
-    logFile.flush();
+    return table;
 }
 
-bool Parser::match(TokenType type) {
-    if (current.type() == type) {
-        advance();
-        return true;
+constexpr auto kCharClass = makeCharClasses();
+constexpr auto kIdentChar = makeIdentChars();
+
+inline uint8_t charClass(char c) { return kCharClass[static_cast<unsigned char>(c)]; }
+inline bool isIdentChar(char c) { return kIdentChar[static_cast<unsigned char>(c)]; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// --- Operator DFA ---
+// Built at compile time from the spelling list below. Operator bytes map to dense columns
+// (column 0 = "not an operator byte"), state 0 is dead and state 1 is the start state.
+// Lexing an operator is a loop of table lookups that stops at the first dead transition
+// and returns the last accepting state seen: maximal munch, so "<<=" never lexes as "<" "<=".
+
+struct OperatorSpelling {
+    const char* text;
+    TokenType type;
+};
+
+constexpr OperatorSpelling kOperators[] = {
+    {"+", TokenType::PLUS}, {"-", TokenType::MINUS}, {"*", TokenType::STAR}, {"/", TokenType::SLASH},
+    {"%", TokenType::PERCENT}, {"&", TokenType::AMPERSAND}, {"|", TokenType::PIPE}, {"^", TokenType::CARET},
+    {"~", TokenType::TILDE}, {"!", TokenType::EXCLAIM}, {"=", TokenType::EQUAL}, {"<", TokenType::LESS},
+    {">", TokenType::GREATER}, {"?", TokenType::QUESTION}, {":", TokenType::COLON}, {";", TokenType::SEMICOLON},
+    {",", TokenType::COMMA}, {".", TokenType::DOT}, {"#", TokenType::HASH},
+    {"(", TokenType::LEFT_PAREN}, {")", TokenType::RIGHT_PAREN}, {"{", TokenType::LEFT_BRACE},
+    {"}", TokenType::RIGHT_BRACE}, {"[", TokenType::LEFT_BRACKET}, {"]", TokenType::RIGHT_BRACKET},
+
+    {"++", TokenType::INCREMENT}, {"--", TokenType::DECREMENT},
+    {"+=", TokenType::PLUS_EQUAL}, {"-=", TokenType::MINUS_EQUAL}, {"*=", TokenType::STAR_EQUAL},
+    {"/=", TokenType::SLASH_EQUAL}, {"%=", TokenType::PERCENT_EQUAL}, {"&=", TokenType::AND_EQUAL},
+    {"|=", TokenType::OR_EQUAL}, {"^=", TokenType::XOR_EQUAL},
+    {"<<", TokenType::LESS_LESS}, {">>", TokenType::GREATER_GREATER},
+    {"<<=", TokenType::LEFT_SHIFT_EQUAL}, {">>=", TokenType::RIGHT_SHIFT_EQUAL},
+    {"==", TokenType::EQUAL_EQUAL}, {"!=", TokenType::NOT_EQUAL},
+    {"<=", TokenType::LESS_EQUAL}, {">=", TokenType::GREATER_EQUAL},
+    {"&&", TokenType::AND_AND}, {"||", TokenType::OR_OR},
+    {"->", TokenType::ARROW}, {"::", TokenType::SCOPE},
+};
+
+constexpr int kOperatorColumns = 32;
+constexpr int kOperatorStates = 64;
+
+struct OperatorDfa {
+    uint8_t column[256];
+    uint8_t next[kOperatorStates][kOperatorColumns];
+    TokenType accept[kOperatorStates];   // TokenType::ERROR = not accepting
+};
+
+constexpr OperatorDfa buildOperatorDfa() {
+    OperatorDfa dfa{};
+    for (auto& type : dfa.accept) type = TokenType::ERROR;
+    int columns = 1;
+    int states = 2;
+    for (const auto& op : kOperators) {
+        int state = 1;
+        for (const char* p = op.text; *p; ++p) {
+            auto byte = static_cast<unsigned char>(*p);
+            if (!dfa.column[byte]) dfa.column[byte] = static_cast<uint8_t>(columns++);
+            uint8_t& next = dfa.next[state][dfa.column[byte]];
+            if (!next) next = static_cast<uint8_t>(states++);
+            state = next;
+        }
+        dfa.accept[state] = op.type;
     }
-    return false;
+    // Out-of-range writes above fail constant evaluation, so the sizes are checked at compile time
+    return dfa;
 }
 
-bool Parser::check(TokenType type) {
-    return current.type() == type;
-}
+constexpr OperatorDfa kOperatorDfa = buildOperatorDfa();
 
-bool Parser::isAtEnd() {
-    return current.type() == TokenType::END_OF_FILE;
-}
+static_assert(kOperatorDfa.accept[kOperatorDfa.next[kOperatorDfa.next[kOperatorDfa.next[1]
+                  [kOperatorDfa.column['<']]][kOperatorDfa.column['<']]][kOperatorDfa.column['=']]] ==
+                  TokenType::LEFT_SHIFT_EQUAL,
+              "operator DFA must recognize <<=");
 
-Token Parser::previous() {
-    return prev;
-}
+// --- Directives ---
 
-bool Parser::expect(TokenType type, const std::string& errMsg) {
-    if (current.type() == type) {
-        advance();
-        return true;
+TokenType directiveLookup(std::string_view name) {
+    static const std::pair<std::string_view, TokenType> directives[] = {
+        {"include", TokenType::PREPROCESSOR_INCLUDE}, {"define", TokenType::PREPROCESSOR_DEFINE},
+        {"undef", TokenType::PREPROCESSOR_UNDEF}, {"ifdef", TokenType::PREPROCESSOR_IFDEF},
+        {"ifndef", TokenType::PREPROCESSOR_IFNDEF}, {"if", TokenType::PREPROCESSOR_IF},
+        {"elif", TokenType::PREPROCESSOR_ELIF}, {"else", TokenType::PREPROCESSOR_ELSE},
+        {"endif", TokenType::PREPROCESSOR_ENDIF}, {"pragma", TokenType::PREPROCESSOR_PRAGMA},
+    };
+    for (const auto& [spelling, type] : directives) {
+        if (spelling == name) return type;
     }
-    std::ostringstream oss;
-    oss << errMsg << " (at line " << current.line() << ", column " << current.column() << ", token: '" << current.text() << "')" ;
-    throw std::runtime_error(oss.str());
+    return TokenType::PREPROCESSOR_UNKNOWN;
 }
 
-// --- Top-level parse ---
-std::unique_ptr<Program> Parser::parse() {
-    return parseProgram();
+// Encoding prefixes that may directly precede a string or character literal
+bool isLiteralPrefix(std::string_view word) {
+    return word == "L" || word == "u" || word == "U" || word == "u8" || word == "R" ||
+           word == "LR" || word == "uR" || word == "UR" || word == "u8R";
 }
 
-std::unique_ptr<Program> Parser::parseProgram() {
-    std::cout << "[DEBUG] :: parseProgram" << std::endl;
-    auto program = std::make_unique<Program>();
-    while (current.type() != TokenType::END_OF_FILE) {
-        auto decl = parseDeclaration();
-        if (!decl) continue; // Skip null declarations, keep parsing
-        program->globals.push_back(std::move(decl));
-    }
-    return program;
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && charClass(s.front()) == kSpace) s.remove_prefix(1);
+    while (!s.empty() && charClass(s.back()) == kSpace) s.remove_suffix(1);
+    return s;
 }
 
-// --- Declarations ---
-std::unique_ptr<ASTNode> Parser::parseDeclaration() {
-    std::cout << "[DEBUG] :: Declaration" << std::endl;
-    // Handle preprocessor directives (HASH and related)
-    if (current.type() == TokenType::HASH) {
-        // Always call parsePreprocessorDirective to build AST node for preprocessor lines
-        return parsePreprocessorDirective();
-    }
-    // If we see a preprocessor directive token (not just HASH), skip it robustly
-    if (
-        current.type() == TokenType::PREPROCESSOR_INCLUDE ||
-        current.type() == TokenType::PREPROCESSOR_DEFINE ||
-        current.type() == TokenType::PREPROCESSOR_IFDEF ||
-        current.type() == TokenType::PREPROCESSOR_IFNDEF ||
-        current.type() == TokenType::PREPROCESSOR_IF ||
-        current.type() == TokenType::PREPROCESSOR_ELIF ||
-        current.type() == TokenType::PREPROCESSOR_ELSE ||
-        current.type() == TokenType::PREPROCESSOR_ENDIF ||
-        current.type() == TokenType::PREPROCESSOR_UNDEF ||
-        current.type() == TokenType::PREPROCESSOR_PRAGMA ||
-        current.type() == TokenType::PREPROCESSOR_UNKNOWN
-    ) {
-        // partial implimentaion
-        advance();
-        return nullptr;
-    }
-
-    // Handle C++ member modifiers
-    bool isVirtual = false, isStatic = false, isInline = false, isConstexpr = false, isFriend = false;
-    while (true) {
-        if (current.type() == TokenType::VIRTUAL) {
-            isVirtual = true;
-            advance();
-        } else if (current.type() == TokenType::STATIC) {
-            isStatic = true;
-            advance();
-        } else if (current.type() == TokenType::INLINE) {
-            isInline = true;
-            advance();
-        } else if (current.type() == TokenType::CONST) {
-            isConstexpr = true;
-            advance();
-        } else if (current.type() == TokenType::FRIEND) {
-            isFriend = true;
-            advance();
-        } else {
-            break;
-        }
-    }
-
-    if (check(TokenType::TEMPLATE)) return parseTemplateDecl();
-    if (check(TokenType::CLASS)) return parseClassDecl();
-    if (check(TokenType::STRUCT)) return parseStructDecl();
-    if (check(TokenType::ENUM)) return parseEnumDecl();
-    if (check(TokenType::UNION)) return parseUnionDecl();
-    if (check(TokenType::NAMESPACE)) return parseNamespaceDecl();
-    if (check(TokenType::TYPEDEF)) return parseTypedefDecl();
-    if (check(TokenType::USING)) return parseUsingDirective();
-
-    if (isTypeToken(current.type())) {
-        // Peek ahead to see if this is a function or variable declaration
-        Token typeToken = current;
-        Token prevToken = prev;
-        advance();
-        if (current.type() == TokenType::IDENTIFIER) {
-            Token nameToken = current;
-            advance();
-            if (current.type() == TokenType::LEFT_PAREN) {
-                // Function declaration
-                auto funcNode = parseFunctionDeclFromTokens(typeToken, nameToken);
-                // Set modifiers
-                if (isVirtual) static_cast<FunctionDecl*>(funcNode.get())->isVirtual = true;
-                if (isStatic) static_cast<FunctionDecl*>(funcNode.get())->isStatic = true;
-                if (isInline) static_cast<FunctionDecl*>(funcNode.get())->isInline = true;
-                if (isConstexpr) static_cast<FunctionDecl*>(funcNode.get())->isConst = true;
-                if (isFriend) static_cast<FunctionDecl*>(funcNode.get())->isFriend = true;
-                return funcNode;
-            } else {
-                // Variable declaration
-                auto varNode = parseVariableDeclFromTokens(typeToken, nameToken);
-                // Set modifiers if you add them to VarDecl
-                return varNode;
+// End of the pp-number starting at data[start]: digits, letters, '.', digit separators and
+// exponent signs, so suffixes and malformed numbers stay one token
+size_t ppNumberEnd(const char* data, size_t start, size_t end, bool& isFloat) {
+    size_t p = start;
+    bool hex = data[p] == '0' && p + 1 < end && (data[p + 1] == 'x' || data[p + 1] == 'X');
+    while (p < end) {
+        char c = data[p];
+        if (c == '.') {
+            isFloat = true;
+            ++p;
+        } else if (isIdentChar(c)) {
+            char lower = static_cast<char>(c | 0x20);
+            bool exponent = hex ? lower == 'p' : lower == 'e';
+            if (exponent && p > start + (hex ? 1 : 0)) {
+                isFloat = true;
+                if (p + 1 < end && (data[p + 1] == '+' || data[p + 1] == '-')) ++p;
             }
+            ++p;
+        } else if (c == '\'' && p + 1 < end && isIdentChar(data[p + 1])) {
+            p += 2;   // Digit separator
         } else {
-            // Rewind if not a valid declaration
-            current = typeToken;
-            prev = prevToken;
-            // If we hit a '}' or EOF, stop parsing
-            if (current.type() == TokenType::RIGHT_BRACE || current.type() == TokenType::END_OF_FILE) {
-                return nullptr;
-            }
+            break;
         }
     }
-    if (current.type() == TokenType::RIGHT_BRACE || current.type() == TokenType::END_OF_FILE) {
-        return nullptr;
-    }
-    return parseStatement();
-}
-
-bool Parser::isTypeToken(TokenType type) {
-    switch (type) {
-        case TokenType::INT:
-        case TokenType::FLOAT_TYPE:
-        case TokenType::DOUBLE:
-        case TokenType::CHAR:
-        case TokenType::BOOL:
-        case TokenType::VOID:
-        case TokenType::IDENTIFIER: // for user-defined types
-        case TokenType::VECTOR:
-        case TokenType::MAP:
-        case TokenType::SET:
-        case TokenType::UNORDERED_MAP:
-        case TokenType::UNORDERED_SET:
-        case TokenType::MULTIMAP:
-        case TokenType::MULTISET:
-        case TokenType::STACK:
-        case TokenType::QUEUE:
-        case TokenType::PRIORITY_QUEUE:
-        case TokenType::BITSET:
-        case TokenType::ARRAY:
-        case TokenType::LIST:
-        case TokenType::FORWARD_LIST:
-        case TokenType::PAIR:
-        case TokenType::TUPLE:
-        case TokenType::STRING_LIB:
-        case TokenType::OPTIONAL:
-        case TokenType::VARIANT:
-        case TokenType::ANY:
-        case TokenType::SPAN:
-        case TokenType::VALARRAY:
-            return true;
-        default:
-            return false;
-    }
+    return p;
 }
 
-// --- Example: Class Declaration ---
-
-// ...existing code...
-
-std::unique_ptr<ASTNode> Parser::parseClassDecl() {
-    expect(TokenType::CLASS, "Expected 'class' keyword");
-    expect(TokenType::IDENTIFIER, "Expected class name");
-    std::string name = previous().text();
-    std::vector<BaseSpecifier> bases;
-    // Parse inheritance list
-    if (match(TokenType::COLON)) {
-        do {
-            std::string access = "private"; // default for class
-            if (check(TokenType::PUBLIC) || check(TokenType::PROTECTED) || check(TokenType::PRIVATE)) {
-                access = current.text();
-                advance();
+// --- Split points for parallel lexing ---
+// A split point is the start of a line the lexer reaches in its top-level state: the newline
+// before it is not inside a comment, literal or raw string, and is not spliced by a backslash.
+// Lexing from there with the same macro table gives the same tokens as lexing through, as long
+// as no directive lies between the split points. The scan below ends every construct where the
+// lexer ends it, without building tokens.
+
+struct SplitPoint {
+    size_t offset;   // First byte of the line
+    int line;        // Its line number
+};
+
+struct SplitScan {
+    std::vector<SplitPoint> points;   // Ascending, at least granularity bytes apart
+    size_t directivesEnd = 0;         // End of the last directive line; earlier points are unusable
+};
+
+// Inside an #if group the scan cannot tell a skipped branch from a live one. The lexer reads
+// a skipped branch more loosely than live code (an unterminated literal ends at the end of
+// its line, a raw string is an ordinary one, a '#' after a comment starts no directive), so
+// a construct that spans lines there may end differently for the lexer. The scan stops at
+// such a place: everything after it belongs to the last chunk, which is lexed with the full
+// lexer anyway.
+SplitScan scanSplitPoints(std::string_view source, size_t start, int line, size_t granularity) {
+    SplitScan scan;
+    const char* data = source.data();
+    const size_t end = source.size();
+    size_t i = start;
+    int depth = 0;            // #if nesting, from the directives seen
+    bool onlySpaces = true;   // Only spaces since the line began
+    bool lineStart = true;    // Only spaces and comments since the line began (the lexer's atLineStart_)
+    size_t nextPoint = start + granularity;
+    auto newlinesIn = [&](size_t from, size_t to) {
+        auto n = static_cast<int>(std::count(data + from, data + to, '\n'));
+        line += n;
+        return n;
+    };
+
+    while (i < end) {
+        char c = data[i];
+        if (c == '\n') {
+            ++i;
+            ++line;
+            onlySpaces = lineStart = true;
+            if (i >= nextPoint && i < end) {
+                scan.points.push_back({i, line});
+                nextPoint = i + granularity;
             }
-            expect(TokenType::IDENTIFIER, "Expected base class name");
-            std::string baseName = previous().text();
-            bases.emplace_back(baseName, access);
-        } while (match(TokenType::COMMA));
-    }
-    expect(TokenType::LEFT_BRACE, "Expected '{' after class name");
-    auto classNode = std::make_unique<ClassDecl>(name);
-    classNode->bases = std::move(bases);
-    enum Access { PUBLIC, PRIVATE, PROTECTED };
-    Access currentAccess = PRIVATE;
-    while (current.type() != TokenType::RIGHT_BRACE && current.type() != TokenType::END_OF_FILE) {
-        if (match(TokenType::PUBLIC)) { expect(TokenType::COLON, "Expected ':' after 'public'"); currentAccess = PUBLIC; continue; }
-        if (match(TokenType::PRIVATE)) { expect(TokenType::COLON, "Expected ':' after 'private'"); currentAccess = PRIVATE; continue; }
-        if (match(TokenType::PROTECTED)) { expect(TokenType::COLON, "Expected ':' after 'protected'"); currentAccess = PROTECTED; continue; }
-        auto member = parseDeclaration();
-        if (!member) continue;
-        if (currentAccess == PUBLIC) classNode->publicMembers.push_back(std::move(member));
-        else if (currentAccess == PROTECTED) classNode->protectedMembers.push_back(std::move(member));
-        else classNode->privateMembers.push_back(std::move(member));
-    }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' after class body");
-    expect(TokenType::SEMICOLON, "Expected ';' after class declaration");
-    return classNode;
-}
-
-std::unique_ptr<ASTNode> Parser::parseStructDecl() {
-    expect(TokenType::STRUCT, "Expected 'struct' keyword");
-    expect(TokenType::IDENTIFIER, "Expected struct name");
-    std::string name = previous().text();
-    std::vector<BaseSpecifier> bases;
-    // Parse inheritance list
-    if (match(TokenType::COLON)) {
-        do {
-            std::string access = "public"; // default for struct
-            if (check(TokenType::PUBLIC) || check(TokenType::PROTECTED) || check(TokenType::PRIVATE)) {
-                access = current.text();
-                advance();
-            }
-            expect(TokenType::IDENTIFIER, "Expected base struct/class name");
-            std::string baseName = previous().text();
-            bases.emplace_back(baseName, access);
-        } while (match(TokenType::COMMA));
-    }
-    expect(TokenType::LEFT_BRACE, "Expected '{' after struct name");
-    auto structNode = std::make_unique<StructDecl>(name);
-    structNode->bases = std::move(bases);
-    enum Access { PUBLIC, PRIVATE, PROTECTED };
-    Access currentAccess = PUBLIC;
-    while (current.type() != TokenType::RIGHT_BRACE && current.type() != TokenType::END_OF_FILE) {
-        if (match(TokenType::PUBLIC)) { expect(TokenType::COLON, "Expected ':' after 'public'"); currentAccess = PUBLIC; continue; }
-        if (match(TokenType::PRIVATE)) { expect(TokenType::COLON, "Expected ':' after 'private'"); currentAccess = PRIVATE; continue; }
-        if (match(TokenType::PROTECTED)) { expect(TokenType::COLON, "Expected ':' after 'protected'"); currentAccess = PROTECTED; continue; }
-        auto member = parseDeclaration();
-        if (!member) continue;
-        if (currentAccess == PUBLIC) structNode->publicMembers.push_back(std::move(member));
-        else if (currentAccess == PROTECTED) structNode->protectedMembers.push_back(std::move(member));
-        else structNode->privateMembers.push_back(std::move(member));
-    }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' after struct body");
-    expect(TokenType::SEMICOLON, "Expected ';' after struct declaration");
-    return structNode;
-}
-
-// ...existing code...
-// --- Example: Variable Declaration ---
-std::unique_ptr<ASTNode> Parser::parseVariableDecl() {
-    std::cout << "[DEBUG] :: VariableDecl" << std::endl;
-    // Parse base type identifier
-    std::string typeName = current.text();
-    advance();
-    // Check for template type (e.g., vector<int>)
-    std::unique_ptr<ASTNode> typeNode = std::make_unique<Identifier>(typeName);
-    if (current.type() == TokenType::LESS) { // '<'
-        // Use parseType to handle template arguments and nesting
-        currentIndex -= 1;
-        current = *tokens[currentIndex];
-        typeNode = parseType();
-    }
-    // Handle pointer/reference tokens between type and variable name
-    while (current.type() == TokenType::STAR || current.type() == TokenType::AMPERSAND) {
-        if (current.type() == TokenType::STAR) {
-            typeNode = std::make_unique<PointerType>(std::move(typeNode));
-        } else if (current.type() == TokenType::AMPERSAND) {
-            typeNode = std::make_unique<ReferenceType>(std::move(typeNode));
+            continue;
         }
-        advance();
-    }
-    // Parse first variable
-    expect(TokenType::IDENTIFIER, "Expected variable name");
-    std::vector<std::string> names;
-    std::vector<std::unique_ptr<ASTNode>> initializers;
-    names.push_back(previous().text());
-    std::unique_ptr<ASTNode> firstInit = nullptr;
-    if (match(TokenType::EQUAL)) {
-        firstInit = parseExpression();
-        // Accept optional 'f' identifier after float literal (e.g., 3.14f)
-        if (typeNode->type == ASTNodeType::IDENTIFIER) {
-            std::string tname = static_cast<Identifier*>(typeNode.get())->name;
-            if (tname == "float" && current.type() == TokenType::IDENTIFIER && current.text() == "f") {
-                advance();
-            }
-        }
-    }
-    initializers.push_back(std::move(firstInit));
-    // Parse additional variables separated by commas
-    while (match(TokenType::COMMA)) {
-        expect(TokenType::IDENTIFIER, "Expected variable name after ','");
-        names.push_back(previous().text());
-        std::unique_ptr<ASTNode> nextInit = nullptr;
-        if (match(TokenType::EQUAL)) {
-            nextInit = parseExpression();
-            if (typeNode->type == ASTNodeType::IDENTIFIER) {
-                std::string tname = static_cast<Identifier*>(typeNode.get())->name;
-                if (tname == "float" && current.type() == TokenType::IDENTIFIER && current.text() == "f") {
-                    advance();
+        switch (charClass(c)) {
+            case kSpace:
+                ++i;
+                continue;
+            case kIdent: {
+                size_t p = scanIdentifier(data + i + 1, data + end) - data;
+                std::string_view word = source.substr(i, p - i);
+                if (p < end && data[p] == '"' && word.back() == 'R' && isLiteralPrefix(word)) {
+                    // Raw string, delimited as lexString delimits it
+                    size_t open = source.find('(', p + 1);
+                    if (open == std::string_view::npos || open - p - 1 > 16) return scan;
+                    std::string closing = ")" + std::string(source.substr(p + 1, open - p - 1)) + "\"";
+                    size_t close = source.find(closing, open + 1);
+                    if (close == std::string_view::npos) return scan;
+                    if (newlinesIn(p, close) && depth) return scan;
+                    p = close + closing.size();
                 }
+                i = p;   // Any other literal prefix is followed by its quote, handled next
+                break;
             }
-        }
-        initializers.push_back(std::move(nextInit));
-    }
-    expect(TokenType::SEMICOLON, "Expected ';' after variable declaration");
-    // If only one variable, emit as before
-    if (names.size() == 1) {
-        auto varNode = std::make_unique<VarDecl>(names[0]);
-        varNode->type = std::move(typeNode);
-        varNode->initializer = std::move(initializers[0]);
-        return varNode;
-    } else {
-        // Multi-variable declaration: emit a BlockStmt containing separate VarDecls
-        auto block = std::make_unique<BlockStmt>();
-        for (size_t i = 0; i < names.size(); ++i) {
-            auto varNode = std::make_unique<VarDecl>(names[i]);
-            varNode->type = std::make_unique<Identifier>(static_cast<Identifier*>(typeNode.get())->name);
-            varNode->initializer = std::move(initializers[i]);
-            block->statements.push_back(std::move(varNode));
-        }
-        return block;
-    }
-}
-// Helper for parseDeclaration only
-std::unique_ptr<ASTNode> Parser::parseVariableDeclFromTokens(const Token& typeToken, const Token& nameToken) {
-    std::cout << "[DEBUG] :: VariableDeclFromTokens" << std::endl;
-    std::string typeName = typeToken.text();
-    std::unique_ptr<ASTNode> typeNode = std::make_unique<Identifier>(typeName);
-    // Handle pointer/reference tokens between type and variable name
-    while (current.type() == TokenType::STAR || current.type() == TokenType::AMPERSAND) {
-        if (current.type() == TokenType::STAR) {
-            typeNode = std::make_unique<PointerType>(std::move(typeNode));
-        } else if (current.type() == TokenType::AMPERSAND) {
-            typeNode = std::make_unique<ReferenceType>(std::move(typeNode));
-        }
-        advance();
-    }
-    std::string varName = nameToken.text();
-    auto varNode = std::make_unique<VarDecl>(varName);
-    varNode->type = std::move(typeNode);
-    if (match(TokenType::EQUAL)) {
-        varNode->initializer = parseExpression();
-    }
-    expect(TokenType::SEMICOLON, "Expected ';' after variable declaration");
-    return varNode;
-}
-
-// --- Example: Function Declaration ---
-std::unique_ptr<ASTNode> Parser::parseFunctionDecl() {
-    std::cout << "[DEBUG] :: FunctionDecl" << std::endl;
-    std::string returnType = current.text();
-    advance();
-    expect(TokenType::IDENTIFIER, "Expected function name");
-    std::string funcName = previous().text();
-    expect(TokenType::LEFT_PAREN, "Expected '(' after function name");
-    auto funcNode = std::make_unique<FunctionDecl>(funcName);
-    funcNode->returnType = std::make_unique<Identifier>(returnType);
-    // Parse parameters (support multiple)
-    std::vector<std::unique_ptr<VarDecl>> parameters;
-    if (!check(TokenType::RIGHT_PAREN)) {
-        do {
-            auto paramType = parseType();
-            expect(TokenType::IDENTIFIER, "Expected parameter name");
-            std::string paramName = previous().text();
-            parameters.push_back(std::make_unique<VarDecl>(paramName, std::move(paramType)));
-        } while (match(TokenType::COMMA));
-    }
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after parameters");
-    // Convert parameters to ASTNode pointers for FunctionDecl
-    std::vector<std::unique_ptr<ASTNode>> paramNodes;
-    for (auto& p : parameters) paramNodes.push_back(std::move(p));
-    funcNode->parameters = std::move(paramNodes);
-    funcNode->body = parseBlock();
-    return funcNode;
-}
-// Helper for parseDeclaration only
-std::unique_ptr<ASTNode> Parser::parseFunctionDeclFromTokens(const Token& typeToken, const Token& nameToken) {
-    std::cout << "[DEBUG] ::FunctionDeclFromTokens" << std::endl;
-    std::string returnType = typeToken.text();
-    std::string funcName = nameToken.text();
-    expect(TokenType::LEFT_PAREN, "Expected '(' after function name");
-    auto funcNode = std::make_unique<FunctionDecl>(funcName);
-    funcNode->returnType = std::make_unique<Identifier>(returnType);
-    // Parse parameters (support multiple)
-    std::vector<std::unique_ptr<VarDecl>> parameters;
-    if (!check(TokenType::RIGHT_PAREN)) {
-        do {
-            auto paramType = parseType();
-            expect(TokenType::IDENTIFIER, "Expected parameter name");
-            std::string paramName = previous().text();
-            parameters.push_back(std::make_unique<VarDecl>(paramName, std::move(paramType)));
-        } while (match(TokenType::COMMA));
-    }
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after parameters");
-    if (funcNode->isVirtual) {
-        std::cout << funcNode->isVirtual <<std::endl;
-        if (check(TokenType::EQUAL)) {
-            advance();
-            if (check(TokenType::INTEGER) && current.text() == "0") {
-                advance();
-                funcNode->isVirtual = true; // Optionally set a flag for pure virtual
-            } else {
-                throw std::runtime_error("Expected '0' after '=' for pure virtual function");
+            case kDigit: {
+                bool isFloat = false;
+                i = ppNumberEnd(data, i, end, isFloat);
+                break;
             }
-        }
-    }
-    // Convert parameters to ASTNode pointers for FunctionDecl
-    std::vector<std::unique_ptr<ASTNode>> paramNodes;
-    for (auto& p : parameters) paramNodes.push_back(std::move(p));
-    funcNode->parameters = std::move(paramNodes);
-    
-    if (check(TokenType::LEFT_BRACE)) {
-        funcNode->body = parseBlock();
-    } else if (check(TokenType::SEMICOLON)) {
-        funcNode->body = nullptr;
-        advance(); // consume the semicolon
-    } else {
-        throw std::runtime_error("Expected '{' or ';' after function declaration");
-    }
-    return funcNode;
-}
-
-// --- Example: Block ---
-std::unique_ptr<ASTNode> Parser::parseBlock() {
-    std::cout << "[DEBUG] :: Block" << std::endl;
-    expect(TokenType::LEFT_BRACE, "Expected '{' to start block");
-    auto block = std::make_unique<BlockStmt>();
-    while (current.type() != TokenType::RIGHT_BRACE && current.type() != TokenType::END_OF_FILE) {
-        block->statements.push_back(parseStatement());
-    }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' to end block");
-    return block;
-}
-
-// --- Example: Statement ---
-std::unique_ptr<ASTNode> Parser::parseStatement() {
-    std::cout << "[DEBUG] :: Statement" << std::endl;
-    if (check(TokenType::IF)) return parseIfStmt();
-    if (check(TokenType::WHILE)) return parseWhileStmt();
-    if (check(TokenType::FOR)) return parseForStmt();
-    if (check(TokenType::SWITCH)) return parseSwitchStmt();
-    if (check(TokenType::RETURN)) return parseReturnStmt();
-    if (check(TokenType::CONTINUE)) return parseContinueStmt();
-    if (check(TokenType::BREAK)) return parseBreakStmt();
-    if (current.type() == TokenType::LEFT_BRACE) return parseBlock();
-    // Allow variable declarations inside blocks, but only if not assignment
-    if (isTypeToken(current.type())) {
-        // Peek ahead: type IDENTIFIER [EQUAL|SEMICOLON|LEFT_BRACKET|COMMA]
-        Token typeToken = current;
-        size_t saveIndex = currentIndex;
-        advance();
-        if (current.type() == TokenType::IDENTIFIER) {
-            Token nameToken = current;
-            advance();
-            // Only treat as declaration if next token is SEMICOLON, LEFT_BRACKET, or COMMA
-            // If next token is EQUAL, treat as declaration ONLY if previous token was not already a variable (i.e., not an assignment)
-            if (current.type() == TokenType::SEMICOLON || current.type() == TokenType::LEFT_BRACKET || current.type() == TokenType::COMMA) {
-                // Rewind to type token and parse as variable declaration
-                currentIndex = saveIndex;
-                current = typeToken;
-                return parseVariableDecl();
+            case kDot: {
+                bool isFloat = false;
+                i = i + 1 < end && isDigit(data[i + 1]) ? ppNumberEnd(data, i, end, isFloat) : i + 1;
+                break;
             }
-            // If next token is EQUAL, check if this is a declaration or assignment
-            if (current.type() == TokenType::EQUAL) {
-                // If the type token is a built-in type or known type, treat as declaration
-                if (typeToken.type() != TokenType::IDENTIFIER || isTypeToken(typeToken.type())) {
-                    currentIndex = saveIndex;
-                    current = typeToken;
-                    return parseVariableDecl();
+            case kDoubleQuote:
+            case kSingleQuote: {
+                // Ends at the closing quote, or before the newline if unterminated
+                size_t p = i + 1;
+                while (true) {
+                    p = scanLiteral(data + p, data + end, c) - data;
+                    if (p >= end || data[p] == '\n' || data[p] == c) break;
+                    if (p + 1 < end && data[p + 1] == '\n') {
+                        // A line splice; see above
+                        if (depth) return scan;
+                        ++line;
+                    }
+                    p += 2;
+                }
+                i = p < end && data[p] == c ? p + 1 : std::min(p, end);
+                break;
+            }
+            case kHash: {
+                if (!lineStart) {
+                    ++i;
+                    break;
+                }
+                // A directive; a skipped branch only recognises one after spaces
+                if (depth && !onlySpaces) return scan;
+                size_t p = i + 1;
+                while (p < end && charClass(data[p]) == kSpace) ++p;
+                size_t nameStart = p;
+                while (p < end && isIdentChar(data[p])) ++p;
+                TokenType directive = directiveLookup(source.substr(nameStart, p - nameStart));
+                if (directive == TokenType::PREPROCESSOR_IF || directive == TokenType::PREPROCESSOR_IFDEF ||
+                    directive == TokenType::PREPROCESSOR_IFNDEF) {
+                    ++depth;
+                } else if (directive == TokenType::PREPROCESSOR_ENDIF && depth) {
+                    --depth;
+                }
+                // The rest of the line, read as readDirectiveRest reads it
+                while (p < end && data[p] != '\n') {
+                    char d = data[p];
+                    if (d == '\\' && p + 1 < end && data[p + 1] == '\n') {
+                        p += 2;
+                        ++line;
+                    } else if (d == '\\' && p + 2 < end && data[p + 1] == '\r' && data[p + 2] == '\n') {
+                        p += 3;
+                        ++line;
+                    } else if (d == '/' && p + 1 < end && data[p + 1] == '/') {
+                        p = scanLineEnd(data + p, data + end) - data;
+                    } else if (d == '/' && p + 1 < end && data[p + 1] == '*') {
+                        size_t close = scanBlockCommentEnd(data + p + 2, data + end) - data;
+                        if (close >= end) return scan;
+                        newlinesIn(p, close);
+                        p = close + 2;
+                    } else if (d == '"' || d == '\'') {
+                        ++p;
+                        while (p < end && data[p] != d && data[p] != '\n') {
+                            p += data[p] == '\\' && p + 1 < end && data[p + 1] != '\n' ? 2 : 1;
+                        }
+                        if (p < end && data[p] == d) ++p;
+                    } else {
+                        ++p;
+                    }
                 }
-                // Otherwise, treat as expression (assignment)
+                scan.directivesEnd = p;
+                i = p;
+                break;
             }
+            default:
+                if (c == '/' && i + 1 < end && data[i + 1] == '/') {
+                    // Line comment; a trailing backslash splices the next line into it
+                    size_t p = i + 2;
+                    while (true) {
+                        p = scanLineEnd(data + p, data + end) - data;
+                        size_t last = p;
+                        while (last > i && data[last - 1] == '\r') --last;
+                        if (p == end || data[last - 1] != '\\') break;
+                        if (depth) return scan;
+                        ++p;
+                        ++line;
+                    }
+                    i = p;
+                    onlySpaces = false;
+                    continue;
+                }
+                if (c == '/' && i + 1 < end && data[i + 1] == '*') {
+                    size_t close = scanBlockCommentEnd(data + i + 2, data + end) - data;
+                    if (close >= end) return scan;
+                    if (newlinesIn(i, close) && depth) return scan;
+                    i = close + 2;
+                    onlySpaces = false;
+                    continue;
+                }
+                if (c == '\\' && i + 1 < end && data[i + 1] == '\n') {
+                    // Line splice between tokens
+                    if (depth) return scan;
+                    i += 2;
+                    ++line;
+                    continue;
+                }
+                ++i;
+                break;
         }
-        // Not a declaration, rewind and parse as expression
-        currentIndex = saveIndex;
-        current = *tokens[currentIndex];
+        onlySpaces = lineStart = false;
     }
-    // Fallback: expression statement
-    // size_t exprStart = currentIndex;
-    // auto expr = parseExpression();
-    // expect(TokenType::SEMICOLON, "Expected ';' after expression");
-    // size_t exprEnd = currentIndex;
-    // std::string cppExprStr;
-    // for (size_t i = exprStart; i < exprEnd; ++i) {
-    //     cppExprStr += tokens[i]->text() ;
-    // }
-    // auto stmt = std::make_unique<ExpressionStmt>(std::move(expr));
-    // stmt->cppExpr = cppExprStr;
-    // std::cout << stmt->cppExpr<< std::endl;
-    // return stmt;
-    return parseExpressionstmt();
+    return scan;
 }
 
-std::unique_ptr<ASTNode> Parser::parseExpressionstmt(){
-    std::cout << "[DEBUG] :: ExpressionStmt" << std::endl;
-    size_t exprStart = currentIndex;
-    auto expr = parseExpression();
-    expect(TokenType::SEMICOLON, "Expected ';' after expression");
-    size_t exprEnd = currentIndex;
-    std::string cppExprStr;
-    for (size_t i = exprStart; i < exprEnd; ++i) {
-        cppExprStr += tokens[i]->text() ;
-    }
-    auto stmt = std::make_unique<ExpressionStmt>(std::move(expr));
-    stmt->cppExpr = cppExprStr;
-    std::cout << stmt->cppExpr<< std::endl;
-    return stmt;
-}
-// --- parseTryStmt ---
-std::unique_ptr<ASTNode> Parser::parseTryStmt() {
-    std::cout << "[DEBUG] :: TryStmt" << std::endl;
-    expect(TokenType::TRY, "Expected 'try'");
-    auto tryBlockNode = parseBlock();
-    auto tryBlock = std::unique_ptr<BlockStmt>(static_cast<BlockStmt*>(tryBlockNode.release()));
-    std::vector<std::unique_ptr<CatchStmt>> catches;
-    while (check(TokenType::CATCH)) {
-        catches.push_back(parseCatchStmt());
-    }
-    return std::make_unique<TryStmt>(std::move(tryBlock), std::move(catches));
-}
+} // unnamed namespace
 
-// --- parseThrowStmt ---
-std::unique_ptr<ASTNode> Parser::parseThrowStmt() {
-    std::cout << "[DEBUG] :: ThrowStmt" << std::endl;
-    expect(TokenType::THROW, "Expected 'throw'");
-    auto expr = parseExpression();
-    expect(TokenType::SEMICOLON, "Expected ';' after throw statement");
-    return std::make_unique<ThrowStmt>(std::move(expr));
+Lexer::Lexer(std::string_view source, std::shared_ptr<const void> owner)
+    : source_(source), tokens_(std::make_shared<TokenStorage>(std::move(owner))), macros_(tokens_.storage()) {
+    // A UTF-8 byte order mark is not part of the program
+    if (source_.substr(0, 3) == "\xEF\xBB\xBF") pos_ = lineStart_ = 3;
 }
 
-// --- parseBreakStmt ---
-std::unique_ptr<ASTNode> Parser::parseBreakStmt() {
-    std::cout << "[DEBUG] :: BreakStmt" << std::endl;
-    expect(TokenType::BREAK, "Expected 'break'");
-    expect(TokenType::SEMICOLON, "Expected ';' after break");
-    return std::make_unique<BreakStmt>();
+TokenBuffer Lexer::tokenize() {
+    tokens_.clear();
+    // C++ averages roughly one token per five or six bytes
+    tokens_.reserve(source_.size() / 6 + 16);
+    while (lexStep()) {}
+    warnOpenConditionals();
+    return std::move(tokens_);
 }
 
-// --- parseContinueStmt ---
-std::unique_ptr<ASTNode> Parser::parseContinueStmt() {
-    std::cout << "[DEBUG] :: ContinueStmt" << std::endl;
-    expect(TokenType::CONTINUE, "Expected 'continue'");
-    expect(TokenType::SEMICOLON, "Expected ';' after continue");
-    return std::make_unique<ContinueStmt>();
+TokenBuffer Lexer::tokenizeParallel(unsigned jobs, size_t minChunkBytes) {
+    const size_t end = source_.size();
+    const size_t startPos = pos_;
+    const size_t startLineStart = lineStart_;
+    const int startLine = line_;
+    if (jobs < 2 || end - pos_ < 2 * minChunkBytes) return tokenize();
+    SplitScan scan = scanSplitPoints(source_, pos_, line_, std::max<size_t>(minChunkBytes / 16, 1));
+
+    // Chunks start after the last directive, so they all see the macro table as it is there,
+    // and are cut at the split points nearest to equal byte shares
+    auto first = std::upper_bound(scan.points.begin(), scan.points.end(), scan.directivesEnd,
+                                  [](size_t offset, const SplitPoint& point) { return offset < point.offset; });
+    if (first == scan.points.end()) return tokenize();
+    size_t begin = first->offset;
+    size_t chunkCount = std::min<size_t>(jobs, (end - begin) / minChunkBytes);
+    std::vector<SplitPoint> splits{*first};
+    for (size_t k = 1; k < chunkCount; ++k) {
+        size_t target = begin + (end - begin) * k / chunkCount;
+        auto it = std::lower_bound(first, scan.points.end(), target,
+                                   [](const SplitPoint& point, size_t offset) { return point.offset < offset; });
+        if (it == scan.points.end()) break;
+        if (it->offset > splits.back().offset) splits.push_back(*it);
+    }
+    if (splits.size() < 2) return tokenize();
+
+    // The directives before the first chunk are lexed here, in order. Should the whole file
+    // have to be lexed in order after all, this lexer starts over from its state here.
+    PreprocessorState startState = saveState();
+    std::unordered_set<std::string> startOnce;
+    if (includes_) startOnce = includes_->once;
+    tokens_.clear();
+    std::string_view whole = source_;
+    source_ = whole.substr(0, splits[0].offset);
+    while (lexStep()) {}
+    tokens_.pop_back();   // END_OF_FILE of the prefix
+    source_ = whole;
+    atLineStart_ = true;
+    if (pulledToEnd_) {
+        // A macro invocation near the cut looked for its arguments: lex it all in one go
+        pos_ = startPos;
+        lineStart_ = startLineStart;
+        line_ = startLine;
+        pulledToEnd_ = false;
+        if (includes_) includes_->once = std::move(startOnce);
+        restoreState(startState);
+        return tokenize();
+    }
+    if (!conditionalStack_.empty()) {
+        // Still inside an #if group, which the chunks cannot know about: finish in order
+        while (lexStep()) {}
+        warnOpenConditionals();
+        return std::move(tokens_);
+    }
+
+    std::vector<TokenBuffer> parts(splits.size());
+    std::vector<char> cutShort(splits.size(), false);
+    std::shared_ptr<const MacroTable> macros = macros_.share();   // Before the threads start
+    auto lexChunk = [&](size_t c) {
+        bool last = c + 1 == splits.size();
+        Lexer chunk(whole.substr(0, last ? end : splits[c + 1].offset));
+        chunk.pos_ = chunk.lineStart_ = splits[c].offset;
+        chunk.line_ = splits[c].line;
+        chunk.macros_.copyDefinitions(macros);
+        parts[c] = chunk.tokenize();
+        if (!last) parts[c].pop_back();
+        cutShort[c] = !last && chunk.pulledToEnd_;
+    };
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < splits.size(); ++c) workers.emplace_back(lexChunk, c);
+    lexChunk(0);
+    for (auto& worker : workers) worker.join();
+    if (std::find(cutShort.begin(), cutShort.end(), true) != cutShort.end()) {
+        // An invocation's arguments run past the end of its chunk; nothing has been consumed
+        // here beyond the prefix, so carry on in order from there
+        while (lexStep()) {}
+        warnOpenConditionals();
+        return std::move(tokens_);
+    }
+
+    // Stitch: chunk tokens already carry absolute lines, and columns are unaffected because
+    // every chunk starts a line. Texts the chunks stored themselves stay alive with ours.
+    size_t total = tokens_.size();
+    for (const auto& part : parts) total += part.size();
+    tokens_.reserve(total);
+    for (const auto& part : parts) {
+        tokens_.append(part);
+        tokens_.storage()->adopt(part.storage());
+    }
+    return std::move(tokens_);
 }
 
-// --- parseGotoStmt ---
-std::unique_ptr<ASTNode> Parser::parseGotoStmt() {
-    std::cout << "[DEBUG] :: GotoStmt" << std::endl;
-    expect(TokenType::GOTO, "Expected 'goto'");
-    expect(TokenType::IDENTIFIER, "Expected label after 'goto'");
-    std::string name = previous().text();
-    expect(TokenType::SEMICOLON, "Expected ';' after goto statement");
-    return std::make_unique<GotoStmt>(name); 
+Token Lexer::next() {
+    // tokens_ only ever holds what one lexStep produced (a directive or macro use can yield
+    // several tokens), so memory does not grow with the length of the source
+    while (nextToken_ == tokens_.size()) {
+        if (finished_) return tokens_.back();   // END_OF_FILE, repeated
+        tokens_.clear();
+        nextToken_ = 0;
+        finished_ = !lexStep();
+        if (finished_) warnOpenConditionals();
+    }
+    return tokens_[nextToken_++];
 }
 
-// --- parseElseStmt ---
-std::unique_ptr<ASTNode> Parser::parseElseStmt() {
-    std::cout << "[DEBUG] :: ElseStmt" << std::endl;
-    expect(TokenType::ELSE, "Expected 'else'");
-    auto elseBranch = parseStatement();
-    return std::make_unique<ElseStmt>(std::move(elseBranch));
+bool Lexer::lexStep() {
+    if (skipping_) skipInactiveRegion();
+    bool more = lexToken();
+    atLineStart_ = false;
+    return more;
 }
 
-// --- parseSwitchStmt ---
-std::unique_ptr<ASTNode> Parser::parseSwitchStmt() {
-    std::cout << "[DEBUG] :: SwitchStmt" << std::endl;
-    expect(TokenType::SWITCH, "Expected 'switch'");
-    expect(TokenType::LEFT_PAREN, "Expected '(' after 'switch'");
-    auto condition = parseExpression();
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after switch condition");
-    expect(TokenType::LEFT_BRACE, "Expected '{' after switch");
-    std::vector<std::unique_ptr<ASTNode>> cases;
-    while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        if (check(TokenType::CASE)) {
-            cases.push_back(parseCaseStmt());
-        } else if (check(TokenType::DEFAULT)) {
-            cases.push_back(parseDefaultStmt());
-        } else {
-            cases.push_back(parseStatement());
-        }
+void Lexer::warnOpenConditionals() const {
+    if (!conditionalStack_.empty()) {
+        LOG_WARN(LogCategory::Lexer, (path_.empty() ? "" : path_ + ": ") << conditionalStack_.size()
+                                     << " unterminated #if group(s) at end of input");
     }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' after switch body");
-    return std::make_unique<SwitchStmt>(std::move(condition), std::move(cases));
 }
 
-// --- parseCaseStmt ---
-std::unique_ptr<ASTNode> Parser::parseCaseStmt() {
-    std::cout << "[DEBUG] :: CaseStmt" << std::endl;
-    expect(TokenType::CASE, "Expected 'case'");
-    auto value = parseExpression();
-    expect(TokenType::COLON, "Expected ':' after case value");
-    std::vector<std::unique_ptr<ASTNode>> statements;
-    while (!check(TokenType::CASE) && !check(TokenType::DEFAULT) && !check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        statements.push_back(parseStatement());
-    }
-    return std::make_unique<CaseStmt>(std::move(value), std::move(statements));
-}
+// --- Character reading ---
+// These are for the cold paths (directives); the hot loops index source_ directly.
 
-// --- parseDefaultStmt ---
-std::unique_ptr<ASTNode> Parser::parseDefaultStmt() {
-    std::cout << "[DEBUG] :: DefaultStmt" << std::endl;
-    expect(TokenType::DEFAULT, "Expected 'default'");
-    expect(TokenType::COLON, "Expected ':' after default");
-    std::vector<std::unique_ptr<ASTNode>> statements;
-    while (!check(TokenType::CASE) && !check(TokenType::DEFAULT) && !check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        statements.push_back(parseStatement());
-    }
-    return std::make_unique<DefaultStmt>(std::move(statements));
+char Lexer::peek() const {
+    return isAtEnd() ? '\0' : source_[pos_];
 }
 
-// --- parseDoWhileStmt ---
-std::unique_ptr<ASTNode> Parser::parseDoWhileStmt() {
-    std::cout << "[DEBUG] :: DoWhileStmt" << std::endl;
-    expect(TokenType::DO, "Expected 'do'");
-    auto body = parseStatement();
-    expect(TokenType::WHILE, "Expected 'while' after do body");
-    expect(TokenType::LEFT_PAREN, "Expected '(' after 'while'");
-    auto condition = parseExpression();
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after do-while condition");
-    expect(TokenType::SEMICOLON, "Expected ';' after do-while");
-    return std::make_unique<DoWhileStmt>(std::move(condition), std::move(body));
+char Lexer::peekNext() const {
+    return pos_ + 1 < source_.size() ? source_[pos_ + 1] : '\0';
 }
 
-// --- parseUnionDecl ---
-std::unique_ptr<ASTNode> Parser::parseUnionDecl() {
-    std::cout << "[DEBUG] :: UnionDecl" << std::endl;
-    expect(TokenType::UNION, "Expected 'union'");
-    expect(TokenType::IDENTIFIER, "Expected union name");
-    std::string name = previous().text();
-
-    expect(TokenType::LEFT_BRACE, "Expected '{' after union name");
-    std::vector<std::unique_ptr<ASTNode>> members;
-    while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        members.push_back(parseVariableDecl());
-        expect(TokenType::SEMICOLON, "Expected ';' after union member");
+char Lexer::advance() {
+    char c = source_[pos_++];
+    if (c == '\n') {
+        ++line_;
+        lineStart_ = pos_;
     }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' after union body");
-    expect(TokenType::SEMICOLON, "Expected ';' after union declaration");
-   return std::make_unique<UnionDecl>(name, std::move(members));
+    return c;
 }
 
-// --- parseTypedefDecl ---
-std::unique_ptr<ASTNode> Parser::parseTypedefDecl() {
-    std::cout << "[DEBUG] :: TypedefDecl" << std::endl;
-    expect(TokenType::TYPEDEF, "Expected 'typedef'");
-    auto aliasedType = parseType(); 
-    expect(TokenType::IDENTIFIER, "Expected typedef alias name");
-    std::string name = previous().text();
-    expect(TokenType::SEMICOLON, "Expected ';' after typedef");
-    return std::make_unique<TypedefDecl>(name, std::move(aliasedType));
+bool Lexer::match(char expected) {
+    if (peek() != expected || isAtEnd()) return false;
+    advance();
+    return true;
 }
 
-// --- parseTemplateTypeSuffix ---
-std::unique_ptr<ASTNode> Parser::parseTemplateTypeSuffix(std::string baseName) {
-    std::cout << "[DEBUG] :: TemplateTypeSuffix" << std::endl;
-    expect(TokenType::LESS, "Expected '<' for template type");
-    std::vector<std::unique_ptr<ASTNode>> typeArgs;
-    do {
-        typeArgs.push_back(parseType());
-    } while (match(TokenType::COMMA));
-    expect(TokenType::GREATER, "Expected '>' after template arguments");
-    return std::make_unique<TemplateType>(baseName, std::move(typeArgs));
+bool Lexer::isAtEnd() const {
+    return pos_ >= source_.size();
 }
 
-// --- parseFunctionCallSuffix ---
-std::unique_ptr<ASTNode> Parser::parseFunctionCallSuffix(std::unique_ptr<ASTNode> callee) {
-    std::cout << "[DEBUG] :: FunctionCallSuffix" << std::endl;
-    std::vector<std::unique_ptr<ASTNode>> templateArgs;
-    // Check for template instantiation: foo<int>(...)
-    if (check(TokenType::LESS)) {
-        advance(); // consume '<'
-        do {
-            templateArgs.push_back(parseType());
-        } while (match(TokenType::COMMA));
-        expect(TokenType::GREATER, "Expected '>' after template arguments");
-    }
-    expect(TokenType::LEFT_PAREN, "Expected '(' after function name");
-    std::vector<std::unique_ptr<ASTNode>> args;
-    if (!check(TokenType::RIGHT_PAREN)) {
-        do {
-            args.push_back(parseExpression());
-        } while (match(TokenType::COMMA));
-    }
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after arguments");
-
-    // --- Recognize math and STL algorithm calls ---
-    std::string calleeName;
-    if (callee->type == ASTNodeType::IDENTIFIER) {
-        calleeName = static_cast<Identifier*>(callee.get())->name;
-    }
-    // Math functions
-    if (calleeName == "sqrt" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("sqrt", std::move(args));
-    }
-    if (calleeName == "pow" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("pow", std::move(args));
-    }
-    if (calleeName == "abs" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("abs", std::move(args));
-    }
-    if (calleeName == "fabs" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("fabs", std::move(args));
-    }
-    if (calleeName == "sin" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("sin", std::move(args));
-    }
-    if (calleeName == "cos" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("cos", std::move(args));
-    }
-    if (calleeName == "tan" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("tan", std::move(args));
-    }
-    if (calleeName == "floor" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("floor", std::move(args));
-    }
-    if (calleeName == "ceil" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("ceil", std::move(args));
-    }
-    if (calleeName == "round" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("round", std::move(args));
-    }
-    if (calleeName == "rand" && args.size() == 0) {
-        return std::make_unique<MathFunctionCall>("rand", std::move(args));
-    }
-    if (calleeName == "srand" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("srand", std::move(args));
-    }
-    // String/char functions
-    if (calleeName == "strcmp" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("strcmp", std::move(args));
-    }
-    if (calleeName == "strncmp" && args.size() == 3) {
-        return std::make_unique<MathFunctionCall>("strncmp", std::move(args));
-    }
-    if (calleeName == "strcpy" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("strcpy", std::move(args));
-    }
-    if (calleeName == "strncpy" && args.size() == 3) {
-        return std::make_unique<MathFunctionCall>("strncpy", std::move(args));
-    }
-    if (calleeName == "strlen" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("strlen", std::move(args));
-    }
-    if (calleeName == "strcat" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("strcat", std::move(args));
-    }
-    if (calleeName == "strncat" && args.size() == 3) {
-        return std::make_unique<MathFunctionCall>("strncat", std::move(args));
-    }
-    // STL algorithms
-    if (calleeName == "sort") {
-        return std::make_unique<SortCall>(std::move(args));
-    }
-    if (calleeName == "find") {
-        return std::make_unique<FindCall>(std::move(args));
-    }
-    if (calleeName == "accumulate") {
-        return std::make_unique<AccumulateCall>(std::move(args));
-    }
-    // Fallback: generic function call
-    return std::make_unique<FunctionCall>(std::move(callee), std::move(args), std::move(templateArgs));
+void Lexer::beginToken() {
+    tokenStartPos_ = pos_;
+    tokenLine_ = line_;
+    tokenColumn_ = static_cast<int>(pos_ - lineStart_) + 1;
 }
 
-
-// --- Expression Parsing with Precedence ---
-std::unique_ptr<ASTNode> Parser::parseExpression() {
-    std::cout << "[DEBUG] :: Expression" << std::endl;
-    return parseAssignment();
+void Lexer::countNewlines(size_t from, size_t to) {
+    const char* data = source_.data();
+    size_t count = countLineEnds(data + from, data + to);
+    if (count == 0) return;
+    line_ += static_cast<int>(count);
+    size_t last = to;
+    while (data[last - 1] != '\n') --last;
+    lineStart_ = last;
 }
 
-// --- Assignment Expression Parsing ---
-std::unique_ptr<ASTNode> Parser::parseAssignment() {
-    std::cout << "[DEBUG] :: Assignment" << std::endl;
-    auto left = parseTernary();
-    // Only allow assignment to identifiers, member access, or array access
-    if (match(TokenType::EQUAL)) {
-        auto right = parseAssignment();
-        return std::make_unique<AssignmentExpr>(std::move(left), std::move(right), "=");
-    }
-    if (match(TokenType::PLUS_EQUAL)) {
-        auto right = parseAssignment();
-        return std::make_unique<AssignmentExpr>(std::move(left), std::move(right), "+=");
-    }
-    if (match(TokenType::MINUS_EQUAL)) {
-        auto right = parseAssignment();
-        return std::make_unique<AssignmentExpr>(std::move(left), std::move(right), "-=");
-    }
-    if (match(TokenType::STAR_EQUAL)) {
-        auto right = parseAssignment();
-        return std::make_unique<AssignmentExpr>(std::move(left), std::move(right), "*=");
-    }
-    if (match(TokenType::SLASH_EQUAL)) {
-        auto right = parseAssignment();
-        return std::make_unique<AssignmentExpr>(std::move(left), std::move(right), "/=");
-    }
-    if (match(TokenType::PERCENT_EQUAL)) {
-        auto right = parseAssignment();
-        return std::make_unique<AssignmentExpr>(std::move(left), std::move(right), "%=");
+void Lexer::skipWhitespaceAndComments() {
+    const char* data = source_.data();
+    const size_t end = source_.size();
+    while (pos_ < end) {
+        uint8_t cls = charClass(data[pos_]);
+        if (cls == kSpace || cls == kNewline) {
+            size_t runEnd = scanWhitespace(data + pos_, data + end) - data;
+            int line = line_;
+            countNewlines(pos_, runEnd);
+            if (line_ != line) atLineStart_ = true;
+            pos_ = runEnd;
+        } else if (data[pos_] == '/' && pos_ + 1 < end && data[pos_ + 1] == '/') {
+            // Line comment; a trailing backslash splices the next line into it
+            size_t p = pos_ + 2;
+            while (true) {
+                p = scanLineEnd(data + p, data + end) - data;
+                size_t last = p;
+                while (last > pos_ && data[last - 1] == '\r') --last;
+                if (p == end || data[last - 1] != '\\') break;
+                ++p;
+                ++line_;
+                lineStart_ = p;
+            }
+            pos_ = p;
+        } else if (data[pos_] == '/' && pos_ + 1 < end && data[pos_ + 1] == '*') {
+            size_t close = scanBlockCommentEnd(data + pos_ + 2, data + end) - data;
+            if (close >= end) {
+                LOG_WARN(LogCategory::Lexer, "Unterminated block comment starting at line " << line_);
+            }
+            close = std::min(close + 2, end);
+            countNewlines(pos_, close);
+            pos_ = close;
+        } else if (data[pos_] == '\\' && pos_ + 1 < end && data[pos_ + 1] == '\n') {
+            // Line splice between tokens
+            pos_ += 2;
+            ++line_;
+            lineStart_ = pos_;
+        } else {
+            break;
+        }
     }
-    return left;
 }
 
+void Lexer::skipInactiveRegion() {
+    // A false branch is never tokenized. The scan jumps between the bytes that may start a
+    // directive, comment or literal, and only looks at a '#' that starts a line outside them;
+    // groups opened inside the region are counted here, and only the #elif/#else/#endif that
+    // may end the region goes through lexPreprocessorDirective. Lines are counted once per jump.
+    const char* data = source_.data();
+    const size_t end = source_.size();
+    int depth = 0;
+    size_t p = pos_;
+    while (skipping_) {
+        size_t hash = scanInactive(data + std::min(p, end), data + end) - data;
+        if (hash >= end) {
+            countNewlines(pos_, end);
+            pos_ = end;
+            break;
+        }
+        p = hash + 1;
+        char c = data[hash];
+        if (c == '/') {
+            if (p < end && data[p] == '*') {
+                // A '#' inside a block comment, even at the start of a line, is not a directive
+                p = std::min<size_t>(scanBlockCommentEnd(data + p + 1, data + end) - data + 2, end);
+            } else if (p < end && data[p] == '/') {
+                // Nor is one after "//" on the same line, or on lines the comment is spliced to
+                while (true) {
+                    p = scanLineEnd(data + p, data + end) - data;
+                    size_t last = p;
+                    while (last > hash && data[last - 1] == '\r') --last;
+                    if (p == end || data[last - 1] != '\\') break;
+                    ++p;
+                }
+            }
+            continue;
+        }
+        if (c != '#') {
+            // A literal ends at its closing quote or, since dead code may be prose with stray
+            // apostrophes, at the end of its line
+            while (p < end) {
+                p = scanLiteral(data + p, data + end, c) - data;
+                if (p >= end || data[p] != '\\') break;
+                p += 2;   // An escape, or a splice that continues the literal
+            }
+            if (p < end && data[p] == c) ++p;
+            continue;
+        }
+        size_t lineBegin = hash;
+        while (lineBegin > 0 && charClass(data[lineBegin - 1]) == kSpace) --lineBegin;
+        if (lineBegin > 0 && data[lineBegin - 1] != '\n') continue;
+        // A line joined to the previous one by a backslash does not start a directive
+        size_t before = lineBegin > 0 ? lineBegin - 1 : 0;
+        while (before > 0 && data[before - 1] == '\r') --before;
+        if (lineBegin > 0 && before > 0 && data[before - 1] == '\\') continue;
+
+        size_t nameStart = hash + 1;
+        while (nameStart < end && charClass(data[nameStart]) == kSpace) ++nameStart;
+        size_t nameEnd = scanIdentifier(data + nameStart, data + end) - data;
+        TokenType directive = directiveLookup(source_.substr(nameStart, nameEnd - nameStart));
+        switch (directive) {
+            case TokenType::PREPROCESSOR_IF:
+            case TokenType::PREPROCESSOR_IFDEF:
+            case TokenType::PREPROCESSOR_IFNDEF:
+                ++depth;
+                continue;
+            case TokenType::PREPROCESSOR_ENDIF:
+                if (depth > 0) {
+                    --depth;
+                    continue;
+                }
+                break;
+            case TokenType::PREPROCESSOR_ELIF:
+            case TokenType::PREPROCESSOR_ELSE:
+                if (depth > 0) continue;
+                break;
+            default:
+                continue;
+        }
+        countNewlines(pos_, hash);
+        pos_ = hash;
+        beginToken();
+        lexPreprocessorDirective();
+        p = pos_;
+    }
+    // Groups still open at the end of the input are reported like any other
+    conditionalStack_.insert(conditionalStack_.end(), depth, Conditional{false, true});
+    atLineStart_ = true;
+}
 
-std::unique_ptr<ASTNode> parseBinary(){
-    //implement
+// --- Token dispatch ---
 
-}
-std::unique_ptr<ASTNode> Parser::parseTernary() {
-    std::cout << "[DEBUG] :: Ternary" << std::endl;
-    auto cond = parseLogicalOr();
-    if (match(TokenType::QUESTION)) {
-        auto thenExpr = parseExpression();
-        expect(TokenType::COLON, "Expected ':' in ternary expression");
-        auto elseExpr = parseExpression();
-        return std::make_unique<TernaryExpr>(std::move(cond), std::move(thenExpr), std::move(elseExpr));
+bool Lexer::lexToken() {
+    skipWhitespaceAndComments();
+    beginToken();
+    if (isAtEnd()) {
+        addToken(TokenType::END_OF_FILE, "");
+        return false;
     }
-    return cond;
-}
 
-std::unique_ptr<ASTNode> Parser::parseLogicalOr() {
-    std::cout << "[DEBUG] :: LogicalOr" << std::endl;
-    auto left = parseLogicalAnd();
-    while (match(TokenType::OR_OR)) {
-        auto right = parseLogicalAnd();
-        // Defensive: Only construct BinaryExpr if both left and right are valid
-        if (!left || !right) {
-            // parseLogs.push_back("[WARNING] Invalid BinaryExpr (||) with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (||) with null child" << std::endl;
-            logFile.flush();
-            if (left) return left;
-            if (right) return right;
-            return nullptr;
+    switch (charClass(source_[pos_])) {
+        case kIdent:
+            lexIdentifierOrKeyword();
+            break;
+        case kDigit:
+            lexNumber();
+            break;
+        case kDoubleQuote:
+            lexString();
+            break;
+        case kSingleQuote:
+            lexChar();
+            break;
+        case kHash:
+            if (atLineStart_) {
+                lexPreprocessorDirective();
+            } else {
+                lexOperator();
+            }
+            break;
+        case kDot:
+            if (isDigit(peekNext())) {
+                lexNumber();
+            } else {
+                lexOperator();
+            }
+            break;
+        case kPunct:
+            lexOperator();
+            break;
+        default: {
+            char c = source_[pos_++];
+            addError(std::string("Unexpected character '") + c + "'");
+            break;
         }
-        left = std::make_unique<BinaryExpr>("||", std::move(left), std::move(right));
     }
-    return left;
+    return true;
 }
 
-std::unique_ptr<ASTNode> Parser::parseLogicalAnd() {
-    std::cout << "[DEBUG] :: LogicalAnd" << std::endl;
-    auto left = parseEquality();
-    while (match(TokenType::AND_AND)) {
-        auto right = parseEquality();
-        // Defensive: Only construct BinaryExpr if both left and right are valid
-        if (!left || !right) {
-            // parseLogs.push_back("[WARNING] Invalid BinaryExpr (&&) with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (&&) with null child" << std::endl;
-            logFile.flush();
-            if (left) return left;
-            if (right) return right;
-            return nullptr;
+void Lexer::lexOperator() {
+    const char* data = source_.data();
+    const size_t end = source_.size();
+    const OperatorDfa& dfa = kOperatorDfa;
+    uint8_t state = 1;
+    size_t p = pos_;
+    size_t acceptEnd = pos_;
+    TokenType accepted = TokenType::ERROR;
+    while (p < end) {
+        state = dfa.next[state][dfa.column[static_cast<unsigned char>(data[p])]];
+        if (!state) break;
+        ++p;
+        if (dfa.accept[state] != TokenType::ERROR) {
+            accepted = dfa.accept[state];
+            acceptEnd = p;
         }
-        left = std::make_unique<BinaryExpr>("&&", std::move(left), std::move(right));
     }
-    return left;
-}
-
-std::unique_ptr<ASTNode> Parser::parseEquality() {
-    std::cout << "[DEBUG] :: Equality" << std::endl;
-    auto left = parseRelational();
-    while (match(TokenType::EQUAL_EQUAL) || match(TokenType::NOT_EQUAL)) {
-        std::string op = previous().text();
-        auto right = parseRelational();
-        // Defensive: Only construct BinaryExpr if both left and right are valid
-        if (!left || !right) {
-            // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
-            if (left) return left;
-            if (right) return right;
-            return nullptr;
-        }
-        left = std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
+    if (accepted == TokenType::ERROR) {
+        char c = data[pos_++];
+        addError(std::string("Unexpected character '") + c + "'");
+        return;
     }
-    return left;
+    pos_ = acceptEnd;
+    addToken(accepted, source_.substr(tokenStartPos_, pos_ - tokenStartPos_));
 }
 
-std::unique_ptr<ASTNode> Parser::parseRelational() {
-    std::cout << "[DEBUG] :: Relational" << std::endl;
-    auto left = parseAdditive();
-    while (match(TokenType::LESS) || match(TokenType::LESS_EQUAL) ||
-           match(TokenType::GREATER) || match(TokenType::GREATER_EQUAL)) {
-        std::string op = previous().text();
-        auto right = parseAdditive();
-        // Defensive: Only construct BinaryExpr if both left and right are valid
-        if (!left || !right) {
-            // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
-            if (left) return left;
-            if (right) return right;
-            return nullptr;
-        }
-        left = std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
-    }
-    return left;
-}
+void Lexer::lexIdentifierOrKeyword() {
+    const char* data = source_.data();
+    const size_t end = source_.size();
+    size_t p = scanIdentifier(data + pos_ + 1, data + end) - data;
+    std::string_view word = source_.substr(pos_, p - pos_);
 
-std::unique_ptr<ASTNode> Parser::parseAdditive() {
-    std::cout << "[DEBUG] :: Additive" << std::endl;
-    auto left = parseMultiplicative();
-    while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        std::string op = previous().text();
-        auto right = parseMultiplicative();
-        // Defensive: Only construct BinaryExpr if both left and right are valid
-        if (!left || !right) {
-            // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
-            if (left) return left;
-            if (right) return right;
-            return nullptr;
-        }
-        left = std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
+    if (p < end && (data[p] == '"' || data[p] == '\'') && isLiteralPrefix(word)) {
+        pos_ = p;
+        return data[p] == '"' ? lexString() : lexChar();
     }
-    return left;
-}
+    pos_ = p;
 
-std::unique_ptr<ASTNode> Parser::parseMultiplicative() {
-    std::cout << "[DEBUG] :: Multiplicative" << std::endl;
-    auto left = parseUnary();
-    while (match(TokenType::STAR) || match(TokenType::SLASH) || match(TokenType::PERCENT)) {
-        std::string op = previous().text();
-        auto right = parseUnary();
-        // Defensive: Only construct BinaryExpr if both left and right are valid
-        if (!left || !right) {
-            // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
-            if (left) return left;
-            if (right) return right;
-            return nullptr;
-        }
-        left = std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
+    TokenType type = keywordLookup(word);
+    if (type != TokenType::IDENTIFIER) {
+        addToken(type, word);
+        return;
     }
-    return left;
-}
-
-std::unique_ptr<ASTNode> Parser::parseUnary() {
-    std::cout << "[DEBUG] :: Unary" << std::endl;
-    if (match(TokenType::EXCLAIM) || match(TokenType::MINUS) || match(TokenType::INCREMENT) || match(TokenType::DECREMENT)) {
-        std::string op = previous().text();
-        auto right = parseUnary();
-        return std::make_unique<UnaryExpr>(op, std::move(right));
+    Symbol symbol = intern(word);
+    if (!rawMode_ && !macros_.empty() && macros_.find(symbol)) {
+        expandMacroInto(word, symbol);
+        return;
     }
-    return parsePostfix();
+    addToken(type, word, symbol);
 }
 
-std::unique_ptr<ASTNode> Parser::parsePostfix() {
-    std::cout << "[DEBUG] :: Postfix" << std::endl;
-    auto expr = parsePrimary();
-    while (true) {
-        if (check(TokenType::LEFT_PAREN)) {
-            expr = parseFunctionCallSuffix(std::move(expr));
-        } else if (match(TokenType::LEFT_BRACKET)) {
-            auto index = parseExpression();
-            expect(TokenType::RIGHT_BRACKET, "Expected ']' after array index");
-            expr = std::make_unique<ArrayAccess>(std::move(expr), std::move(index));
-        } else if (match(TokenType::DOT) || match(TokenType::ARROW)) {
-            std::string memberOp = previous().text();
-            expect(TokenType::IDENTIFIER, "Expected member name after '.' or '->'");
-            std::string member = previous().text();
-            expr = std::make_unique<MemberAccess>(std::move(expr), member, memberOp == "->");
-        } else if (match(TokenType::SCOPE)) {
-            expect(TokenType::IDENTIFIER, "Expected identifier after '::'");
-            std::string name = previous().text();
-            expr = std::make_unique<QualifiedName>(std::move(expr), name);
-        } else if (match(TokenType::INCREMENT)) {
-            // Postfix increment: j++
-            expr = std::make_unique<UnaryExpr>("++", std::move(expr), true);
-        } else if (match(TokenType::DECREMENT)) {
-            // Postfix decrement: j--
-            expr = std::make_unique<UnaryExpr>("--", std::move(expr), true);
-        } else {
-            break;
-        }
-    }
-    return expr;
+void Lexer::lexNumber() {
+    bool isFloat = false;
+    pos_ = ppNumberEnd(source_.data(), pos_, source_.size(), isFloat);
+    addToken(isFloat ? TokenType::FLOAT : TokenType::INTEGER, source_.substr(tokenStartPos_, pos_ - tokenStartPos_));
 }
 
-
-std::unique_ptr<ASTNode> Parser::parsePrimary() {
-    std::cout << "[DEBUG] :: Primary" << std::endl;
-    // C++ casts
-    if (match(TokenType::STATIC_CAST)) {
-        expect(TokenType::LESS, "Expected '<' after static_cast");
-        auto type = parseType();
-        expect(TokenType::GREATER, "Expected '>' after type");
-        expect(TokenType::LEFT_PAREN, "Expected '(' after '>'");
-        auto expr = parseExpression();
-        expect(TokenType::RIGHT_PAREN, "Expected ')'");
-        return std::make_unique<StaticCastExpr>(std::move(type), std::move(expr));
-    }
-    if (match(TokenType::DYNAMIC_CAST)) {
-        expect(TokenType::LESS, "Expected '<' after dynamic_cast");
-        auto type = parseType();
-        expect(TokenType::GREATER, "Expected '>' after type");
-        expect(TokenType::LEFT_PAREN, "Expected '(' after '>'");
-        auto expr = parseExpression();
-        expect(TokenType::RIGHT_PAREN, "Expected ')'");
-        return std::make_unique<DynamicCastExpr>(std::move(type), std::move(expr));
-    }
-    if (match(TokenType::CONST_CAST)) {
-        expect(TokenType::LESS, "Expected '<' after const_cast");
-        auto type = parseType();
-        expect(TokenType::GREATER, "Expected '>' after type");
-        expect(TokenType::LEFT_PAREN, "Expected '(' after '>'");
-        auto expr = parseExpression();
-        expect(TokenType::RIGHT_PAREN, "Expected ')'");
-        return std::make_unique<ConstCastExpr>(std::move(type), std::move(expr));
-    }
-    if (match(TokenType::REINTERPRET_CAST)) {
-        expect(TokenType::LESS, "Expected '<' after reinterpret_cast");
-        auto type = parseType();
-        expect(TokenType::GREATER, "Expected '>' after type");
-        expect(TokenType::LEFT_PAREN, "Expected '(' after '>'");
-        auto expr = parseExpression();
-        expect(TokenType::RIGHT_PAREN, "Expected ')'");
-        return std::make_unique<ReinterpretCastExpr>(std::move(type), std::move(expr));
-    }
-
-    // new/delete
-    if (match(TokenType::NEW)) {
-        auto type = parseType();
-        std::vector<std::unique_ptr<ASTNode>> args;
-        if (match(TokenType::LEFT_PAREN)) {
-            if (!check(TokenType::RIGHT_PAREN)) {
-                do {
-                    args.push_back(parseExpression());
-                } while (match(TokenType::COMMA));
-            }
-            expect(TokenType::RIGHT_PAREN, "Expected ')' after new arguments");
+void Lexer::lexString() {
+    // pos_ is on the opening quote; an encoding prefix, if any, starts at tokenStartPos_
+    const char* data = source_.data();
+    const size_t end = source_.size();
+
+    if (pos_ > tokenStartPos_ && data[pos_ - 1] == 'R') {
+        // Raw string R"delim( ... )delim": rewritten as an ordinary escaped literal so the
+        // parser and code generator need not know about raw strings
+        size_t open = source_.find('(', pos_ + 1);
+        if (open == std::string_view::npos || open - pos_ - 1 > 16) {
+            pos_ = end;
+            addError("Malformed raw string literal");
+            return;
         }
-        return std::make_unique<NewExpr>(std::move(type), std::move(args));
-    }
-    if (match(TokenType::DELETE)) {
-        bool isArrayDelete = false;
-        if (match(TokenType::LEFT_BRACKET)) {
-            expect(TokenType::RIGHT_BRACKET, "Expected ']' after '[' in delete[]");
-            isArrayDelete = true;
+        std::string closing = ")" + std::string(source_.substr(pos_ + 1, open - pos_ - 1)) + "\"";
+        size_t close = source_.find(closing, open + 1);
+        if (close == std::string_view::npos) {
+            pos_ = end;
+            addError("Unterminated raw string literal");
+            return;
         }
-        auto expr = parseExpression();
-        return std::make_unique<DeleteExpr>(std::move(expr), isArrayDelete);
+        std::string text;
+        for (size_t i = open + 1; i < close; ++i) {
+            char c = data[i];
+            if (c == '\\' || c == '"') text += '\\';
+            if (c == '\n') {
+                text += "\\n";
+                continue;
+            }
+            text += c;
+        }
+        countNewlines(pos_, close);
+        pos_ = close + closing.size();
+        addToken(TokenType::STRING_LITERAL, text);
+        return;
     }
 
-    // Lambda
-    if (match(TokenType::LEFT_BRACKET)) {
-        // Parse capture list (skip for now)
-        while (!match(TokenType::RIGHT_BRACKET)) advance();
-        expect(TokenType::LEFT_PAREN, "Expected '(' after lambda capture");
-        std::vector<std::unique_ptr<ASTNode>> params;
-        if (!check(TokenType::RIGHT_PAREN)) {
-            do {
-                auto type = parseType();
-                expect(TokenType::IDENTIFIER, "Expected parameter name");
-                std::string name = previous().text();
-                params.push_back(std::make_unique<VarDecl>(name, std::move(type)));
-            } while (match(TokenType::COMMA));
+    size_t p = pos_ + 1;
+    while (true) {
+        p = scanLiteral(data + p, data + end, '"') - data;
+        if (p >= end || data[p] == '\n') {
+            pos_ = p;
+            addError("Unterminated string literal");
+            return;
         }
-        expect(TokenType::RIGHT_PAREN, "Expected ')' after lambda params");
-        auto body = parseBlock();
-        return std::make_unique<LambdaExpr>(std::move(params), std::move(body));
+        if (data[p] == '"') break;
+        // Backslash: skip the escaped byte; an escaped newline is a line splice
+        if (p + 1 < end && data[p + 1] == '\n') {
+            ++line_;
+            lineStart_ = p + 2;
+        }
+        p += 2;
     }
+    std::string_view contents = source_.substr(pos_ + 1, p - pos_ - 1);
+    pos_ = p + 1;
+    addToken(TokenType::STRING_LITERAL, contents);
+}
 
-    // Literals
-    if (match(TokenType::INTEGER)) {
-        return std::make_unique<Literal>(previous().text(), "int");
-    }
-    if (match(TokenType::FLOAT)) {
-        return std::make_unique<Literal>(previous().text(), "float");
-    }
-    if (match(TokenType::STRING_LITERAL)) {
-        return std::make_unique<Literal>(previous().text(), "string");
-    }
-    if (match(TokenType::CHARACTER)) {
-        return std::make_unique<Literal>(previous().text(), "char");
-    }
-    // --- I/O Streams ---
-    if (match(TokenType::COUT)) {
-        return std::make_unique<CoutExpr>(std::vector<std::unique_ptr<ASTNode>>{});
-    }
-    if (match(TokenType::CERR)) {
-        return std::make_unique<CerrExpr>(std::vector<std::unique_ptr<ASTNode>>{});
-    }
-    if (match(TokenType::CIN)) {
-        return std::make_unique<CinExpr>(std::vector<std::unique_ptr<ASTNode>>{});
-    }
-    // --- Initializer List ---
-    if (match(TokenType::LEFT_BRACE)) {
-        std::vector<std::unique_ptr<ASTNode>> elements;
-        if (!check(TokenType::RIGHT_BRACE)) {
-            do {
-                elements.push_back(parseExpression());
-            } while (match(TokenType::COMMA));
+void Lexer::lexChar() {
+    const char* data = source_.data();
+    const size_t end = source_.size();
+    size_t p = pos_ + 1;
+    while (true) {
+        p = scanLiteral(data + p, data + end, '\'') - data;
+        if (p >= end || data[p] == '\n') {
+            pos_ = p;
+            addError("Unterminated character literal");
+            return;
         }
-        expect(TokenType::RIGHT_BRACE, "Expected '}' after initializer list");
-        return std::make_unique<InitializerListExpr>(std::move(elements));
-    }
-    // Identifier
-    if (match(TokenType::IDENTIFIER)) {
-        return std::make_unique<Identifier>(previous().text());
+        if (data[p] == '\'') break;
+        // Backslash: skip the escaped byte; an escaped newline is a line splice
+        if (p + 1 < end && data[p + 1] == '\n') {
+            ++line_;
+            lineStart_ = p + 2;
+        }
+        p += 2;
     }
-
-    // Parenthesized expression
-    if (match(TokenType::LEFT_PAREN)) {
-        auto expr = parseExpression();
-        expect(TokenType::RIGHT_PAREN, "Expected ')'");
-        return expr;
+    std::string_view contents = source_.substr(pos_ + 1, p - pos_ - 1);
+    pos_ = p + 1;
+    if (contents.empty()) {
+        addError("Empty character literal");
+        return;
     }
-
-    throw std::runtime_error("Unexpected token in expression");
+    addToken(TokenType::CHARACTER, contents);
 }
 
-// --- parseCatchStmt ---
-std::unique_ptr<CatchStmt> Parser::parseCatchStmt() {
-    std::cout << "[DEBUG] :: CatchStmt" << std::endl;
-    expect(TokenType::CATCH, "Expected 'catch'");
-    expect(TokenType::LEFT_PAREN, "Expected '(' after 'catch'");
-    auto exceptionType = parseType();
-    expect(TokenType::IDENTIFIER, "Expected exception variable name");
-    std::string name = previous().text();
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after catch parameter");
-    auto bodyNode = parseBlock();
-    auto body = std::unique_ptr<BlockStmt>(static_cast<BlockStmt*>(bodyNode.release()));
-    return std::make_unique<CatchStmt>(std::move(exceptionType), name, std::move(body));
-}
+// --- Preprocessor ---
 
-
-std::unique_ptr<ASTNode> Parser::parseType() {
-    std::cout << "[DEBUG] :: Type" << std::endl;
-    // Accept all valid type tokens, not just IDENTIFIER
-    if (!isTypeToken(current.type())) {
-        throw std::runtime_error("Expected type name (at line " + std::to_string(current.line()) + ", column " + std::to_string(current.column()) + ", token: '" + current.text() + "')");
+std::string Lexer::readDirectiveRest() {
+    // Leaves pos_ on the terminating newline so the caller's line accounting sees it
+    std::string rest;
+    while (!isAtEnd() && peek() != '\n') {
+        char c = peek();
+        if (c == '\\' && (peekNext() == '\n' || (peekNext() == '\r' && pos_ + 2 < source_.size() && source_[pos_ + 2] == '\n'))) {
+            if (peekNext() == '\r') advance();
+            advance();
+            advance();
+            rest += ' ';
+        } else if (c == '/' && peekNext() == '/') {
+            while (!isAtEnd() && peek() != '\n') advance();
+        } else if (c == '/' && peekNext() == '*') {
+            advance();
+            advance();
+            while (!isAtEnd() && !(peek() == '*' && peekNext() == '/')) advance();
+            if (!isAtEnd()) {
+                advance();
+                advance();
+            }
+            rest += ' ';
+        } else if (c == '"' || c == '\'') {
+            rest += advance();
+            while (!isAtEnd() && peek() != c && peek() != '\n') {
+                if (peek() == '\\' && peekNext() != '\n') rest += advance();
+                rest += advance();
+            }
+            if (match(c)) rest += c;
+        } else {
+            rest += advance();
+        }
     }
-    std::string base = current.text();
+    return std::string(trim(rest));
+}
+
+void Lexer::lexPreprocessorDirective() {
+    // tokenStartPos_ is on the '#'. Directive tokens are appended to tokens_ directly:
+    // HASH, the PREPROCESSOR_* keyword, then the arguments the parser expects for it.
+    int hashLine = tokenLine_;
+    int hashColumn = tokenColumn_;
     advance();
-    std::unique_ptr<ASTNode> typeNode = std::make_unique<Identifier>(base);
-    // Built-in types: int, float, double, char, bool, void
-    switch (prev.type()) {
-        case TokenType::INT:
-        case TokenType::FLOAT_TYPE:
-        case TokenType::DOUBLE:
-        case TokenType::CHAR:
-        case TokenType::BOOL:
-        case TokenType::VOID:
-            // Use QualifiedType for built-in types
-            typeNode = std::make_unique<QualifiedType>(base);
+    while (!isAtEnd() && charClass(peek()) == kSpace) advance();
+
+    beginToken();
+    size_t nameStart = pos_;
+    while (!isAtEnd() && isIdentChar(peek())) advance();
+    std::string_view name = source_.substr(nameStart, pos_ - nameStart);
+    TokenType directive = name.empty() ? TokenType::PREPROCESSOR_UNKNOWN : directiveLookup(name);
+    int nameColumn = tokenColumn_;
+
+    while (!isAtEnd() && charClass(peek()) == kSpace) advance();
+    beginToken();
+    std::string rest = readDirectiveRest();
+    if (name.empty() && rest.empty()) return;   // Null directive: a lone '#'
+
+    auto firstIdentifier = [&rest]() {
+        size_t end = 0;
+        while (end < rest.size() && isIdentChar(rest[end])) ++end;
+        return rest.substr(0, end);
+    };
+
+    bool active = !skipping_;
+    bool parentActive = conditionalStack_.size() < 2 || conditionalStack_[conditionalStack_.size() - 2].active;
+    bool emit = active;
+    switch (directive) {
+        case TokenType::PREPROCESSOR_IFDEF:
+        case TokenType::PREPROCESSOR_IFNDEF: {
+            bool defined = isMacroDefined(firstIdentifier());
+            pushConditional(directive == TokenType::PREPROCESSOR_IFDEF ? defined : !defined);
             break;
-        case TokenType::IDENTIFIER:
-            typeNode = std::make_unique<Identifier>(base);
+        }
+        case TokenType::PREPROCESSOR_IF:
+            pushConditional(active && evalCondition(rest));
+            break;
+        case TokenType::PREPROCESSOR_ELIF:
+        case TokenType::PREPROCESSOR_ELSE:
+        case TokenType::PREPROCESSOR_ENDIF: {
+            if (conditionalStack_.empty()) {
+                if (active) addError("#" + std::string(name) + " without #if");
+                return;
+            }
+            emit = parentActive;
+            Conditional& top = conditionalStack_.back();
+            if (directive == TokenType::PREPROCESSOR_ENDIF) {
+                conditionalStack_.pop_back();
+            } else if (top.taken) {
+                top.active = false;
+            } else {
+                top.active = parentActive &&
+                    (directive == TokenType::PREPROCESSOR_ELSE || evalCondition(rest));
+                top.taken = top.active;
+            }
+            updateSkipping();
             break;
+        }
         default:
-            typeNode = std::make_unique<Identifier>(base);
             break;
     }
-    // Handle qualified types: A::B::C
-    while (match(TokenType::SCOPE)) {
-        expect(TokenType::IDENTIFIER, "Expected identifier after '::' in qualified type");
-        std::string right = previous().text();
-        typeNode = std::make_unique<QualifiedName>(std::move(typeNode), right);
-    }
-    // Handle template types: vector<int>
-    if (match(TokenType::LESS)) {
-        std::vector<std::unique_ptr<ASTNode>> typeArgs;
-        do {
-            typeArgs.push_back(parseType());
-        } while (match(TokenType::COMMA));
-        expect(TokenType::GREATER, "Expected '>' after template arguments");
-        // Wrap in TemplateType
-        if (typeNode->type == ASTNodeType::IDENTIFIER) {
-            std::string baseName = static_cast<Identifier*>(typeNode.get())->name;
-            typeNode = std::make_unique<TemplateType>(baseName, std::move(typeArgs));
-        } else if (typeNode->type == ASTNodeType::QUALIFIED_TYPE) {
-            // For qualified template types (e.g., std::vector)
-            std::string baseName = "";
-            ASTNode* cur = typeNode.get();
-            while (cur && cur->type == ASTNodeType::QUALIFIED_TYPE) {
-                auto* qn = static_cast<QualifiedName*>(cur);
-                baseName = qn->right + (baseName.empty() ? "" : "::" + baseName);
-                cur = qn->left.get();
+    if (!emit) return;
+    LOG_DEBUG(LogCategory::Lexer, "#" << name << " " << rest);
+
+    addTokenAt(TokenType::HASH, "#", hashLine, hashColumn);
+    addTokenAt(directive, name, hashLine, nameColumn);
+    switch (directive) {
+        case TokenType::PREPROCESSOR_INCLUDE: {
+            char close = rest.empty() ? '\0' : rest[0] == '"' ? '"' : rest[0] == '<' ? '>' : '\0';
+            size_t closePos = close ? rest.find(close, 1) : std::string::npos;
+            if (closePos == std::string::npos) {
+                // Computed include (#include MACRO): hand the expanded text over as the header
+                std::string expanded = expandMacro(rest);
+                addToken(TokenType::STRING, expanded);
+                close = expanded.empty() ? '\0' : expanded[0] == '"' ? '"' : expanded[0] == '<' ? '>' : '\0';
+                closePos = close ? expanded.find(close, 1) : std::string::npos;
+                if (includes_ && closePos != std::string::npos) {
+                    includeHeader(expanded.substr(1, closePos - 1), close == '"');
+                }
+                break;
             }
-            if (cur && cur->type == ASTNodeType::IDENTIFIER) {
-                baseName = static_cast<Identifier*>(cur)->name + (baseName.empty() ? "" : "::" + baseName);
+            if (close == '"') {
+                addToken(TokenType::STRING, std::string_view(rest).substr(1, closePos - 1));
+            } else {
+                addToken(TokenType::LESS, "<");
+                addToken(TokenType::IDENTIFIER, std::string_view(rest).substr(1, closePos - 1));
+                addToken(TokenType::GREATER, ">");
             }
-            typeNode = std::make_unique<TemplateType>(baseName, std::move(typeArgs));
+            if (includes_) includeHeader(rest.substr(1, closePos - 1), close == '"');
+            break;
         }
-    }
-    // Handle pointer (*) and reference (&) types
-    while (true) {
-        if (match(TokenType::STAR)) {
-            typeNode = std::make_unique<PointerType>(std::move(typeNode));
-        } else if (match(TokenType::AMPERSAND)) {
-            typeNode = std::make_unique<ReferenceType>(std::move(typeNode));
-        } else {
+        case TokenType::PREPROCESSOR_DEFINE: {
+            std::string macro = firstIdentifier();
+            if (macro.empty()) {
+                addError("Expected macro name after #define");
+                break;
+            }
+            std::string_view body = std::string_view(rest).substr(macro.size());
+            addToken(TokenType::IDENTIFIER, macro);
+            // The value is always present (possibly empty) so the parser never mistakes the
+            // next line's first token for it
+            addToken(TokenType::STRING, trim(body));
+            std::string error;
+            if (auto definition = parseMacroDefinition(macro, body, error)) {
+                macros_.define(std::move(definition));
+            } else {
+                addError(error);
+            }
             break;
         }
+        case TokenType::PREPROCESSOR_UNDEF:
+        case TokenType::PREPROCESSOR_IFDEF:
+        case TokenType::PREPROCESSOR_IFNDEF: {
+            std::string macro = firstIdentifier();
+            if (macro.empty()) {
+                addError("Expected macro name after #" + std::string(name));
+                break;
+            }
+            addToken(TokenType::IDENTIFIER, macro);
+            if (directive == TokenType::PREPROCESSOR_UNDEF) macros_.undefine(macro);
+            break;
+        }
+        case TokenType::PREPROCESSOR_PRAGMA:
+            if (includes_ && rest == "once") {
+                includes_->once.insert(path_);
+                onceFiles_.push_back(path_);
+            }
+            addToken(TokenType::STRING, rest);
+            break;
+        case TokenType::PREPROCESSOR_IF:
+        case TokenType::PREPROCESSOR_ELIF:
+            addToken(TokenType::STRING, rest);
+            break;
+        default:
+            break;   // #else, #endif and unknown directives carry no arguments
     }
-    return typeNode;
 }
 
+void Lexer::enableIncludes(HeaderCache& cache, const std::string& path) {
+    includes_ = std::make_shared<IncludeState>();
+    includes_->cache = &cache;
+    path_ = path;
+}
 
-std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
-    std::cout << "[DEBUG] :: PreprocessorDirective" << std::endl;
-    if (!match(TokenType::HASH)) return nullptr;
+PreprocessorState Lexer::saveState() const {
+    PreprocessorState state;
+    state.macros = macros_.share();
+    state.conditionals = conditionalStack_;
+    state.onceFiles = onceFiles_;
+    return state;
+}
 
+void Lexer::restoreState(const PreprocessorState& state) {
+    // The table is shared until this file changes it, and definitions are never re-parsed
+    macros_.copyDefinitions(state.macros);
+    conditionalStack_ = state.conditionals;
+    updateSkipping();
+    onceFiles_ = state.onceFiles;
+    if (includes_) includes_->once.insert(state.onceFiles.begin(), state.onceFiles.end());
+}
 
-    if (match(TokenType::PREPROCESSOR_INCLUDE)) {
-        // Support both #include "..." and #include <...>
-        std::string header;
-        if (check(TokenType::STRING)) {
-            expect(TokenType::STRING, "Expected header after #include");
-            header = previous().text();
-        } else if (check(TokenType::LESS)) {
-            // Parse <...> as a header
-            expect(TokenType::LESS, "Expected '<' after #include");
-            std::string headerText;
-            while (!check(TokenType::GREATER) && !isAtEnd()) {
-                headerText += current.text();
-                advance();
-            }
-            expect(TokenType::GREATER, "Expected '>' after header name");
-            header = "<" + headerText + ">";
-        } else {
-            throw std::runtime_error("Expected header after #include (either \"...\" or <...>)");
+void Lexer::includeHeader(const std::string& name, bool quoted) {
+    HeaderCache& cache = *includes_->cache;
+    std::string path = cache.resolve(name, quoted, path_);
+    if (path.empty()) {
+        LOG_DEBUG(LogCategory::Lexer, "Header '" << name << "' not found; its macros are not seen");
+        return;
+    }
+    if (includes_->once.count(path)) {
+        onceSkipped_.push_back(path);
+        cache.noteSkipped();
+        return;
+    }
+    const auto& open = includes_->open;
+    if (path == path_ || std::find(open.begin(), open.end(), path) != open.end()) {
+        LOG_WARN(LogCategory::Lexer, "#include of '" << name << "' at line " << tokenLine_ << " is recursive; ignored");
+        return;
+    }
+    std::shared_ptr<const HeaderSource> header = cache.source(path);
+    if (!header) {
+        LOG_WARN(LogCategory::Lexer, "Could not read header '" << path << "'");
+        return;
+    }
+    if (cache.guarded(*header, macros_)) {
+        cache.noteSkipped();
+        return;
+    }
+
+    std::shared_ptr<const HeaderUnit> unit = cache.find(*header, macros_, includes_->once);
+    if (!unit) {
+        // Lex the header with this file's macros, noting every name it looks up: those, as
+        // defined here, are what the result depends on
+        Lexer lexer(*header->text, header->text);
+        lexer.macros_.copyDefinitions(macros_);
+        lexer.macros_.recordLookups();
+        lexer.includes_ = includes_;
+        lexer.path_ = path;
+        includes_->open.push_back(path_);
+        TokenBuffer tokens = lexer.tokenize();
+        includes_->open.pop_back();
+
+        auto made = std::make_shared<HeaderUnit>();
+        made->tokens = std::move(tokens);
+        for (Symbol symbol : lexer.macros_.lookups()) {
+            const Macro* macro = macros_.find(symbol);
+            made->dependencies.push_back({std::string(spellingOf(symbol)), symbol, macro ? macro->hash : 0});
         }
-        return std::make_unique<PreprocessorInclude>(header);
-    }
-    if (match(TokenType::PREPROCESSOR_DEFINE)) {
-        expect(TokenType::IDENTIFIER, "Expected macro name after #define");
-        std::string macro = previous().text();
-        std::string value;
-        // Optionally parse the macro value (until end of line)
-        if (!check(TokenType::NEWLINE) && !isAtEnd()) {
-            value = current.text();
-            advance();
+        for (const auto& [symbol, macro] : lexer.macros_.definitions()) {
+            const Macro* before = macros_.find(symbol);
+            if (!before || before->hash != macro->hash) made->defines.push_back(macro);
         }
-        return std::make_unique<PreprocessorDefine>(macro, value);
-    }
-    if (match(TokenType::PREPROCESSOR_UNDEF)) {
-        expect(TokenType::IDENTIFIER, "Expected macro name after #undef");
-        std::string macro = previous().text();
-        return std::make_unique<PreprocessorUndef>(macro);
-    }
-    if (match(TokenType::PREPROCESSOR_IFDEF)) {
-        expect(TokenType::IDENTIFIER, "Expected macro name after #ifdef");
-        std::string macro = previous().text();
-        return std::make_unique<PreprocessorIfdef>(macro);
-    }
-    if (match(TokenType::PREPROCESSOR_IFNDEF)) {
-        expect(TokenType::IDENTIFIER, "Expected macro name after #ifndef");
-        std::string macro = previous().text();
-        return std::make_unique<PreprocessorIfndef>(macro);
-    }
-    if (match(TokenType::PREPROCESSOR_IF)) {
-        // Optionally parse the condition as a string or expression
-        std::string condition = current.text();
-        advance();
-        return std::make_unique<PreprocessorIf>(condition);
-    }
-    if (match(TokenType::PREPROCESSOR_ELSE)) {
-        return std::make_unique<PreprocessorElse>();
-    }
-    if (match(TokenType::PREPROCESSOR_ELIF)) {
-        std::string condition = current.text();
-        advance();
-        return std::make_unique<PreprocessorElif>(condition);
-    }
-    if (match(TokenType::PREPROCESSOR_ENDIF)) {
-        return std::make_unique<PreprocessorEndif>();
-    }
-    if (match(TokenType::PREPROCESSOR_PRAGMA)) {
-        std::string pragma = current.text();
-        advance();
-        return std::make_unique<PreprocessorPragma>(pragma);
-    }
-
-    // Unknown or unsupported directive
-    std::string unknown = current.text();
-    std::ostringstream err;
-    err << "Unknown or unsupported preprocessor directive: '" << unknown << "' at token '" << current.text() << "' (line " << current.line() << ", col " << current.column() << ")";
-    std::cerr << err.str() << std::endl;
-    advance();
-    return std::make_unique<PreprocessorUnknown>(unknown);
-}
-
-// --- parseEnumDecl ---
-std::unique_ptr<ASTNode> Parser::parseEnumDecl() {
-    std::cout << "[DEBUG] :: EnumDecl" << std::endl;
-    expect(TokenType::ENUM, "Expected 'enum'");
-    expect(TokenType::IDENTIFIER, "Expected enum name");
-    std::string name = previous().text();
-    expect(TokenType::LEFT_BRACE, "Expected '{' after enum name");
-    auto enumNode = std::make_unique<EnumDecl>(name);
-    int value = 0;
-    while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        expect(TokenType::IDENTIFIER, "Expected enumerator name");
-        std::string enumerator = previous().text();
-        int enumValue = value;
-        if (match(TokenType::EQUAL)) {
-            // Parse explicit value
-            auto valNode = parseExpression();
-            if (valNode->type == ASTNodeType::LITERAL) {
-                enumValue = std::stoi(static_cast<Literal*>(valNode.get())->value);
-            } else {
-                throw std::runtime_error("Enum value must be an integer literal");
+        for (const auto& [symbol, macro] : macros_.definitions()) {
+            if (!lexer.macros_.find(symbol)) made->undefines.push_back(macro->name);
+        }
+        made->guard = detectIncludeGuard(made->tokens);
+        made->onceFiles = std::move(lexer.onceFiles_);
+        for (auto& [nested, hash] : lexer.included_) made->included.push_back({std::move(nested), hash});
+        // Skips of headers the header included itself hold wherever the unit is reused
+        for (const auto& skipped : lexer.onceSkipped_) {
+            if (std::find(made->onceFiles.begin(), made->onceFiles.end(), skipped) == made->onceFiles.end() &&
+                std::find(made->onceSkipped.begin(), made->onceSkipped.end(), skipped) == made->onceSkipped.end()) {
+                made->onceSkipped.push_back(skipped);
             }
-            value = enumValue;
         }
-        enumNode->enumerators.emplace_back(enumerator, enumValue);
-        value++;
-        if (!match(TokenType::COMMA)) break;
-    }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' after enum body");
-    if (match(TokenType::SEMICOLON)) {
-        // optional
-    }
-    return enumNode;
+        cache.insert(*header, made);
+        unit = std::move(made);
+    }
+    for (const auto& macro : unit->defines) macros_.define(macro);
+    for (const auto& name : unit->undefines) macros_.undefine(name);
+    for (const auto& once : unit->onceFiles) {
+        includes_->once.insert(once);
+        onceFiles_.push_back(once);
+    }
+    onceSkipped_.insert(onceSkipped_.end(), unit->onceSkipped.begin(), unit->onceSkipped.end());
+    included_.emplace_back(path, header->hash);
+    for (const auto& nested : unit->included) included_.emplace_back(nested.path, nested.hash);
 }
 
-// --- parseNamespaceDecl ---
-std::unique_ptr<ASTNode> Parser::parseNamespaceDecl() {
-    std::cout << "[DEBUG] :: NamespaceDecl" << std::endl;
-    expect(TokenType::NAMESPACE, "Expected 'namespace'");
-    expect(TokenType::IDENTIFIER, "Expected namespace name");
-    std::string name = previous().text();
-    expect(TokenType::LEFT_BRACE, "Expected '{' after namespace name");
-    auto nsNode = std::make_unique<NamespaceDecl>(name);
-    while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        nsNode->declarations.push_back(parseDeclaration());
-    }
-    expect(TokenType::RIGHT_BRACE, "Expected '}' after namespace body");
-    if (match(TokenType::SEMICOLON)) {
-        // optional
-    }
-    return nsNode;
+bool Lexer::isMacroDefined(const std::string& name) const {
+    return macros_.isDefined(name);
 }
 
-// --- parseUsingDirective ---
-std::unique_ptr<ASTNode> Parser::parseUsingDirective() {
-    std::cout << "[DEBUG] :: UsingDirective" << std::endl;
-    expect(TokenType::USING, "Expected 'using' directive");
-    if (match(TokenType::NAMESPACE)) {
-        expect(TokenType::IDENTIFIER, "Expected namespace name after 'using namespace'");
-        std::string ns = previous().text();
-        expect(TokenType::SEMICOLON, "Expected ';' after using directive");
-        return std::make_unique<UsingDirective>(ns);
-    } else {
-        throw std::runtime_error("Only 'using namespace' directives are supported");
-    }
+void Lexer::pushConditional(bool condition) {
+    // Inside a false branch nested groups are dead too, and marked taken so no #else revives them
+    bool parentActive = !skipping_;
+    conditionalStack_.push_back({parentActive && condition, !parentActive || condition});
+    updateSkipping();
 }
 
-// --- parseIfStmt ---
-std::unique_ptr<ASTNode> Parser::parseIfStmt() {
-    std::cout << "[DEBUG] :: IfStmt" << std::endl;
-    expect(TokenType::IF, "Expected 'if'");
-    expect(TokenType::LEFT_PAREN, "Expected '(' after 'if'");
-    auto condition = parseExpression();
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after if condition");
-    auto thenBranch = parseStatement();
-    std::unique_ptr<ASTNode> elseBranch = nullptr;
-    if (match(TokenType::ELSE)) {
-        elseBranch = parseStatement();
-    }
-    return std::make_unique<IfStmt>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
+void Lexer::updateSkipping() {
+    // A group is only ever active when its parent is, so the innermost entry decides
+    skipping_ = !conditionalStack_.empty() && !conditionalStack_.back().active;
 }
 
-// --- parseWhileStmt ---
-std::unique_ptr<ASTNode> Parser::parseWhileStmt() {
-    std::cout << "[DEBUG] :: WhileStmt" << std::endl;
-    expect(TokenType::WHILE, "Expected 'while'");
-    expect(TokenType::LEFT_PAREN, "Expected '(' after 'while'");
-    auto condition = parseExpression();
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after while condition");
-    auto body = parseStatement();
-    return std::make_unique<WhileStmt>(std::move(condition), std::move(body));
+std::string Lexer::expandMacro(const std::string& text, bool ifCondition) {
+    if (macros_.empty()) return text;
+    std::vector<PPToken> tokens = lexFragment(tokens_.storage()->store(text), *tokens_.storage());
+    return spellTokens(macros_.expandAll(tokens, ifCondition));
 }
 
-// --- parseForStmt ---
-std::unique_ptr<ASTNode> Parser::parseForStmt() {
-    std::cout << "[DEBUG] :: ForStmt" << std::endl;
-    expect(TokenType::FOR, "Expected 'for'");
-    expect(TokenType::LEFT_PAREN, "Expected '(' after 'for'");
-    std::unique_ptr<ASTNode> init = nullptr;
-    if (!check(TokenType::SEMICOLON)) {
-        if (isTypeToken(current.type()) && current.type() != TokenType::IDENTIFIER) {
-            // Variable declaration as initializer
-            init = parseVariableDecl();
+void Lexer::expandMacroInto(std::string_view name, Symbol symbol) {
+    // Every token of the expansion is placed at the macro's use site. Tokens the invocation
+    // pulled but did not consume (the one after a function-like name without '(') keep theirs.
+    int line = tokenLine_;
+    int column = tokenColumn_;
+    PPToken use;
+    use.token = Token(TokenType::IDENTIFIER, name, line, column, symbol);
+    std::vector<PPToken> expanded;
+    macros_.expand(use, [this](PPToken& token) { return pullRaw(token); }, expanded);
+    for (const PPToken& pp : expanded) {
+        const Token& token = pp.token;
+        bool inSource = token.text().data() >= source_.data() &&
+                        token.text().data() + token.text().size() <= source_.data() + source_.size();
+        if (!pp.hide && inSource && token.line() > 0) {
+            tokens_.push_back(token);
         } else {
-            // Expression or assignment as initializer
-            init = parseStatement();
-            // Only expect semicolon if not already consumed by parseVariableDecl
-            // if (current.type() == TokenType::SEMICOLON) advance();
+            tokens_.push_back(token.moved(keepText(token.text()), line, column));
         }
-    } else {
-        advance(); // skip ;
-    }
-    std::unique_ptr<ASTNode> cond = nullptr;
-    if (!check(TokenType::SEMICOLON)) {
-        cond = parseExpression();
-    }
-    expect(TokenType::SEMICOLON, "Expected ';' after for-condition");
-    std::unique_ptr<ASTNode> inc = nullptr;
-    if (!check(TokenType::RIGHT_PAREN)) {
-        inc = parseExpression();
     }
-    expect(TokenType::RIGHT_PAREN, "Expected ')' after for-clause");
-    auto body = parseStatement();
-    return std::make_unique<ForStmt>(std::move(init), std::move(cond), std::move(inc), std::move(body));
 }
 
-// --- parseReturnStmt ---
-std::unique_ptr<ASTNode> Parser::parseReturnStmt() {
-    std::cout << "[DEBUG] :: ReturnStmt" << std::endl;
-    expect(TokenType::RETURN, "Expected 'return'");
-    std::unique_ptr<ASTNode> expr = nullptr;
-    if (!check(TokenType::SEMICOLON)) {
-        expr = parseExpression();
-    }
-    expect(TokenType::SEMICOLON, "Expected ';' after return statement");
-    return std::make_unique<ReturnStmt>(std::move(expr));
+bool Lexer::pullRaw(PPToken& out) {
+    // Lexes one token as it is written. Directives end an invocation's arguments, so at one
+    // (or at the end) the position is left where it was for lexToken to carry on.
+    size_t pos = pos_;
+    int line = line_;
+    size_t lineStart = lineStart_;
+    bool atLineStart = atLineStart_;
+    skipWhitespaceAndComments();
+    if (isAtEnd() || (atLineStart_ && source_[pos_] == '#')) {
+        pulledToEnd_ = pulledToEnd_ || isAtEnd();
+        pos_ = pos;
+        line_ = line;
+        lineStart_ = lineStart;
+        atLineStart_ = atLineStart;
+        return false;
+    }
+    size_t mark = tokens_.size();
+    bool raw = rawMode_;
+    rawMode_ = true;
+    lexToken();
+    rawMode_ = raw;
+    atLineStart_ = false;
+    if (tokens_.size() == mark) return pullRaw(out);
+    out.token = tokens_[mark];
+    out.spaceBefore = tokenStartPos_ > pos;
+    out.hide = nullptr;
+    while (tokens_.size() > mark) tokens_.pop_back();
+    return true;
 }
 
-// --- parseTemplateDecl ---
-std::unique_ptr<ASTNode> Parser::parseTemplateDecl() {
-    std::cout << "[DEBUG] :: TemplateDecl" << std::endl;
-    expect(TokenType::TEMPLATE, "Expected 'template'");
-    expect(TokenType::LESS, "Expected '<' after 'template'");
-    // Parse template parameter list (e.g., typename T, class U)
-    std::vector<std::unique_ptr<TemplateParam>> templateParams;
-    std::vector<std::string> paramNames; // For TemplateDecl fallback
-    do {
-        if ((check(TokenType::CLASS) || current.text() == "typename") &&
-            tokens[currentIndex + 1]->type() == TokenType::IDENTIFIER) {
-            advance(); // skip 'class' or 'typename'
-            expect(TokenType::IDENTIFIER, "Expected template parameter name");
-            std::string paramName = previous().text();
-            templateParams.push_back(std::make_unique<TemplateParam>(paramName, true));
-            paramNames.push_back(paramName);
-        } else if (check(TokenType::IDENTIFIER) && tokens[currentIndex + 1]->type() == TokenType::IDENTIFIER) {
-            // Accept: template <T U>
-            std::string typeName = current.text();
-            advance();
-            expect(TokenType::IDENTIFIER, "Expected template parameter name");
-            std::string paramName = previous().text();
-            templateParams.push_back(std::make_unique<TemplateParam>(paramName, false, typeName));
-            paramNames.push_back(paramName);
-        } else {
-            throw std::runtime_error("Expected template parameter declaration (class/typename/identifier identifier)");
-        }
-    } while (match(TokenType::COMMA));
-    expect(TokenType::GREATER, "Expected '>' after template parameter list");
-
-    // --- After parsing template parameter list, handle 'class' or 'struct' or 'enum' or 'union' as identifier tokens
-    if (check(TokenType::IDENTIFIER) && (current.text() == "class" || current.text() == "struct" || current.text() == "enum" || current.text() == "union")) {
-        TokenType keywordType = TokenType::CLASS;
-        if (current.text() == "struct") keywordType = TokenType::STRUCT;
-        else if (current.text() == "enum") keywordType = TokenType::ENUM;
-        else if (current.text() == "union") keywordType = TokenType::UNION;
-        current = Token(keywordType, current.text(), current.line(), current.column());
-    }
+std::vector<PPToken> Lexer::lexFragment(std::string_view text, TokenStorage& storage) {
+    Lexer lexer(text);
+    lexer.rawMode_ = true;
+    lexer.atLineStart_ = false;
+    std::vector<PPToken> tokens;
+    PPToken token;
+    while (lexer.pullRaw(token)) tokens.push_back(token);
+    storage.adopt(lexer.tokens_.storage());
+    return tokens;
+}
 
-    if (check(TokenType::CLASS)) {
-        // Template class
-        auto classNode = parseClassDecl();
-        auto* classPtr = dynamic_cast<ClassDecl*>(classNode.release());
-        if (!classPtr) throw std::runtime_error("Expected ClassDecl after template<...> class");
-        std::string className = classPtr->name;
-        std::vector<std::unique_ptr<ASTNode>> members;
-        // Collect all members from all access levels
-        for (auto& m : classPtr->publicMembers) {
-            members.push_back(std::move(m));
-        }
-        for (auto& m : classPtr->privateMembers) {
-            members.push_back(std::move(m));
-        }
-        for (auto& m : classPtr->protectedMembers) {
-            members.push_back(std::move(m));
-        }
-        delete classPtr; // classPtr is now empty, members moved
-        return std::make_unique<TemplateClassDecl>(className, std::move(templateParams), std::move(members));
-    } else {
-        // Fallback: generic template decl
-        auto decl = parseDeclaration();
-        // TemplateDecl does not exist; use TemplateClassDecl as a generic wrapper
-        std::vector<std::unique_ptr<ASTNode>> nodes;
-        nodes.push_back(std::move(decl));
-        return std::make_unique<TemplateClassDecl>(
-            paramNames.empty() ? "" : paramNames[0],
-            std::vector<std::unique_ptr<TemplateParam>>{},
-            std::move(nodes)
-        );
-    }
+TokenType Lexer::keywordLookup(std::string_view identifier) const {
+    return lookupKeyword(identifier);
+}
+
+void Lexer::addToken(TokenType type, std::string_view text, Symbol symbol) {
+    addTokenAt(type, text, tokenLine_, tokenColumn_, symbol);
 }
 
+void Lexer::addTokenAt(TokenType type, std::string_view text, int line, int column, Symbol symbol) {
+    Token token(type, keepText(text), line, column, symbol);
+    // Numbers are decoded once, here; macro expansions carry the value along (Token::moved)
+    if (type == TokenType::INTEGER || type == TokenType::FLOAT) decodeNumber(token);
+    tokens_.push_back(token);
+}
+
+std::string_view Lexer::keepText(std::string_view text) {
+    // Text inside the source is referenced in place; anything else (macro expansions,
+    // rewritten raw strings, directive arguments, messages) is copied into the storage arena
+    bool inSource = text.data() >= source_.data() && text.data() + text.size() <= source_.data() + source_.size();
+    return inSource ? text : tokens_.storage()->store(text);
+}
+
+void Lexer::addError(const std::string& message) {
+    errorMessage_ = message;
+    LOG_WARN(LogCategory::Lexer, (path_.empty() ? "" : path_ + ": ") << message << " at line " << tokenLine_
+                                 << ", column " << tokenColumn_);
+    addToken(TokenType::ERROR, message);
+}
+
+// --- #if expression evaluation ---
+
+bool Lexer::evalCondition(const std::string& condition) {
+    // Conditions are compiled once per distinct text (see IfExpression), and read macros defined
+    // as integers straight from the table. One that mentions any other macro is macro-expanded
+    // first, and the expansion is compiled (and cached) instead.
+    std::shared_ptr<const IfExpression> expression = IfExpression::cached(condition);
+    if (expression->needsExpansion(macros_)) expression = IfExpression::cached(expandMacro(condition, true));
+    if (!expression->error().empty()) {
+        LOG_WARN(LogCategory::Lexer, expression->error() << " in #if condition '" << expression->text() << "'");
+    }
+    return expression->evaluate(macros_) != 0;
+}
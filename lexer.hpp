@@ -2,34 +2,98 @@
 #define LEXER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
-#include <unordered_map>
-#include <stack>
-#include "tokens.hpp"
+#include "macro.hpp"
+#include "token.hpp"
+
+class HeaderCache;
+struct IncludeState;
+
+// What preprocessing a file starts from, and where another left off: the macro table, the
+// open #if groups (whether the branch is live, and whether any branch was taken yet) and
+// the headers already included with #pragma once
+struct PreprocessorState {
+    struct Conditional {
+        bool active;
+        bool taken;
+    };
+    std::shared_ptr<const MacroTable> macros;   // Shared, not copied, by restoreState()
+    std::vector<Conditional> conditionals;
+    std::vector<std::string> onceFiles;
+};
 
+// Table-driven lexer: every byte is classified through constexpr 256-entry tables and
+// operators are recognized by a small DFA with maximal munch (see lexer.cpp).
 class Lexer {
 public:
-    explicit Lexer(const std::string& source);
+    // Token texts point into source. owner (e.g. the SourceFile or string holding it) is kept
+    // alive by the returned TokenBuffer; without one, source must outlive the tokens.
+    explicit Lexer(std::string_view source, std::shared_ptr<const void> owner = nullptr);
 
     // Tokenize the entire source code and return a vector of tokens
-    std::vector<std::unique_ptr<Token>> tokenize();
-    
+    TokenBuffer tokenize();
+
+    // Same tokens as tokenize(), lexed on up to jobs threads. The source is cut at line starts
+    // the lexer reaches outside any comment or literal, after the last preprocessor directive,
+    // into chunks of at least minChunkBytes; smaller inputs, or ones with no such place, are
+    // lexed by tokenize().
+    TokenBuffer tokenizeParallel(unsigned jobs, size_t minChunkBytes = 1 << 20);
+
+    // Pull interface: lex only as far as the next token. Returns END_OF_FILE forever once
+    // the input is exhausted. Texts live in storage(). Use either this or tokenize(), not both.
+    Token next();
+    const std::shared_ptr<TokenStorage>& storage() const { return tokens_.storage(); }
+
+    // Follow #include directives that name a header found through cache (path is the file
+    // being lexed, for quoted names): the header's macro definitions take effect here. Its
+    // tokens stay in the cache; the directive's own tokens are emitted as before.
+    void enableIncludes(HeaderCache& cache, const std::string& path);
+
+    // The preprocessor state reached so far (after tokenize(): at the end of the input), and
+    // installing one before lexing so this source continues from it. Call restoreState()
+    // after enableIncludes(), so the #pragma once headers are known to the include state.
+    PreprocessorState saveState() const;
+    void restoreState(const PreprocessorState& state);
+
+    // Tokens of text with neither macro expansion nor directives, e.g. a macro body. Texts
+    // that are not views into text itself are kept alive by storage.
+    static std::vector<PPToken> lexFragment(std::string_view text, TokenStorage& storage);
 
 private:
-    const std::string& source_;   // Source code to tokenize
+    std::string_view source_;     // Source code to tokenize
     size_t pos_ = 0;              // Current position in source_
     int line_ = 1;                // Current line number (starts at 1)
-    int column_ = 1;              // Current column number (starts at 1)
+    size_t lineStart_ = 0;        // Offset of the first byte of the current line; columns derive from it
+    bool atLineStart_ = true;     // Nothing but whitespace since the last newline ('#' starts a directive)
     std::string errorMessage_;    // error message
 
     size_t tokenStartPos_ = 0;    // Start position of the current token
-
-    // Macro definitions: macro name -> replacement text
-    std::unordered_map<std::string, std::string> macros_;
-
-    // Stack tracking conditional compilation states (#ifdef, #ifndef, #else, #endif)
-    std::vector<bool> conditionalStack_;
+    int tokenLine_ = 1;           // Line and column of the current token
+    int tokenColumn_ = 1;
+
+    // Tokens produced so far, and the storage their texts live in
+    TokenBuffer tokens_;
+    size_t nextToken_ = 0;        // next(): first token in tokens_ not yet handed out
+    bool finished_ = false;       // next(): END_OF_FILE has been lexed
+
+    // Macro table and expansion
+    MacroExpander macros_;
+    bool rawMode_ = false;        // Lex identifiers without expanding macros (pullRaw)
+    bool pulledToEnd_ = false;    // An invocation looked for its '(' or arguments past the end
+
+    // #include handling (null: includes are not followed)
+    std::shared_ptr<IncludeState> includes_;
+    std::string path_;
+    std::vector<std::string> onceFiles_;  // #pragma once headers included while lexing this one
+    std::vector<std::string> onceSkipped_; // #pragma once headers skipped, here or in a header included
+    std::vector<std::pair<std::string, uint64_t>> included_;  // Headers included, here or below, and their content hashes
+
+    // One entry per open #if/#ifdef/#ifndef: whether the current branch is live, and whether
+    // any branch of the group has been taken yet (so #elif/#else know whether to fire)
+    using Conditional = PreprocessorState::Conditional;
+    std::vector<Conditional> conditionalStack_;
 
     // If true, lexer is currently skipping tokens due to false condition in preprocessing
     bool skipping_ = false;
@@ -41,40 +105,45 @@ private:
     bool match(char expected);    // If current char matches expected, consume it and return true
 
     void skipWhitespaceAndComments();  // Skip spaces, tabs, newlines, and comments
+    void skipInactiveRegion();         // Skip whole lines of a false #if branch
+    void countNewlines(size_t from, size_t to);  // Account for newlines inside a skipped span
+    void beginToken();                 // Mark pos_ as the start of the next token
 
     // --- Lexing different types of tokens ---
-    std::unique_ptr<Token> lexToken();
-    std::unique_ptr<Token> lexIdentifierOrKeyword();
-    std::unique_ptr<Token> lexNumber();
-    std::unique_ptr<Token> lexString();
-    std::unique_ptr<Token> lexChar();
-    std::unique_ptr<Token> lexPreprocessorDirective();
+    // Each appends what it lexes to tokens_ (a directive or macro use may append several
+    // tokens, or none). lexToken returns false once END_OF_FILE has been appended.
+    bool lexToken();
+    bool lexStep();                    // lexToken plus the bookkeeping between tokens
+    void warnOpenConditionals() const; // Called once the whole input has been lexed
+    void lexIdentifierOrKeyword();
+    void lexNumber();
+    void lexString();
+    void lexChar();
+    void lexOperator();
+    void lexPreprocessorDirective();
+    std::string readDirectiveRest();   // Rest of a directive line, splices joined and comments removed
 
     // --- Macro handling helpers ---
-    void defineMacro(const std::string& name, const std::string& value);
     bool isMacroDefined(const std::string& name) const;
+    void pushConditional(bool condition);
     void updateSkipping();                // Update skipping_ state based on conditionalStack_
+    void expandMacroInto(std::string_view name, Symbol symbol);  // Append the tokens a macro use expands to
+    bool pullRaw(PPToken& out);           // Next source token, unexpanded; false at the end or a directive
+    void includeHeader(const std::string& name, bool quoted);
 
-    std::string expandMacro(const std::string& text) const;  // Expand macro if defined
+    std::string expandMacro(const std::string& text, bool ifCondition = false);  // Text with every macro expanded
 
     // --- Keyword and identifier handling ---
-    TokenType keywordLookup(const std::string& identifier) const;
+    TokenType keywordLookup(std::string_view identifier) const;
 
     // --- Token creation helpers ---
-    std::unique_ptr<Token> makeToken(TokenType type, const std::string& text);
-    std::unique_ptr<Token> errorToken(const std::string& message);
-
-    // --- Preprocessor Expression Evaluation Helpers ---
-    void skipSpaces(const std::string& expr, size_t& idx);
-    bool matchKeyword(const std::string& expr, size_t& idx, const std::string& keyword);
-    int evalIfExpression(const std::string& expr);
-    int preparseExpression(const std::string& expr, size_t& idx);
-    int preparseLogicalOr(const std::string& expr, size_t& idx);
-    int preparseLogicalAnd(const std::string& expr, size_t& idx);
-    int preparseEquality(const std::string& expr, size_t& idx);
-    int preparseRelational(const std::string& expr, size_t& idx);
-    int preparseUnary(const std::string& expr, size_t& idx);
-    int preparsePrimary(const std::string& expr, size_t& idx);
+    void addToken(TokenType type, std::string_view text, Symbol symbol = sym::None);   // At the current token's position
+    void addTokenAt(TokenType type, std::string_view text, int line, int column, Symbol symbol = sym::None);
+    std::string_view keepText(std::string_view text);   // text, copied to storage unless it is in the source
+    void addError(const std::string& message);
+
+    // --- Preprocessor Expression Evaluation ---
+    bool evalCondition(const std::string& condition);   // #if / #elif condition as written
 
     // --- Utility ---
     bool isAtEnd() const;         // Check if reached end of source
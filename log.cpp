@@ -0,0 +1,339 @@
+#include "log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kCategories = static_cast<int>(LogCategory::Count);
+constexpr int kLevels = static_cast<int>(LogLevel::Error) + 1;
+
+// Level bits (see Logger::levels_) of level and everything above it
+unsigned levelsFrom(LogLevel level) {
+    return (1u << kLevels) - (1u << static_cast<int>(level));
+}
+
+// Per category: the levels its sink takes, and the number of live captures
+std::atomic<unsigned> sinkLevels[kCategories] = {};
+std::atomic<int> captureCount[kCategories] = {};
+std::mutex levelsMutex;
+// Innermost capture of each category on this thread
+thread_local Logger::Capture* captureOf[kCategories] = {};
+
+// Single-producer/single-consumer byte ring. The owning thread appends records at head,
+// the writer thread consumes them at tail. Record: uint32 length, level, category, message.
+struct ThreadRing {
+    static constexpr uint64_t kCapacity = 1 << 20;
+    static constexpr uint64_t kHeader = 8;
+    // Longer lines are truncated so one record can never fill the ring
+    static constexpr uint64_t kMaxMessage = kCapacity / 4;
+
+    std::unique_ptr<char[]> data{new char[kCapacity]};
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> alive{true};
+
+    void copyIn(uint64_t pos, const char* src, uint64_t size) {
+        uint64_t offset = pos % kCapacity;
+        uint64_t first = std::min(size, kCapacity - offset);
+        std::memcpy(&data[offset], src, first);
+        std::memcpy(&data[0], src + first, size - first);
+    }
+
+    void copyOut(uint64_t pos, char* dst, uint64_t size) const {
+        uint64_t offset = pos % kCapacity;
+        uint64_t first = std::min(size, kCapacity - offset);
+        std::memcpy(dst, &data[offset], first);
+        std::memcpy(dst + first, &data[0], size - first);
+    }
+};
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+    }
+    return "?";
+}
+
+const char* categoryName(int category) {
+    switch (static_cast<LogCategory>(category)) {
+        case LogCategory::Lexer: return "lexer";
+        case LogCategory::Parser: return "parser";
+        case LogCategory::Codegen: return "codegen";
+        default: return "?";
+    }
+}
+
+class LogState {
+public:
+    ~LogState() { stop(); }
+
+    ThreadRing& threadRing() {
+        // The holder outlives nothing but its thread; the writer drops the ring once drained
+        struct Holder {
+            std::shared_ptr<ThreadRing> ring;
+            ~Holder() { if (ring) ring->alive = false; }
+        };
+        thread_local Holder holder;
+        if (!holder.ring) {
+            holder.ring = std::make_shared<ThreadRing>();
+            std::lock_guard<std::mutex> lock(registryMutex_);
+            rings_.push_back(holder.ring);
+        }
+        return *holder.ring;
+    }
+
+    void openSink(int category, const std::string& path) {
+        std::unique_ptr<std::ostream> file;
+        if (path == "-") {
+            file = std::make_unique<std::ostream>(std::cerr.rdbuf());
+        } else {
+            auto stream = std::make_unique<std::ofstream>(path, std::ios::out | std::ios::trunc);
+            if (!stream->is_open()) {
+                throw std::runtime_error("Failed to open " + path + " for writing");
+            }
+            file = std::move(stream);
+        }
+        closeSink(category);
+        start();
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex_);
+            sinks_[category] = std::move(file);
+        }
+    }
+
+    void closeSink(int category) {
+        flush();
+        std::lock_guard<std::mutex> lock(sinkMutex_);
+        sinks_[category].reset();
+    }
+
+    void push(LogLevel level, int category, std::string_view message) {
+        ThreadRing& ring = threadRing();
+        uint32_t length = static_cast<uint32_t>(std::min<uint64_t>(message.size(), ThreadRing::kMaxMessage));
+        uint64_t need = ThreadRing::kHeader + length;
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        // Back-pressure: wait for the writer rather than drop lines
+        while (ThreadRing::kCapacity - (head - ring.tail.load(std::memory_order_acquire)) < need) {
+            wake_.notify_one();
+            std::this_thread::yield();
+        }
+        char header[ThreadRing::kHeader] = {};
+        std::memcpy(header, &length, sizeof(length));
+        header[4] = static_cast<char>(level);
+        header[5] = static_cast<char>(category);
+        ring.copyIn(head, header, ThreadRing::kHeader);
+        ring.copyIn(head + ThreadRing::kHeader, message.data(), length);
+        ring.head.store(head + need, std::memory_order_release);
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(flushMutex_);
+        if (!running_) return;
+        uint64_t request = ++flushRequested_;
+        wake_.notify_one();
+        flushed_.wait(lock, [&] { return flushCompleted_ >= request || !running_; });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(flushMutex_);
+            if (!running_) return;
+            stopRequested_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        running_ = false;
+        stopRequested_ = false;
+        flushed_.notify_all();
+        std::lock_guard<std::mutex> sinkLock(sinkMutex_);
+        for (auto& sink : sinks_) sink.reset();
+    }
+
+private:
+    std::mutex registryMutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+
+    std::mutex sinkMutex_;
+    std::unique_ptr<std::ostream> sinks_[kCategories];
+
+    std::mutex flushMutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushCompleted_ = 0;
+    bool running_ = false;
+    bool stopRequested_ = false;
+    std::thread writer_;
+
+    void start() {
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        if (running_) return;
+        running_ = true;
+        writer_ = std::thread([this] { run(); });
+    }
+
+    void run() {
+        std::string pending[kCategories];
+        std::string message;
+        while (true) {
+            uint64_t request;
+            bool stopping;
+            {
+                std::lock_guard<std::mutex> lock(flushMutex_);
+                request = flushRequested_;
+                stopping = stopRequested_;
+            }
+            bool drained = drain(pending, message);
+            if (drained || request || stopping) writeOut(pending);
+            if (stopping) return;
+            {
+                std::unique_lock<std::mutex> lock(flushMutex_);
+                if (request > flushCompleted_) {
+                    flushCompleted_ = request;
+                    flushed_.notify_all();
+                }
+                if (!drained && flushRequested_ == flushCompleted_ && !stopRequested_) {
+                    wake_.wait_for(lock, std::chrono::milliseconds(2));
+                }
+            }
+        }
+    }
+
+    // Move every complete record out of the rings; returns true if anything was read
+    bool drain(std::string* pending, std::string& message) {
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex_);
+            rings = rings_;
+        }
+        bool any = false;
+        for (const auto& ring : rings) {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            while (tail < head) {
+                char header[ThreadRing::kHeader];
+                ring->copyOut(tail, header, ThreadRing::kHeader);
+                uint32_t length;
+                std::memcpy(&length, header, sizeof(length));
+                auto level = static_cast<LogLevel>(header[4]);
+                int category = header[5];
+                message.resize(length);
+                ring->copyOut(tail + ThreadRing::kHeader, &message[0], length);
+                tail += ThreadRing::kHeader + length;
+
+                std::string& out = pending[category];
+                out += '[';
+                out += levelName(level);
+                out += "][";
+                out += categoryName(category);
+                out += "] ";
+                out += message;
+                out += '\n';
+                any = true;
+            }
+            ring->tail.store(tail, std::memory_order_release);
+        }
+        // Forget rings whose thread has exited once they are empty
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<ThreadRing>& ring) {
+            return !ring->alive && ring->tail.load() == ring->head.load();
+        }), rings_.end());
+        return any;
+    }
+
+    void writeOut(std::string* pending) {
+        std::lock_guard<std::mutex> lock(sinkMutex_);
+        for (int c = 0; c < kCategories; ++c) {
+            if (sinks_[c] && !pending[c].empty()) {
+                sinks_[c]->write(pending[c].data(), static_cast<std::streamsize>(pending[c].size()));
+                sinks_[c]->flush();
+            }
+            pending[c].clear();
+        }
+    }
+};
+
+LogState& state() {
+    static LogState instance;
+    return instance;
+}
+
+} // unnamed namespace
+
+void Logger::openSink(LogCategory category, const std::string& path, LogLevel minLevel) {
+    int index = static_cast<int>(category);
+    state().openSink(index, path);
+    sinkLevels[index].store(levelsFrom(minLevel), std::memory_order_relaxed);
+    updateLevels(index);
+}
+
+void Logger::closeSink(LogCategory category) {
+    int index = static_cast<int>(category);
+    sinkLevels[index].store(0, std::memory_order_relaxed);
+    updateLevels(index);
+    state().closeSink(index);
+}
+
+void Logger::updateLevels(int category) {
+    std::lock_guard<std::mutex> lock(levelsMutex);
+    unsigned levels = sinkLevels[category].load(std::memory_order_relaxed);
+    if (captureCount[category].load(std::memory_order_relaxed) > 0) levels |= levelsFrom(LogLevel::Warn);
+    levels_[category].store(levels, std::memory_order_relaxed);
+}
+
+void Logger::write(LogLevel level, LogCategory category, std::string_view message) {
+    int index = static_cast<int>(category);
+    Capture* capture = captureOf[index];
+    if (capture && level >= LogLevel::Warn) capture->messages_.emplace_back(message);
+    if (sinkLevels[index].load(std::memory_order_relaxed) & (1u << static_cast<int>(level))) {
+        state().push(level, index, message);
+    }
+}
+
+Logger::Capture::Capture(LogCategory category) : category_(category) {
+    int index = static_cast<int>(category_);
+    outer_ = captureOf[index];
+    captureOf[index] = this;
+    captureCount[index]++;
+    updateLevels(index);
+}
+
+Logger::Capture::~Capture() {
+    int index = static_cast<int>(category_);
+    captureOf[index] = outer_;
+    captureCount[index]--;
+    updateLevels(index);
+}
+
+void Logger::flush() {
+    state().flush();
+}
+
+void Logger::shutdown() {
+    for (int c = 0; c < kCategories; ++c) {
+        sinkLevels[c].store(0, std::memory_order_relaxed);
+        updateLevels(c);
+    }
+    state().stop();
+}
+
+std::ostringstream& Logger::threadStream() {
+    thread_local std::ostringstream stream;
+    stream.str(std::string());
+    stream.clear();
+    return stream;
+}
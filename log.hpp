@@ -0,0 +1,103 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class LogLevel { Debug = 0, Info, Warn, Error };
+enum class LogCategory { Lexer = 0, Parser, Codegen, Count };
+
+// Levels below this are compiled out entirely. Release builds (-DNDEBUG) drop Debug.
+#ifndef TRANSPILER_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define TRANSPILER_LOG_MIN_LEVEL 1
+#else
+#define TRANSPILER_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// Process-wide structured logger.
+// Each category is routed to its own file. Producers format a line and copy it into a
+// lock-free ring buffer owned by their thread; one background thread drains every ring and
+// does all file I/O in large writes, so logging never issues a syscall on the caller's thread.
+// A category without a sink costs one relaxed atomic load per log statement.
+class Logger {
+public:
+    // Route category's lines at minLevel and above to path (truncated), or to stderr if path
+    // is "-"; throws std::runtime_error if it cannot be opened
+    static void openSink(LogCategory category, const std::string& path, LogLevel minLevel = LogLevel::Debug);
+    // Drain pending lines of category to its file and close it
+    static void closeSink(LogCategory category);
+
+    static bool enabled(LogLevel level, LogCategory category) {
+        return levels_[static_cast<int>(category)].load(std::memory_order_relaxed) & (1u << static_cast<int>(level));
+    }
+
+    // While alive, also collects the messages of category at Warn and above that the
+    // constructing thread logs, e.g. to return one request's diagnostics (--serve). Captures
+    // nest; only the innermost one for a category collects.
+    class Capture {
+    public:
+        explicit Capture(LogCategory category);
+        ~Capture();
+        Capture(const Capture&) = delete;
+        Capture& operator=(const Capture&) = delete;
+
+        const std::vector<std::string>& messages() const { return messages_; }
+
+    private:
+        friend class Logger;
+        LogCategory category_;
+        Capture* outer_;
+        std::vector<std::string> messages_;
+    };
+
+    static void write(LogLevel level, LogCategory category, std::string_view message);
+
+    // Block until every line logged before the call is written to its file
+    static void flush();
+    // Flush, stop the writer thread and close all sinks
+    static void shutdown();
+
+    // Per-thread scratch stream used by the LOG_* macros to format a line
+    static std::ostringstream& threadStream();
+
+private:
+    // Per category, a bit for each level that a sink or capture takes (0: the category is off)
+    static inline std::atomic<unsigned> levels_[static_cast<int>(LogCategory::Count)] = {};
+
+    static void updateLevels(int category);
+};
+
+// message is a << chain, e.g. LOG_INFO(LogCategory::Parser, "Parsed " << n << " tokens");
+// It is only evaluated when the category has a sink.
+#define TRANSPILER_LOG(level, category, message)                          \
+    do {                                                                  \
+        if (Logger::enabled(level, category)) {                           \
+            std::ostringstream& logStream_ = Logger::threadStream();      \
+            logStream_ << message;                                        \
+            Logger::write(level, category, logStream_.str());             \
+        }                                                                 \
+    } while (0)
+
+#if TRANSPILER_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(category, message) TRANSPILER_LOG(LogLevel::Debug, category, message)
+#else
+#define LOG_DEBUG(category, message) do {} while (0)
+#endif
+#if TRANSPILER_LOG_MIN_LEVEL <= 1
+#define LOG_INFO(category, message) TRANSPILER_LOG(LogLevel::Info, category, message)
+#else
+#define LOG_INFO(category, message) do {} while (0)
+#endif
+#if TRANSPILER_LOG_MIN_LEVEL <= 2
+#define LOG_WARN(category, message) TRANSPILER_LOG(LogLevel::Warn, category, message)
+#else
+#define LOG_WARN(category, message) do {} while (0)
+#endif
+#define LOG_ERROR(category, message) TRANSPILER_LOG(LogLevel::Error, category, message)
+
+#endif // LOG_HPP
@@ -0,0 +1,452 @@
+#include "macro.hpp"
+#include "hash.hpp"
+#include "lexer.hpp"
+#include "log.hpp"
+#include <algorithm>
+
+namespace {
+
+// Cached invocations kept before the cache is dropped and refilled
+constexpr size_t kMaxCacheEntries = 4096;
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+bool isIdentifierSpelling(std::string_view s) {
+    if (s.empty() || (s.front() >= '0' && s.front() <= '9')) return false;
+    for (char c : s) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+                  static_cast<unsigned char>(c) >= 0x80;
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool isLiteral(TokenType type) {
+    return type == TokenType::STRING_LITERAL || type == TokenType::CHARACTER || type == TokenType::INTEGER ||
+           type == TokenType::FLOAT || type == TokenType::STRING || type == TokenType::ERROR;
+}
+
+bool contains(const HideSet& hide, Symbol symbol) {
+    return hide && std::binary_search(hide->begin(), hide->end(), symbol);
+}
+
+HideSet with(const HideSet& hide, const Macro& macro) {
+    if (!hide) return macro.self;
+    if (contains(hide, macro.symbol)) return hide;
+    auto set = std::make_shared<std::vector<Symbol>>(*hide);
+    set->insert(std::lower_bound(set->begin(), set->end(), macro.symbol), macro.symbol);
+    return set;
+}
+
+HideSet unite(const HideSet& a, const HideSet& b) {
+    if (!a || a == b) return b;
+    if (!b) return a;
+    auto set = std::make_shared<std::vector<Symbol>>();
+    std::set_union(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(*set));
+    return set;
+}
+
+HideSet intersect(const HideSet& a, const HideSet& b) {
+    if (!a || !b) return nullptr;
+    if (a == b) return a;
+    auto set = std::make_shared<std::vector<Symbol>>();
+    std::set_intersection(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(*set));
+    return set->empty() ? nullptr : HideSet(std::move(set));
+}
+
+bool sameToken(const PPToken& a, const PPToken& b) {
+    return a.token.type() == b.token.type() && a.token.text() == b.token.text() && a.spaceBefore == b.spaceBefore;
+}
+
+} // unnamed namespace
+
+// --- Definitions ---
+
+std::shared_ptr<const Macro> parseMacroDefinition(const std::string& name, std::string_view definition,
+                                                  std::string& error) {
+    auto macro = std::make_shared<Macro>();
+    macro->name = name;
+    macro->symbol = intern(name);
+    macro->self = std::make_shared<const std::vector<Symbol>>(1, macro->symbol);
+
+    std::string_view body = definition;
+    if (!body.empty() && body.front() == '(') {
+        macro->functionLike = true;
+        size_t close = body.find(')');
+        if (close == std::string_view::npos) {
+            error = "Missing ')' in parameter list of macro '" + name + "'";
+            return nullptr;
+        }
+        std::string_view list = trim(body.substr(1, close - 1));
+        body.remove_prefix(close + 1);
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            std::string_view param = trim(list.substr(0, comma));
+            list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+            if (macro->variadic) {
+                error = "'...' must be the last parameter of macro '" + name + "'";
+                return nullptr;
+            }
+            if (param.size() >= 3 && param.substr(param.size() - 3) == "...") {
+                // "..." is named __VA_ARGS__; "args..." names the variable arguments itself
+                macro->variadic = true;
+                param = trim(param.substr(0, param.size() - 3));
+                if (param.empty()) param = "__VA_ARGS__";
+            }
+            if (!isIdentifierSpelling(param)) {
+                error = "Bad parameter '" + std::string(param) + "' in macro '" + name + "'";
+                return nullptr;
+            }
+            macro->params.emplace_back(param);
+        }
+    }
+
+    macro->text = std::string(trim(body));
+    uint64_t hash = hashBytes(macro->functionLike ? "(" : " ", 1);
+    for (const auto& param : macro->params) hash = hashBytes(",", 1, hashString(param, hash));
+    hash = hashString(macro->text, hashBytes(macro->variadic ? "." : " ", 1, hash));
+    macro->hash = hash ? hash : 1;
+    macro->storage = std::make_shared<TokenStorage>(nullptr);
+    std::vector<PPToken> tokens = Lexer::lexFragment(macro->text, *macro->storage);
+    auto paramIndex = [&macro](const Token& token) {
+        if (!macro->functionLike || isLiteral(token.type())) return -1;
+        auto it = std::find(macro->params.begin(), macro->params.end(), token.text());
+        return it == macro->params.end() ? -1 : static_cast<int>(it - macro->params.begin());
+    };
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        bool hash = tokens[i].token.type() == TokenType::HASH;
+        bool next = i + 1 < tokens.size();
+        if (hash && next && tokens[i + 1].token.type() == TokenType::HASH && !tokens[i + 1].spaceBefore) {
+            // "##" joins the parts on either side
+            if (!macro->body.empty() && i + 2 < tokens.size()) macro->body.back().pasteNext = true;
+            ++i;
+            continue;
+        }
+        Macro::Part part;
+        part.token = tokens[i];
+        int param = next ? paramIndex(tokens[i + 1].token) : -1;
+        if (hash && param >= 0) {
+            part.param = param;
+            part.stringize = true;
+            ++i;
+        } else {
+            part.param = paramIndex(tokens[i].token);
+        }
+        macro->body.push_back(std::move(part));
+    }
+    if (!macro->functionLike) {
+        size_t first = 0;
+        size_t last = macro->body.size();
+        while (last - first >= 3 && macro->body[first].token.token.type() == TokenType::LEFT_PAREN &&
+               macro->body[last - 1].token.token.type() == TokenType::RIGHT_PAREN) {
+            ++first;
+            --last;
+        }
+        const Token* literal = last - first == 1 ? &macro->body[first].token.token : nullptr;
+        if (literal && literal->type() == TokenType::INTEGER && literal->suffix() != NumberSuffix::Other) {
+            macro->integer = true;
+            macro->value = literal->int_value();
+        }
+    }
+    return macro;
+}
+
+std::string definitionText(const Macro& macro) {
+    // An object-like body is separated from the name, or one starting with '(' would read
+    // back as a parameter list
+    if (!macro.functionLike) return " " + macro.text;
+    std::string text = "(";
+    for (size_t i = 0; i < macro.params.size(); ++i) {
+        if (i > 0) text += ", ";
+        bool variadic = macro.variadic && i + 1 == macro.params.size();
+        if (!variadic || macro.params[i] != "__VA_ARGS__") text += macro.params[i];
+        if (variadic) text += "...";
+    }
+    return text + ") " + macro.text;
+}
+
+void MacroExpander::copyDefinitions(std::shared_ptr<const MacroTable> definitions) {
+    // Never written through while shared_ is set (see writable)
+    macros_ = std::const_pointer_cast<MacroTable>(std::move(definitions));
+    shared_ = true;
+    cache_.clear();   // Its entries point at macros of the table replaced
+}
+
+std::shared_ptr<const MacroTable> MacroExpander::share() const {
+    shared_ = true;
+    return macros_;
+}
+
+MacroTable& MacroExpander::writable() {
+    if (shared_) {
+        macros_ = std::make_shared<MacroTable>(*macros_);
+        shared_ = false;
+    }
+    return *macros_;
+}
+
+void MacroExpander::define(std::shared_ptr<const Macro> macro) {
+    writable()[macro->symbol] = std::move(macro);
+    cache_.clear();
+}
+
+void MacroExpander::undefine(std::string_view name) {
+    Symbol symbol = intern(name);
+    if (macros_->count(symbol) == 0) return;
+    writable().erase(symbol);
+    cache_.clear();
+}
+
+bool MacroExpander::isDefined(std::string_view name) const {
+    return !empty() && find(intern(name));
+}
+
+const Macro* MacroExpander::find(Symbol symbol) const {
+    if (recording_) lookups_.insert(symbol);
+    auto it = macros_->find(symbol);
+    return it == macros_->end() ? nullptr : it->second.get();
+}
+
+// --- Expansion ---
+
+void MacroExpander::expand(const PPToken& name, const Pull& pull, std::vector<PPToken>& out) {
+    std::vector<PPToken> pending{name};
+    rescan(pending, &pull, false, out);
+}
+
+std::vector<PPToken> MacroExpander::expandAll(const std::vector<PPToken>& tokens, bool ifCondition) {
+    std::vector<PPToken> pending(tokens.rbegin(), tokens.rend());
+    std::vector<PPToken> out;
+    rescan(pending, nullptr, ifCondition, out);
+    return out;
+}
+
+void MacroExpander::rescan(std::vector<PPToken>& pending, const Pull* pull, bool ifCondition,
+                           std::vector<PPToken>& out) {
+    // pending is a stack: its back is the next token. A replacement is pushed back onto it,
+    // so it is rescanned together with whatever follows. Only an invocation's '(' and
+    // arguments are pulled past the end of pending.
+    auto next = [&](PPToken& token) {
+        if (pending.empty()) return pull && (*pull)(token);
+        token = std::move(pending.back());
+        pending.pop_back();
+        return true;
+    };
+    auto push = [&pending](const std::vector<PPToken>& replacement, bool spaceBefore) {
+        pending.insert(pending.end(), replacement.rbegin(), replacement.rend());
+        if (!replacement.empty()) pending.back().spaceBefore = spaceBefore;
+    };
+
+    PPToken token;
+    while (!pending.empty()) {
+        next(token);
+        if (ifCondition && token.token.type() == TokenType::IDENTIFIER && token.token.text() == "defined") {
+            // defined NAME / defined ( NAME ): the name is tested, not expanded
+            out.push_back(std::move(token));
+            PPToken operand;
+            if (!next(operand)) continue;
+            bool paren = operand.token.type() == TokenType::LEFT_PAREN;
+            out.push_back(operand);
+            for (int i = 0; paren && i < 2 && next(operand); ++i) out.push_back(operand);
+            continue;
+        }
+        const Macro* macro = token.token.type() == TokenType::IDENTIFIER ? find(token.token.symbol()) : nullptr;
+        if (!macro || contains(token.hide, macro->symbol)) {
+            out.push_back(std::move(token));
+            continue;
+        }
+        if (!macro->functionLike) {
+            push(substitute(*macro, {}, with(token.hide, *macro), ifCondition), token.spaceBefore);
+            continue;
+        }
+
+        // A function-like macro name is only an invocation when '(' follows
+        PPToken open;
+        if (!next(open)) {
+            out.push_back(std::move(token));
+            continue;
+        }
+        if (open.token.type() != TokenType::LEFT_PAREN) {
+            out.push_back(std::move(token));
+            pending.push_back(std::move(open));
+            continue;
+        }
+        std::vector<PPToken> consumed{token, open};
+        std::vector<std::vector<PPToken>> args(1);
+        PPToken close;
+        bool closed = false;
+        int depth = 0;
+        PPToken arg;
+        while (next(arg)) {
+            consumed.push_back(arg);
+            TokenType type = arg.token.type();
+            if (type == TokenType::RIGHT_PAREN && depth == 0) {
+                close = arg;
+                closed = true;
+                break;
+            }
+            if (type == TokenType::LEFT_PAREN) ++depth;
+            if (type == TokenType::RIGHT_PAREN) --depth;
+            // Commas past the named parameters of a variadic macro belong to its last argument
+            if (type == TokenType::COMMA && depth == 0 &&
+                !(macro->variadic && args.size() == macro->params.size())) {
+                args.emplace_back();
+                continue;
+            }
+            args.back().push_back(arg);
+        }
+        // M() passes no arguments to a macro without parameters; a variadic macro's variable
+        // arguments may be left out
+        if (macro->params.empty() && args.size() == 1 && args[0].empty()) args.clear();
+        if (macro->variadic && args.size() + 1 == macro->params.size()) args.emplace_back();
+        if (!closed || args.size() != macro->params.size()) {
+            if (!closed) {
+                LOG_WARN(LogCategory::Lexer, "Unterminated invocation of macro '" << macro->name << "'");
+            } else {
+                LOG_WARN(LogCategory::Lexer, "Macro '" << macro->name << "' takes " << macro->params.size()
+                                                       << " argument(s), " << args.size() << " given");
+            }
+            out.insert(out.end(), consumed.begin(), consumed.end());
+            continue;
+        }
+        bool cacheable = !ifCondition && !token.hide && !close.hide;
+        for (const auto& a : args) {
+            for (const auto& t : a) cacheable = cacheable && !t.hide;
+        }
+        std::vector<PPToken> scratch;
+        push(invoke(*macro, args, with(intersect(token.hide, close.hide), *macro), cacheable, ifCondition, scratch),
+             token.spaceBefore);
+    }
+}
+
+const std::vector<PPToken>& MacroExpander::invoke(const Macro& macro, std::vector<std::vector<PPToken>>& args,
+                                                  const HideSet& hide, bool cacheable, bool ifCondition,
+                                                  std::vector<PPToken>& scratch) {
+    if (!cacheable) {
+        scratch = substitute(macro, args, hide, ifCondition);
+        return scratch;
+    }
+    uint64_t key = hashBytes(reinterpret_cast<const char*>(&macro.symbol), sizeof(macro.symbol));
+    for (const auto& arg : args) {
+        for (const auto& t : arg) {
+            char tag[2] = {static_cast<char>(t.token.type()), static_cast<char>(t.spaceBefore)};
+            key = hashString(t.token.text(), hashBytes(tag, sizeof(tag), key));
+        }
+        key = hashBytes(",", 1, key);
+    }
+    auto range = cache_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        const CacheEntry& entry = it->second;
+        bool same = entry.macro == &macro && entry.args.size() == args.size();
+        for (size_t i = 0; same && i < args.size(); ++i) {
+            same = std::equal(args[i].begin(), args[i].end(), entry.args[i].begin(), entry.args[i].end(), sameToken);
+        }
+        if (same) {
+            ++cacheHits_;
+            return entry.result;
+        }
+    }
+    ++cacheMisses_;
+    if (cache_.size() >= kMaxCacheEntries) cache_.clear();
+    std::vector<PPToken> result = substitute(macro, args, hide, ifCondition);
+    auto it = cache_.emplace(key, CacheEntry{&macro, std::move(args), std::move(result)});
+    return it->second.result;
+}
+
+std::vector<PPToken> MacroExpander::substitute(const Macro& macro, const std::vector<std::vector<PPToken>>& args,
+                                               const HideSet& hide, bool ifCondition) {
+    // Arguments are macro-expanded on their own first, unless they are operands of # or ##
+    std::vector<std::vector<PPToken>> expanded(args.size());
+    std::vector<bool> isExpanded(args.size(), false);
+    auto expandedArg = [&](int param) -> const std::vector<PPToken>& {
+        if (!isExpanded[param]) {
+            std::vector<PPToken> pending(args[param].rbegin(), args[param].rend());
+            rescan(pending, nullptr, ifCondition, expanded[param]);
+            isExpanded[param] = true;
+        }
+        return expanded[param];
+    };
+
+    std::vector<PPToken> result;
+    bool pastePending = false;   // The previous part was followed by ##
+    bool leftNonEmpty = false;   // ... and produced at least one token
+    for (const Macro::Part& part : macro.body) {
+        size_t start = result.size();
+        if (part.stringize) {
+            result.push_back(stringize(args[part.param]));
+        } else if (part.param >= 0) {
+            const auto& tokens = part.pasteNext || pastePending ? args[part.param] : expandedArg(part.param);
+            result.insert(result.end(), tokens.begin(), tokens.end());
+        } else {
+            result.push_back(part.token);
+        }
+        bool nonEmpty = result.size() > start;
+        if (nonEmpty) result[start].spaceBefore = part.token.spaceBefore;
+        if (pastePending && leftNonEmpty && nonEmpty) {
+            std::vector<PPToken> pasted = paste(result[start - 1], result[start]);
+            result.erase(result.begin() + start - 1, result.begin() + start + 1);
+            result.insert(result.begin() + start - 1, pasted.begin(), pasted.end());
+        }
+        // An empty operand of ## leaves the other one as it is
+        leftNonEmpty = nonEmpty || (pastePending && leftNonEmpty);
+        pastePending = part.pasteNext;
+    }
+    for (PPToken& token : result) token.hide = unite(token.hide, hide);
+    return result;
+}
+
+PPToken MacroExpander::stringize(const std::vector<PPToken>& arg) {
+    std::string text;
+    for (size_t i = 0; i < arg.size(); ++i) {
+        if (i > 0 && arg[i].spaceBefore) text += ' ';
+        TokenType type = arg[i].token.type();
+        std::string spelling = spellToken(arg[i].token);
+        if (type != TokenType::STRING_LITERAL && type != TokenType::CHARACTER) {
+            text += spelling;
+            continue;
+        }
+        for (char c : spelling) {
+            if (c == '"' || c == '\\') text += '\\';
+            text += c;
+        }
+    }
+    PPToken token;
+    token.token = Token(TokenType::STRING_LITERAL, storage_->store(text), 0, 0);
+    return token;
+}
+
+std::vector<PPToken> MacroExpander::paste(const PPToken& left, const PPToken& right) {
+    std::string text = spellToken(left.token) + spellToken(right.token);
+    std::vector<PPToken> tokens = Lexer::lexFragment(storage_->store(text), *storage_);
+    if (tokens.size() == 1) {
+        tokens[0].spaceBefore = left.spaceBefore;
+        tokens[0].hide = left.hide;
+        return tokens;
+    }
+    LOG_WARN(LogCategory::Lexer, "Pasting '" << left.token.text() << "' and '" << right.token.text()
+                                             << "' does not give a valid token");
+    return {left, right};
+}
+
+// --- Spelling ---
+
+std::string spellToken(const Token& token) {
+    switch (token.type()) {
+        case TokenType::STRING_LITERAL: return "\"" + std::string(token.text()) + "\"";
+        case TokenType::CHARACTER: return "'" + std::string(token.text()) + "'";
+        default: return std::string(token.text());
+    }
+}
+
+std::string spellTokens(const std::vector<PPToken>& tokens) {
+    std::string text;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (i > 0 && tokens[i].spaceBefore) text += ' ';
+        text += spellToken(tokens[i].token);
+    }
+    return text;
+}
@@ -0,0 +1,134 @@
+#ifndef MACRO_HPP
+#define MACRO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "token.hpp"
+
+// Macros whose expansion produced a token; they are not expanded again when the token is
+// rescanned, which is what ends recursion. Sorted, immutable and shared; null is the empty set.
+using HideSet = std::shared_ptr<const std::vector<Symbol>>;
+
+// A token as the preprocessor sees it
+struct PPToken {
+    Token token;
+    bool spaceBefore = false;   // Whitespace preceded it (kept by # and when respelling)
+    HideSet hide;
+};
+
+// A #define, tokenised once when it is defined
+struct Macro {
+    struct Part {
+        PPToken token;
+        int param = -1;           // Replaced by this argument (-1: copied as is)
+        bool stringize = false;   // #param: the argument's spelling as a string literal
+        bool pasteNext = false;   // Followed by ##: concatenated with the next part
+    };
+
+    std::string name;
+    Symbol symbol = sym::None;
+    HideSet self;                 // {symbol}
+    bool functionLike = false;
+    bool variadic = false;        // The last parameter collects the remaining arguments
+    std::vector<std::string> params;
+    std::string text;             // Replacement list as written; body texts point into it or storage
+    uint64_t hash = 0;            // Of the definition (never 0); equal definitions hash the same
+    bool integer = false;         // Object-like, and the body is one integer literal, maybe in parentheses
+    long long value = 0;          // The literal's value, if integer; #if reads it without expanding
+    std::shared_ptr<TokenStorage> storage;
+    std::vector<Part> body;
+};
+
+// Macros by name; definitions are immutable, so tables share them
+using MacroTable = std::unordered_map<Symbol, std::shared_ptr<const Macro>>;
+
+// Build a macro from the rest of its #define line after the name: "(params) body" for a
+// function-like macro, else the body. Returns null and sets error on a bad parameter list.
+std::shared_ptr<const Macro> parseMacroDefinition(const std::string& name, std::string_view definition,
+                                                  std::string& error);
+// The inverse: the #define line after the macro's name
+std::string definitionText(const Macro& macro);
+
+// The macro table and token-level expansion (hide-set algorithm). Texts that expansion
+// creates with # and ## go into the storage passed in, so they live as long as the tokens.
+class MacroExpander {
+public:
+    // Supplies the tokens after an invocation (a function-like macro's '(' and arguments);
+    // returns false at the end of the input or at a directive.
+    using Pull = std::function<bool(PPToken&)>;
+
+    explicit MacroExpander(std::shared_ptr<TokenStorage> storage)
+        : macros_(std::make_shared<MacroTable>()), storage_(std::move(storage)) {}
+
+    void define(std::shared_ptr<const Macro> macro);
+    void undefine(std::string_view name);
+    bool isDefined(std::string_view name) const;
+    bool empty() const { return macros_->empty() && !recording_; }
+    const Macro* find(Symbol symbol) const;
+    // Take other's definitions (not its expansion cache). Tables are shared until one side
+    // defines or undefines something, so this is cheap however many macros there are.
+    void copyDefinitions(const MacroExpander& other) { copyDefinitions(other.share()); }
+    void copyDefinitions(std::shared_ptr<const MacroTable> definitions);
+    const MacroTable& definitions() const { return *macros_; }
+    // The table as it is now, unaffected by later changes here
+    std::shared_ptr<const MacroTable> share() const;
+
+    // From now on remember every name find() and isDefined() are asked about, defined or not,
+    // e.g. to learn which macros a header depends on. While recording, empty() is false so
+    // that callers still look names up.
+    void recordLookups() { recording_ = true; }
+    const std::unordered_set<Symbol>& lookups() const { return lookups_; }
+
+    // Expand the invocation starting at name (an identifier naming a defined macro), pulling
+    // further tokens as needed, and append the fully rescanned result to out
+    void expand(const PPToken& name, const Pull& pull, std::vector<PPToken>& out);
+    // Expand every macro in tokens, e.g. an #if condition. In an #if condition the operand of
+    // defined is left alone.
+    std::vector<PPToken> expandAll(const std::vector<PPToken>& tokens, bool ifCondition);
+
+    size_t cacheHits() const { return cacheHits_; }
+    size_t cacheMisses() const { return cacheMisses_; }
+
+private:
+    std::shared_ptr<MacroTable> macros_;
+    mutable bool shared_ = false;   // macros_ is also referenced elsewhere: copy before changing it
+    std::shared_ptr<TokenStorage> storage_;
+    bool recording_ = false;
+    mutable std::unordered_set<Symbol> lookups_;
+
+    // Memo of substituted function-like invocations, keyed by the macro and a hash of the
+    // argument tokens. Arguments are compared on a hit; any #define or #undef clears it,
+    // since argument pre-expansion depends on the whole table.
+    struct CacheEntry {
+        const Macro* macro;
+        std::vector<std::vector<PPToken>> args;
+        std::vector<PPToken> result;
+    };
+    std::unordered_multimap<uint64_t, CacheEntry> cache_;
+    size_t cacheHits_ = 0;
+    size_t cacheMisses_ = 0;
+
+    MacroTable& writable();
+    void rescan(std::vector<PPToken>& pending, const Pull* pull, bool ifCondition, std::vector<PPToken>& out);
+    std::vector<PPToken> substitute(const Macro& macro, const std::vector<std::vector<PPToken>>& args,
+                                    const HideSet& hide, bool ifCondition);
+    const std::vector<PPToken>& invoke(const Macro& macro, std::vector<std::vector<PPToken>>& args,
+                                       const HideSet& hide, bool cacheable, bool ifCondition,
+                                       std::vector<PPToken>& scratch);
+    PPToken stringize(const std::vector<PPToken>& arg);
+    std::vector<PPToken> paste(const PPToken& left, const PPToken& right);
+};
+
+// Source spelling of a token (string and character literals get their quotes back)
+std::string spellToken(const Token& token);
+// Tokens back to text, with a space wherever whitespace separated them
+std::string spellTokens(const std::vector<PPToken>& tokens);
+
+#endif // MACRO_HPP
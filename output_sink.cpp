@@ -0,0 +1,110 @@
+#include "output_sink.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+FileSink::FileSink(const std::string& path) : path_(path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+    buffer_ = static_cast<char*>(std::aligned_alloc(kAlignment, kBufferSize));
+    if (!buffer_) {
+        ::close(fd_);
+        throw std::bad_alloc();
+    }
+}
+
+FileSink::~FileSink() {
+    if (fd_ >= 0) {
+        // Best effort: errors can only be reported by an explicit close()
+        try {
+            close();
+        } catch (const std::exception&) {
+        }
+    }
+    std::free(buffer_);
+}
+
+void FileSink::write(std::string_view data) {
+    bytesWritten_ += data.size();
+    if (used_ + data.size() <= kBufferSize) {
+        std::memcpy(buffer_ + used_, data.data(), data.size());
+        used_ += data.size();
+        if (used_ == kBufferSize) {
+            writeRaw(buffer_, used_);
+            used_ = 0;
+        }
+        return;
+    }
+    // Top up the buffer to a full block, then pass whole blocks straight through
+    size_t fill = kBufferSize - used_;
+    std::memcpy(buffer_ + used_, data.data(), fill);
+    writeRaw(buffer_, kBufferSize);
+    data.remove_prefix(fill);
+    size_t direct = data.size() - data.size() % kBufferSize;
+    if (direct) writeRaw(data.data(), direct);
+    data.remove_prefix(direct);
+    std::memcpy(buffer_, data.data(), data.size());
+    used_ = data.size();
+}
+
+void FileSink::close() {
+    if (fd_ < 0) return;
+    int fd = fd_;
+    if (used_) {
+        size_t used = used_;
+        used_ = 0;
+        try {
+            writeRaw(buffer_, used);
+        } catch (...) {
+            fd_ = -1;
+            ::close(fd);
+            throw;
+        }
+    }
+    fd_ = -1;
+    if (::close(fd) != 0) {
+        throw std::runtime_error("Could not write " + path_ + ": " + std::strerror(errno));
+    }
+}
+
+void FileSink::writeRaw(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Could not write " + path_ + ": " + std::strerror(errno));
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+void MemorySink::write(std::string_view data) {
+    bytesWritten_ += data.size();
+    text_.append(data.data(), data.size());
+}
+
+void StdoutSink::write(std::string_view data) {
+    bytesWritten_ += data.size();
+    std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void StdoutSink::close() {
+    std::cout.flush();
+}
+
+void TeeSink::write(std::string_view data) {
+    bytesWritten_ += data.size();
+    for (OutputSink* sink : sinks_) sink->write(data);
+}
+
+void TeeSink::close() {
+    for (OutputSink* sink : sinks_) sink->close();
+}
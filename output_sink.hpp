@@ -0,0 +1,78 @@
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Destination for generated Java. Code generation streams into a sink piece by piece, so the
+// whole program never has to exist as one string and output starts before generation ends.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+    virtual void write(std::string_view data) = 0;
+    // Push out anything buffered; throws std::runtime_error on I/O failure
+    virtual void close() {}
+
+    uint64_t bytesWritten() const { return bytesWritten_; }
+
+protected:
+    uint64_t bytesWritten_ = 0;
+};
+
+// Buffered file writer: fills a page-aligned buffer and hands it to write(2) in large blocks
+class FileSink : public OutputSink {
+public:
+    // Truncates path; throws std::runtime_error if it cannot be opened
+    explicit FileSink(const std::string& path);
+    ~FileSink() override;
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    void write(std::string_view data) override;
+    void close() override;
+
+private:
+    static constexpr size_t kBufferSize = 256 * 1024;
+    static constexpr size_t kAlignment = 4096;
+
+    std::string path_;
+    int fd_ = -1;
+    char* buffer_ = nullptr;
+    size_t used_ = 0;
+
+    void writeRaw(const char* data, size_t size);
+};
+
+// Accumulates output in memory, for library and daemon use
+class MemorySink : public OutputSink {
+public:
+    void write(std::string_view data) override;
+    const std::string& str() const { return text_; }
+    std::string take() { return std::move(text_); }
+
+private:
+    std::string text_;
+};
+
+// Writes to stdout through std::cout
+class StdoutSink : public OutputSink {
+public:
+    void write(std::string_view data) override;
+    void close() override;
+};
+
+// Forwards everything to several sinks
+class TeeSink : public OutputSink {
+public:
+    explicit TeeSink(std::vector<OutputSink*> sinks) : sinks_(std::move(sinks)) {}
+    void write(std::string_view data) override;
+    void close() override;
+
+private:
+    std::vector<OutputSink*> sinks_;
+};
+
+#endif // OUTPUT_SINK_HPP
@@ -1,4 +1,5 @@
 #include "parser.hpp"
+#include "log.hpp"
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
@@ -6,45 +7,29 @@
 
 
 // --- Constructor ---
-Parser::Parser(std::vector<std::unique_ptr<Token>>&& tokens)
-    : tokens(std::move(tokens)), currentIndex(0) {
-    
-    if (!this->tokens.empty()) {
-        current = *this->tokens[0];
-    }
+Parser::Parser(TokenBuffer&& tokens)
+    : tokens(std::move(tokens)) {
+    current = this->tokens.peek();
     // Initialize log storage
     parseLogs.clear();
-    logFile.open("OUTPUT/parser_logs.txt", std::ios::out | std::ios::trunc);
-    if (!logFile.is_open()) {
-        throw std::runtime_error("Failed to open OUTPUT/parser_logs.txt for writing");
-    }
-    logFile<< "[Parser] Log file opened successfully." << std::endl;
 }
-Parser::~Parser() {
-    
-    logFile.flush();
-    if (logFile.is_open()) {
-        logFile.close();
-    }
+
+Parser::Parser(Lexer& lexer)
+    : tokens(lexer) {
+    current = tokens.peek();
+    // Initialize log storage
+    parseLogs.clear();
 }
 
 // --- Token helpers ---
 void Parser::advance() {
     
     prev = current;
-    if (currentIndex + 1 < tokens.size()) {
-        currentIndex++;
-        current = *tokens[currentIndex];
-    } else {
-        // Stay at END_OF_FILE
-        current = *tokens.back();
-    }
+    tokens.advance();   // Stays at END_OF_FILE
+    current = tokens.peek();
     // Store the token log instead of printing
     // parseLogs.push_back("[Parser] : " + current.toString());
-    logFile << "[Parser] : " << current.toString() << std::endl;
-    std::cout << "[Parser] : ";
-    std::cout << current.toString() << std::endl;
-    logFile.flush();
+    LOG_DEBUG(LogCategory::Parser, current.toString());
 }
 
 bool Parser::match(TokenType type) {
@@ -83,7 +68,7 @@ std::unique_ptr<Program> Parser::parse() {
 }
 
 std::unique_ptr<Program> Parser::parseProgram() {
-    std::cout << "[DEBUG] :: parseProgram" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "parseProgram");
     auto program = std::make_unique<Program>();
     while (current.type() != TokenType::END_OF_FILE) {
         auto decl = parseDeclaration();
@@ -95,7 +80,7 @@ std::unique_ptr<Program> Parser::parseProgram() {
 
 // --- Declarations ---
 std::unique_ptr<ASTNode> Parser::parseDeclaration() {
-    std::cout << "[DEBUG] :: Declaration" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Declaration");
     // Handle preprocessor directives (HASH and related)
     if (current.type() == TokenType::HASH) {
         // Always call parsePreprocessorDirective to build AST node for preprocessor lines
@@ -236,18 +221,18 @@ bool Parser::isTypeToken(TokenType type) {
 std::unique_ptr<ASTNode> Parser::parseClassDecl() {
     expect(TokenType::CLASS, "Expected 'class' keyword");
     expect(TokenType::IDENTIFIER, "Expected class name");
-    std::string name = previous().text();
+    std::string name(previous().text());
     std::vector<BaseSpecifier> bases;
     // Parse inheritance list
     if (match(TokenType::COLON)) {
         do {
             std::string access = "private"; // default for class
             if (check(TokenType::PUBLIC) || check(TokenType::PROTECTED) || check(TokenType::PRIVATE)) {
-                access = current.text();
+                access = std::string(current.text());
                 advance();
             }
             expect(TokenType::IDENTIFIER, "Expected base class name");
-            std::string baseName = previous().text();
+            std::string baseName(previous().text());
             bases.emplace_back(baseName, access);
         } while (match(TokenType::COMMA));
     }
@@ -274,18 +259,18 @@ std::unique_ptr<ASTNode> Parser::parseClassDecl() {
 std::unique_ptr<ASTNode> Parser::parseStructDecl() {
     expect(TokenType::STRUCT, "Expected 'struct' keyword");
     expect(TokenType::IDENTIFIER, "Expected struct name");
-    std::string name = previous().text();
+    std::string name(previous().text());
     std::vector<BaseSpecifier> bases;
     // Parse inheritance list
     if (match(TokenType::COLON)) {
         do {
             std::string access = "public"; // default for struct
             if (check(TokenType::PUBLIC) || check(TokenType::PROTECTED) || check(TokenType::PRIVATE)) {
-                access = current.text();
+                access = std::string(current.text());
                 advance();
             }
             expect(TokenType::IDENTIFIER, "Expected base struct/class name");
-            std::string baseName = previous().text();
+            std::string baseName(previous().text());
             bases.emplace_back(baseName, access);
         } while (match(TokenType::COMMA));
     }
@@ -312,17 +297,20 @@ std::unique_ptr<ASTNode> Parser::parseStructDecl() {
 // ...existing code...
 // --- Example: Variable Declaration ---
 std::unique_ptr<ASTNode> Parser::parseVariableDecl() {
-    std::cout << "[DEBUG] :: VariableDecl" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "VariableDecl");
     // Parse base type identifier
-    std::string typeName = current.text();
+    TokenStream::Mark typeStart = tokens.mark();
+    std::string typeName(current.text());
     advance();
     // Check for template type (e.g., vector<int>)
     std::unique_ptr<ASTNode> typeNode = std::make_unique<Identifier>(typeName);
     if (current.type() == TokenType::LESS) { // '<'
         // Use parseType to handle template arguments and nesting
-        currentIndex -= 1;
-        current = *tokens[currentIndex];
+        tokens.rewind(typeStart);
+        current = tokens.peek();
         typeNode = parseType();
+    } else {
+        tokens.release(typeStart);
     }
     // Handle pointer/reference tokens between type and variable name
     while (current.type() == TokenType::STAR || current.type() == TokenType::AMPERSAND) {
@@ -337,7 +325,7 @@ std::unique_ptr<ASTNode> Parser::parseVariableDecl() {
     expect(TokenType::IDENTIFIER, "Expected variable name");
     std::vector<std::string> names;
     std::vector<std::unique_ptr<ASTNode>> initializers;
-    names.push_back(previous().text());
+    names.emplace_back(previous().text());
     std::unique_ptr<ASTNode> firstInit = nullptr;
     if (match(TokenType::EQUAL)) {
         firstInit = parseExpression();
@@ -353,7 +341,7 @@ std::unique_ptr<ASTNode> Parser::parseVariableDecl() {
     // Parse additional variables separated by commas
     while (match(TokenType::COMMA)) {
         expect(TokenType::IDENTIFIER, "Expected variable name after ','");
-        names.push_back(previous().text());
+        names.emplace_back(previous().text());
         std::unique_ptr<ASTNode> nextInit = nullptr;
         if (match(TokenType::EQUAL)) {
             nextInit = parseExpression();
@@ -387,8 +375,8 @@ std::unique_ptr<ASTNode> Parser::parseVariableDecl() {
 }
 // Helper for parseDeclaration only
 std::unique_ptr<ASTNode> Parser::parseVariableDeclFromTokens(const Token& typeToken, const Token& nameToken) {
-    std::cout << "[DEBUG] :: VariableDeclFromTokens" << std::endl;
-    std::string typeName = typeToken.text();
+    LOG_DEBUG(LogCategory::Parser, "VariableDeclFromTokens");
+    std::string typeName(typeToken.text());
     std::unique_ptr<ASTNode> typeNode = std::make_unique<Identifier>(typeName);
     // Handle pointer/reference tokens between type and variable name
     while (current.type() == TokenType::STAR || current.type() == TokenType::AMPERSAND) {
@@ -399,7 +387,7 @@ std::unique_ptr<ASTNode> Parser::parseVariableDeclFromTokens(const Token& typeTo
         }
         advance();
     }
-    std::string varName = nameToken.text();
+    std::string varName(nameToken.text());
     auto varNode = std::make_unique<VarDecl>(varName);
     varNode->type = std::move(typeNode);
     if (match(TokenType::EQUAL)) {
@@ -411,11 +399,11 @@ std::unique_ptr<ASTNode> Parser::parseVariableDeclFromTokens(const Token& typeTo
 
 // --- Example: Function Declaration ---
 std::unique_ptr<ASTNode> Parser::parseFunctionDecl() {
-    std::cout << "[DEBUG] :: FunctionDecl" << std::endl;
-    std::string returnType = current.text();
+    LOG_DEBUG(LogCategory::Parser, "FunctionDecl");
+    std::string returnType(current.text());
     advance();
     expect(TokenType::IDENTIFIER, "Expected function name");
-    std::string funcName = previous().text();
+    std::string funcName(previous().text());
     expect(TokenType::LEFT_PAREN, "Expected '(' after function name");
     auto funcNode = std::make_unique<FunctionDecl>(funcName);
     funcNode->returnType = std::make_unique<Identifier>(returnType);
@@ -425,7 +413,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDecl() {
         do {
             auto paramType = parseType();
             expect(TokenType::IDENTIFIER, "Expected parameter name");
-            std::string paramName = previous().text();
+            std::string paramName(previous().text());
             parameters.push_back(std::make_unique<VarDecl>(paramName, std::move(paramType)));
         } while (match(TokenType::COMMA));
     }
@@ -439,11 +427,11 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDecl() {
 }
 // Helper for parseDeclaration only
 std::unique_ptr<ASTNode> Parser::parseFunctionDeclFromTokens(const Token& typeToken, const Token& nameToken) {
-    std::cout << "[DEBUG] ::FunctionDeclFromTokens" << std::endl;
-    std::string returnType = typeToken.text();
-    std::string funcName = nameToken.text();
+    LOG_DEBUG(LogCategory::Parser, "FunctionDeclFromTokens");
+    std::string returnType(typeToken.text());
+    std::string funcName(nameToken.text());
     expect(TokenType::LEFT_PAREN, "Expected '(' after function name");
-    auto funcNode = std::make_unique<FunctionDecl>(funcName);
+    auto funcNode = std::make_unique<FunctionDecl>(funcName, nameToken.symbol());
     funcNode->returnType = std::make_unique<Identifier>(returnType);
     // Parse parameters (support multiple)
     std::vector<std::unique_ptr<VarDecl>> parameters;
@@ -451,13 +439,13 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclFromTokens(const Token& typeTo
         do {
             auto paramType = parseType();
             expect(TokenType::IDENTIFIER, "Expected parameter name");
-            std::string paramName = previous().text();
+            std::string paramName(previous().text());
             parameters.push_back(std::make_unique<VarDecl>(paramName, std::move(paramType)));
         } while (match(TokenType::COMMA));
     }
     expect(TokenType::RIGHT_PAREN, "Expected ')' after parameters");
     if (funcNode->isVirtual) {
-        std::cout << funcNode->isVirtual <<std::endl;
+        LOG_DEBUG(LogCategory::Parser, "isVirtual " << funcNode->isVirtual);
         if (check(TokenType::EQUAL)) {
             advance();
             if (check(TokenType::INTEGER) && current.text() == "0") {
@@ -486,7 +474,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclFromTokens(const Token& typeTo
 
 // --- Example: Block ---
 std::unique_ptr<ASTNode> Parser::parseBlock() {
-    std::cout << "[DEBUG] :: Block" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Block");
     expect(TokenType::LEFT_BRACE, "Expected '{' to start block");
     auto block = std::make_unique<BlockStmt>();
     while (current.type() != TokenType::RIGHT_BRACE && current.type() != TokenType::END_OF_FILE) {
@@ -498,7 +486,7 @@ std::unique_ptr<ASTNode> Parser::parseBlock() {
 
 // --- Example: Statement ---
 std::unique_ptr<ASTNode> Parser::parseStatement() {
-    std::cout << "[DEBUG] :: Statement" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Statement");
     if (check(TokenType::IF)) return parseIfStmt();
     if (check(TokenType::WHILE)) return parseWhileStmt();
     if (check(TokenType::FOR)) return parseForStmt();
@@ -511,7 +499,7 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
     if (isTypeToken(current.type())) {
         // Peek ahead: type IDENTIFIER [EQUAL|SEMICOLON|LEFT_BRACKET|COMMA]
         Token typeToken = current;
-        size_t saveIndex = currentIndex;
+        TokenStream::Mark save = tokens.mark();
         advance();
         if (current.type() == TokenType::IDENTIFIER) {
             Token nameToken = current;
@@ -520,7 +508,7 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
             // If next token is EQUAL, treat as declaration ONLY if previous token was not already a variable (i.e., not an assignment)
             if (current.type() == TokenType::SEMICOLON || current.type() == TokenType::LEFT_BRACKET || current.type() == TokenType::COMMA) {
                 // Rewind to type token and parse as variable declaration
-                currentIndex = saveIndex;
+                tokens.rewind(save);
                 current = typeToken;
                 return parseVariableDecl();
             }
@@ -528,7 +516,7 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
             if (current.type() == TokenType::EQUAL) {
                 // If the type token is a built-in type or known type, treat as declaration
                 if (typeToken.type() != TokenType::IDENTIFIER || isTypeToken(typeToken.type())) {
-                    currentIndex = saveIndex;
+                    tokens.rewind(save);
                     current = typeToken;
                     return parseVariableDecl();
                 }
@@ -536,8 +524,8 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
             }
         }
         // Not a declaration, rewind and parse as expression
-        currentIndex = saveIndex;
-        current = *tokens[currentIndex];
+        tokens.rewind(save);
+        current = tokens.peek();
     }
     // Fallback: expression statement
     // size_t exprStart = currentIndex;
@@ -546,7 +534,7 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
     // size_t exprEnd = currentIndex;
     // std::string cppExprStr;
     // for (size_t i = exprStart; i < exprEnd; ++i) {
-    //     cppExprStr += tokens[i]->text() ;
+    //     cppExprStr += tokens[i].text() ;
     // }
     // auto stmt = std::make_unique<ExpressionStmt>(std::move(expr));
     // stmt->cppExpr = cppExprStr;
@@ -556,23 +544,20 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseExpressionstmt(){
-    std::cout << "[DEBUG] :: ExpressionStmt" << std::endl;
-    size_t exprStart = currentIndex;
+    LOG_DEBUG(LogCategory::Parser, "ExpressionStmt");
+    TokenStream::Mark exprStart = tokens.mark();
     auto expr = parseExpression();
     expect(TokenType::SEMICOLON, "Expected ';' after expression");
-    size_t exprEnd = currentIndex;
-    std::string cppExprStr;
-    for (size_t i = exprStart; i < exprEnd; ++i) {
-        cppExprStr += tokens[i]->text() ;
-    }
+    std::string cppExprStr = tokens.textSince(exprStart);
+    tokens.release(exprStart);
     auto stmt = std::make_unique<ExpressionStmt>(std::move(expr));
     stmt->cppExpr = cppExprStr;
-    std::cout << stmt->cppExpr<< std::endl;
+    LOG_DEBUG(LogCategory::Parser, stmt->cppExpr);
     return stmt;
 }
 // --- parseTryStmt ---
 std::unique_ptr<ASTNode> Parser::parseTryStmt() {
-    std::cout << "[DEBUG] :: TryStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "TryStmt");
     expect(TokenType::TRY, "Expected 'try'");
     auto tryBlockNode = parseBlock();
     auto tryBlock = std::unique_ptr<BlockStmt>(static_cast<BlockStmt*>(tryBlockNode.release()));
@@ -585,7 +570,7 @@ std::unique_ptr<ASTNode> Parser::parseTryStmt() {
 
 // --- parseThrowStmt ---
 std::unique_ptr<ASTNode> Parser::parseThrowStmt() {
-    std::cout << "[DEBUG] :: ThrowStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "ThrowStmt");
     expect(TokenType::THROW, "Expected 'throw'");
     auto expr = parseExpression();
     expect(TokenType::SEMICOLON, "Expected ';' after throw statement");
@@ -594,7 +579,7 @@ std::unique_ptr<ASTNode> Parser::parseThrowStmt() {
 
 // --- parseBreakStmt ---
 std::unique_ptr<ASTNode> Parser::parseBreakStmt() {
-    std::cout << "[DEBUG] :: BreakStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "BreakStmt");
     expect(TokenType::BREAK, "Expected 'break'");
     expect(TokenType::SEMICOLON, "Expected ';' after break");
     return std::make_unique<BreakStmt>();
@@ -602,7 +587,7 @@ std::unique_ptr<ASTNode> Parser::parseBreakStmt() {
 
 // --- parseContinueStmt ---
 std::unique_ptr<ASTNode> Parser::parseContinueStmt() {
-    std::cout << "[DEBUG] :: ContinueStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "ContinueStmt");
     expect(TokenType::CONTINUE, "Expected 'continue'");
     expect(TokenType::SEMICOLON, "Expected ';' after continue");
     return std::make_unique<ContinueStmt>();
@@ -610,17 +595,17 @@ std::unique_ptr<ASTNode> Parser::parseContinueStmt() {
 
 // --- parseGotoStmt ---
 std::unique_ptr<ASTNode> Parser::parseGotoStmt() {
-    std::cout << "[DEBUG] :: GotoStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "GotoStmt");
     expect(TokenType::GOTO, "Expected 'goto'");
     expect(TokenType::IDENTIFIER, "Expected label after 'goto'");
-    std::string name = previous().text();
+    std::string name(previous().text());
     expect(TokenType::SEMICOLON, "Expected ';' after goto statement");
     return std::make_unique<GotoStmt>(name); 
 }
 
 // --- parseElseStmt ---
 std::unique_ptr<ASTNode> Parser::parseElseStmt() {
-    std::cout << "[DEBUG] :: ElseStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "ElseStmt");
     expect(TokenType::ELSE, "Expected 'else'");
     auto elseBranch = parseStatement();
     return std::make_unique<ElseStmt>(std::move(elseBranch));
@@ -628,7 +613,7 @@ std::unique_ptr<ASTNode> Parser::parseElseStmt() {
 
 // --- parseSwitchStmt ---
 std::unique_ptr<ASTNode> Parser::parseSwitchStmt() {
-    std::cout << "[DEBUG] :: SwitchStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "SwitchStmt");
     expect(TokenType::SWITCH, "Expected 'switch'");
     expect(TokenType::LEFT_PAREN, "Expected '(' after 'switch'");
     auto condition = parseExpression();
@@ -650,7 +635,7 @@ std::unique_ptr<ASTNode> Parser::parseSwitchStmt() {
 
 // --- parseCaseStmt ---
 std::unique_ptr<ASTNode> Parser::parseCaseStmt() {
-    std::cout << "[DEBUG] :: CaseStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "CaseStmt");
     expect(TokenType::CASE, "Expected 'case'");
     auto value = parseExpression();
     expect(TokenType::COLON, "Expected ':' after case value");
@@ -663,7 +648,7 @@ std::unique_ptr<ASTNode> Parser::parseCaseStmt() {
 
 // --- parseDefaultStmt ---
 std::unique_ptr<ASTNode> Parser::parseDefaultStmt() {
-    std::cout << "[DEBUG] :: DefaultStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "DefaultStmt");
     expect(TokenType::DEFAULT, "Expected 'default'");
     expect(TokenType::COLON, "Expected ':' after default");
     std::vector<std::unique_ptr<ASTNode>> statements;
@@ -675,7 +660,7 @@ std::unique_ptr<ASTNode> Parser::parseDefaultStmt() {
 
 // --- parseDoWhileStmt ---
 std::unique_ptr<ASTNode> Parser::parseDoWhileStmt() {
-    std::cout << "[DEBUG] :: DoWhileStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "DoWhileStmt");
     expect(TokenType::DO, "Expected 'do'");
     auto body = parseStatement();
     expect(TokenType::WHILE, "Expected 'while' after do body");
@@ -688,10 +673,10 @@ std::unique_ptr<ASTNode> Parser::parseDoWhileStmt() {
 
 // --- parseUnionDecl ---
 std::unique_ptr<ASTNode> Parser::parseUnionDecl() {
-    std::cout << "[DEBUG] :: UnionDecl" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "UnionDecl");
     expect(TokenType::UNION, "Expected 'union'");
     expect(TokenType::IDENTIFIER, "Expected union name");
-    std::string name = previous().text();
+    std::string name(previous().text());
 
     expect(TokenType::LEFT_BRACE, "Expected '{' after union name");
     std::vector<std::unique_ptr<ASTNode>> members;
@@ -706,18 +691,18 @@ std::unique_ptr<ASTNode> Parser::parseUnionDecl() {
 
 // --- parseTypedefDecl ---
 std::unique_ptr<ASTNode> Parser::parseTypedefDecl() {
-    std::cout << "[DEBUG] :: TypedefDecl" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "TypedefDecl");
     expect(TokenType::TYPEDEF, "Expected 'typedef'");
     auto aliasedType = parseType(); 
     expect(TokenType::IDENTIFIER, "Expected typedef alias name");
-    std::string name = previous().text();
+    std::string name(previous().text());
     expect(TokenType::SEMICOLON, "Expected ';' after typedef");
     return std::make_unique<TypedefDecl>(name, std::move(aliasedType));
 }
 
 // --- parseTemplateTypeSuffix ---
 std::unique_ptr<ASTNode> Parser::parseTemplateTypeSuffix(std::string baseName) {
-    std::cout << "[DEBUG] :: TemplateTypeSuffix" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "TemplateTypeSuffix");
     expect(TokenType::LESS, "Expected '<' for template type");
     std::vector<std::unique_ptr<ASTNode>> typeArgs;
     do {
@@ -727,9 +712,31 @@ std::unique_ptr<ASTNode> Parser::parseTemplateTypeSuffix(std::string baseName) {
     return std::make_unique<TemplateType>(baseName, std::move(typeArgs));
 }
 
+namespace {
+
+// Argument count a call to a math or C string function must have to become a
+// MathFunctionCall, or -1 if the symbol is not one of them
+int builtinArity(Symbol callee) {
+    switch (callee) {
+        case sym::rand:
+            return 0;
+        case sym::sqrt: case sym::abs: case sym::fabs: case sym::sin: case sym::cos: case sym::tan:
+        case sym::floor: case sym::ceil: case sym::round: case sym::srand: case sym::strlen:
+            return 1;
+        case sym::pow: case sym::strcmp: case sym::strcpy: case sym::strcat:
+            return 2;
+        case sym::strncmp: case sym::strncpy: case sym::strncat:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+} // unnamed namespace
+
 // --- parseFunctionCallSuffix ---
 std::unique_ptr<ASTNode> Parser::parseFunctionCallSuffix(std::unique_ptr<ASTNode> callee) {
-    std::cout << "[DEBUG] :: FunctionCallSuffix" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "FunctionCallSuffix");
     std::vector<std::unique_ptr<ASTNode>> templateArgs;
     // Check for template instantiation: foo<int>(...)
     if (check(TokenType::LESS)) {
@@ -749,78 +756,25 @@ std::unique_ptr<ASTNode> Parser::parseFunctionCallSuffix(std::unique_ptr<ASTNode
     expect(TokenType::RIGHT_PAREN, "Expected ')' after arguments");
 
     // --- Recognize math and STL algorithm calls ---
-    std::string calleeName;
+    Symbol calleeSymbol = sym::None;
     if (callee->type == ASTNodeType::IDENTIFIER) {
-        calleeName = static_cast<Identifier*>(callee.get())->name;
-    }
-    // Math functions
-    if (calleeName == "sqrt" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("sqrt", std::move(args));
-    }
-    if (calleeName == "pow" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("pow", std::move(args));
-    }
-    if (calleeName == "abs" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("abs", std::move(args));
-    }
-    if (calleeName == "fabs" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("fabs", std::move(args));
-    }
-    if (calleeName == "sin" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("sin", std::move(args));
-    }
-    if (calleeName == "cos" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("cos", std::move(args));
-    }
-    if (calleeName == "tan" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("tan", std::move(args));
-    }
-    if (calleeName == "floor" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("floor", std::move(args));
-    }
-    if (calleeName == "ceil" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("ceil", std::move(args));
-    }
-    if (calleeName == "round" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("round", std::move(args));
-    }
-    if (calleeName == "rand" && args.size() == 0) {
-        return std::make_unique<MathFunctionCall>("rand", std::move(args));
-    }
-    if (calleeName == "srand" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("srand", std::move(args));
-    }
-    // String/char functions
-    if (calleeName == "strcmp" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("strcmp", std::move(args));
-    }
-    if (calleeName == "strncmp" && args.size() == 3) {
-        return std::make_unique<MathFunctionCall>("strncmp", std::move(args));
-    }
-    if (calleeName == "strcpy" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("strcpy", std::move(args));
-    }
-    if (calleeName == "strncpy" && args.size() == 3) {
-        return std::make_unique<MathFunctionCall>("strncpy", std::move(args));
-    }
-    if (calleeName == "strlen" && args.size() == 1) {
-        return std::make_unique<MathFunctionCall>("strlen", std::move(args));
-    }
-    if (calleeName == "strcat" && args.size() == 2) {
-        return std::make_unique<MathFunctionCall>("strcat", std::move(args));
-    }
-    if (calleeName == "strncat" && args.size() == 3) {
-        return std::make_unique<MathFunctionCall>("strncat", std::move(args));
-    }
-    // STL algorithms
-    if (calleeName == "sort") {
-        return std::make_unique<SortCall>(std::move(args));
-    }
-    if (calleeName == "find") {
-        return std::make_unique<FindCall>(std::move(args));
+        calleeSymbol = static_cast<Identifier*>(callee.get())->symbol;
+    }
+    switch (calleeSymbol) {
+        // STL algorithms
+        case sym::sort:
+            return std::make_unique<SortCall>(std::move(args));
+        case sym::find:
+            return std::make_unique<FindCall>(std::move(args));
+        case sym::accumulate:
+            return std::make_unique<AccumulateCall>(std::move(args));
+        default:
+            break;
     }
-    if (calleeName == "accumulate") {
-        return std::make_unique<AccumulateCall>(std::move(args));
+    // Math and string/char functions, recognized only with their usual argument count
+    int arity = builtinArity(calleeSymbol);
+    if (arity >= 0 && args.size() == size_t(arity)) {
+        return std::make_unique<MathFunctionCall>(std::string(spellingOf(calleeSymbol)), std::move(args));
     }
     // Fallback: generic function call
     return std::make_unique<FunctionCall>(std::move(callee), std::move(args), std::move(templateArgs));
@@ -829,13 +783,13 @@ std::unique_ptr<ASTNode> Parser::parseFunctionCallSuffix(std::unique_ptr<ASTNode
 
 // --- Expression Parsing with Precedence ---
 std::unique_ptr<ASTNode> Parser::parseExpression() {
-    std::cout << "[DEBUG] :: Expression" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Expression");
     return parseAssignment();
 }
 
 // --- Assignment Expression Parsing ---
 std::unique_ptr<ASTNode> Parser::parseAssignment() {
-    std::cout << "[DEBUG] :: Assignment" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Assignment");
     auto left = parseTernary();
     // Only allow assignment to identifiers, member access, or array access
     if (match(TokenType::EQUAL)) {
@@ -871,7 +825,7 @@ std::unique_ptr<ASTNode> parseBinary(){
 
 }
 std::unique_ptr<ASTNode> Parser::parseTernary() {
-    std::cout << "[DEBUG] :: Ternary" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Ternary");
     auto cond = parseLogicalOr();
     if (match(TokenType::QUESTION)) {
         auto thenExpr = parseExpression();
@@ -883,15 +837,14 @@ std::unique_ptr<ASTNode> Parser::parseTernary() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseLogicalOr() {
-    std::cout << "[DEBUG] :: LogicalOr" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "LogicalOr");
     auto left = parseLogicalAnd();
     while (match(TokenType::OR_OR)) {
         auto right = parseLogicalAnd();
         // Defensive: Only construct BinaryExpr if both left and right are valid
         if (!left || !right) {
             // parseLogs.push_back("[WARNING] Invalid BinaryExpr (||) with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (||) with null child" << std::endl;
-            logFile.flush();
+            LOG_WARN(LogCategory::Parser, "Invalid BinaryExpr (||) with null child");
             if (left) return left;
             if (right) return right;
             return nullptr;
@@ -902,15 +855,14 @@ std::unique_ptr<ASTNode> Parser::parseLogicalOr() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseLogicalAnd() {
-    std::cout << "[DEBUG] :: LogicalAnd" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "LogicalAnd");
     auto left = parseEquality();
     while (match(TokenType::AND_AND)) {
         auto right = parseEquality();
         // Defensive: Only construct BinaryExpr if both left and right are valid
         if (!left || !right) {
             // parseLogs.push_back("[WARNING] Invalid BinaryExpr (&&) with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (&&) with null child" << std::endl;
-            logFile.flush();
+            LOG_WARN(LogCategory::Parser, "Invalid BinaryExpr (&&) with null child");
             if (left) return left;
             if (right) return right;
             return nullptr;
@@ -921,16 +873,15 @@ std::unique_ptr<ASTNode> Parser::parseLogicalAnd() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseEquality() {
-    std::cout << "[DEBUG] :: Equality" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Equality");
     auto left = parseRelational();
     while (match(TokenType::EQUAL_EQUAL) || match(TokenType::NOT_EQUAL)) {
-        std::string op = previous().text();
+        std::string op(previous().text());
         auto right = parseRelational();
         // Defensive: Only construct BinaryExpr if both left and right are valid
         if (!left || !right) {
             // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
+            LOG_WARN(LogCategory::Parser, "Invalid BinaryExpr (" << op << ") with null child");
             if (left) return left;
             if (right) return right;
             return nullptr;
@@ -941,17 +892,16 @@ std::unique_ptr<ASTNode> Parser::parseEquality() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseRelational() {
-    std::cout << "[DEBUG] :: Relational" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Relational");
     auto left = parseAdditive();
     while (match(TokenType::LESS) || match(TokenType::LESS_EQUAL) ||
            match(TokenType::GREATER) || match(TokenType::GREATER_EQUAL)) {
-        std::string op = previous().text();
+        std::string op(previous().text());
         auto right = parseAdditive();
         // Defensive: Only construct BinaryExpr if both left and right are valid
         if (!left || !right) {
             // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
+            LOG_WARN(LogCategory::Parser, "Invalid BinaryExpr (" << op << ") with null child");
             if (left) return left;
             if (right) return right;
             return nullptr;
@@ -962,16 +912,15 @@ std::unique_ptr<ASTNode> Parser::parseRelational() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseAdditive() {
-    std::cout << "[DEBUG] :: Additive" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Additive");
     auto left = parseMultiplicative();
     while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        std::string op = previous().text();
+        std::string op(previous().text());
         auto right = parseMultiplicative();
         // Defensive: Only construct BinaryExpr if both left and right are valid
         if (!left || !right) {
             // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
+            LOG_WARN(LogCategory::Parser, "Invalid BinaryExpr (" << op << ") with null child");
             if (left) return left;
             if (right) return right;
             return nullptr;
@@ -982,16 +931,15 @@ std::unique_ptr<ASTNode> Parser::parseAdditive() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseMultiplicative() {
-    std::cout << "[DEBUG] :: Multiplicative" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Multiplicative");
     auto left = parseUnary();
     while (match(TokenType::STAR) || match(TokenType::SLASH) || match(TokenType::PERCENT)) {
-        std::string op = previous().text();
+        std::string op(previous().text());
         auto right = parseUnary();
         // Defensive: Only construct BinaryExpr if both left and right are valid
         if (!left || !right) {
             // parseLogs.push_back("[WARNING] Invalid BinaryExpr (" + op + ") with null child");
-            logFile << "[WARNING] Invalid BinaryExpr (" + op + ") with null child" << std::endl;
-            logFile.flush();
+            LOG_WARN(LogCategory::Parser, "Invalid BinaryExpr (" << op << ") with null child");
             if (left) return left;
             if (right) return right;
             return nullptr;
@@ -1002,9 +950,9 @@ std::unique_ptr<ASTNode> Parser::parseMultiplicative() {
 }
 
 std::unique_ptr<ASTNode> Parser::parseUnary() {
-    std::cout << "[DEBUG] :: Unary" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Unary");
     if (match(TokenType::EXCLAIM) || match(TokenType::MINUS) || match(TokenType::INCREMENT) || match(TokenType::DECREMENT)) {
-        std::string op = previous().text();
+        std::string op(previous().text());
         auto right = parseUnary();
         return std::make_unique<UnaryExpr>(op, std::move(right));
     }
@@ -1012,7 +960,7 @@ std::unique_ptr<ASTNode> Parser::parseUnary() {
 }
 
 std::unique_ptr<ASTNode> Parser::parsePostfix() {
-    std::cout << "[DEBUG] :: Postfix" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Postfix");
     auto expr = parsePrimary();
     while (true) {
         if (check(TokenType::LEFT_PAREN)) {
@@ -1022,13 +970,13 @@ std::unique_ptr<ASTNode> Parser::parsePostfix() {
             expect(TokenType::RIGHT_BRACKET, "Expected ']' after array index");
             expr = std::make_unique<ArrayAccess>(std::move(expr), std::move(index));
         } else if (match(TokenType::DOT) || match(TokenType::ARROW)) {
-            std::string memberOp = previous().text();
+            std::string memberOp(previous().text());
             expect(TokenType::IDENTIFIER, "Expected member name after '.' or '->'");
-            std::string member = previous().text();
-            expr = std::make_unique<MemberAccess>(std::move(expr), member, memberOp == "->");
+            std::string member(previous().text());
+            expr = std::make_unique<MemberAccess>(std::move(expr), member, memberOp == "->", previous().symbol());
         } else if (match(TokenType::SCOPE)) {
             expect(TokenType::IDENTIFIER, "Expected identifier after '::'");
-            std::string name = previous().text();
+            std::string name(previous().text());
             expr = std::make_unique<QualifiedName>(std::move(expr), name);
         } else if (match(TokenType::INCREMENT)) {
             // Postfix increment: j++
@@ -1045,7 +993,7 @@ std::unique_ptr<ASTNode> Parser::parsePostfix() {
 
 
 std::unique_ptr<ASTNode> Parser::parsePrimary() {
-    std::cout << "[DEBUG] :: Primary" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Primary");
     // C++ casts
     if (match(TokenType::STATIC_CAST)) {
         expect(TokenType::LESS, "Expected '<' after static_cast");
@@ -1118,7 +1066,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
             do {
                 auto type = parseType();
                 expect(TokenType::IDENTIFIER, "Expected parameter name");
-                std::string name = previous().text();
+                std::string name(previous().text());
                 params.push_back(std::make_unique<VarDecl>(name, std::move(type)));
             } while (match(TokenType::COMMA));
         }
@@ -1128,17 +1076,14 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
     }
 
     // Literals
-    if (match(TokenType::INTEGER)) {
-        return std::make_unique<Literal>(previous().text(), "int");
-    }
-    if (match(TokenType::FLOAT)) {
-        return std::make_unique<Literal>(previous().text(), "float");
+    if (match(TokenType::INTEGER) || match(TokenType::FLOAT)) {
+        return std::make_unique<Literal>(previous());
     }
     if (match(TokenType::STRING_LITERAL)) {
-        return std::make_unique<Literal>(previous().text(), "string");
+        return std::make_unique<Literal>(std::string(previous().text()), "string");
     }
     if (match(TokenType::CHARACTER)) {
-        return std::make_unique<Literal>(previous().text(), "char");
+        return std::make_unique<Literal>(std::string(previous().text()), "char");
     }
     // --- I/O Streams ---
     if (match(TokenType::COUT)) {
@@ -1163,7 +1108,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
     }
     // Identifier
     if (match(TokenType::IDENTIFIER)) {
-        return std::make_unique<Identifier>(previous().text());
+        return std::make_unique<Identifier>(std::string(previous().text()), previous().symbol());
     }
 
     // Parenthesized expression
@@ -1178,12 +1123,12 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
 
 // --- parseCatchStmt ---
 std::unique_ptr<CatchStmt> Parser::parseCatchStmt() {
-    std::cout << "[DEBUG] :: CatchStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "CatchStmt");
     expect(TokenType::CATCH, "Expected 'catch'");
     expect(TokenType::LEFT_PAREN, "Expected '(' after 'catch'");
     auto exceptionType = parseType();
     expect(TokenType::IDENTIFIER, "Expected exception variable name");
-    std::string name = previous().text();
+    std::string name(previous().text());
     expect(TokenType::RIGHT_PAREN, "Expected ')' after catch parameter");
     auto bodyNode = parseBlock();
     auto body = std::unique_ptr<BlockStmt>(static_cast<BlockStmt*>(bodyNode.release()));
@@ -1192,12 +1137,12 @@ std::unique_ptr<CatchStmt> Parser::parseCatchStmt() {
 
 
 std::unique_ptr<ASTNode> Parser::parseType() {
-    std::cout << "[DEBUG] :: Type" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "Type");
     // Accept all valid type tokens, not just IDENTIFIER
     if (!isTypeToken(current.type())) {
-        throw std::runtime_error("Expected type name (at line " + std::to_string(current.line()) + ", column " + std::to_string(current.column()) + ", token: '" + current.text() + "')");
+        throw std::runtime_error("Expected type name (at line " + std::to_string(current.line()) + ", column " + std::to_string(current.column()) + ", token: '" + std::string(current.text()) + "')");
     }
-    std::string base = current.text();
+    std::string base(current.text());
     advance();
     std::unique_ptr<ASTNode> typeNode = std::make_unique<Identifier>(base);
     // Built-in types: int, float, double, char, bool, void
@@ -1221,7 +1166,7 @@ std::unique_ptr<ASTNode> Parser::parseType() {
     // Handle qualified types: A::B::C
     while (match(TokenType::SCOPE)) {
         expect(TokenType::IDENTIFIER, "Expected identifier after '::' in qualified type");
-        std::string right = previous().text();
+        std::string right(previous().text());
         typeNode = std::make_unique<QualifiedName>(std::move(typeNode), right);
     }
     // Handle template types: vector<int>
@@ -1265,7 +1210,7 @@ std::unique_ptr<ASTNode> Parser::parseType() {
 
 
 std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
-    std::cout << "[DEBUG] :: PreprocessorDirective" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "PreprocessorDirective");
     if (!match(TokenType::HASH)) return nullptr;
 
 
@@ -1274,7 +1219,7 @@ std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
         std::string header;
         if (check(TokenType::STRING)) {
             expect(TokenType::STRING, "Expected header after #include");
-            header = previous().text();
+            header = std::string(previous().text());
         } else if (check(TokenType::LESS)) {
             // Parse <...> as a header
             expect(TokenType::LESS, "Expected '<' after #include");
@@ -1292,33 +1237,33 @@ std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
     }
     if (match(TokenType::PREPROCESSOR_DEFINE)) {
         expect(TokenType::IDENTIFIER, "Expected macro name after #define");
-        std::string macro = previous().text();
+        std::string macro(previous().text());
         std::string value;
         // Optionally parse the macro value (until end of line)
         if (!check(TokenType::NEWLINE) && !isAtEnd()) {
-            value = current.text();
+            value = std::string(current.text());
             advance();
         }
         return std::make_unique<PreprocessorDefine>(macro, value);
     }
     if (match(TokenType::PREPROCESSOR_UNDEF)) {
         expect(TokenType::IDENTIFIER, "Expected macro name after #undef");
-        std::string macro = previous().text();
+        std::string macro(previous().text());
         return std::make_unique<PreprocessorUndef>(macro);
     }
     if (match(TokenType::PREPROCESSOR_IFDEF)) {
         expect(TokenType::IDENTIFIER, "Expected macro name after #ifdef");
-        std::string macro = previous().text();
+        std::string macro(previous().text());
         return std::make_unique<PreprocessorIfdef>(macro);
     }
     if (match(TokenType::PREPROCESSOR_IFNDEF)) {
         expect(TokenType::IDENTIFIER, "Expected macro name after #ifndef");
-        std::string macro = previous().text();
+        std::string macro(previous().text());
         return std::make_unique<PreprocessorIfndef>(macro);
     }
     if (match(TokenType::PREPROCESSOR_IF)) {
         // Optionally parse the condition as a string or expression
-        std::string condition = current.text();
+        std::string condition(current.text());
         advance();
         return std::make_unique<PreprocessorIf>(condition);
     }
@@ -1326,7 +1271,7 @@ std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
         return std::make_unique<PreprocessorElse>();
     }
     if (match(TokenType::PREPROCESSOR_ELIF)) {
-        std::string condition = current.text();
+        std::string condition(current.text());
         advance();
         return std::make_unique<PreprocessorElif>(condition);
     }
@@ -1334,13 +1279,13 @@ std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
         return std::make_unique<PreprocessorEndif>();
     }
     if (match(TokenType::PREPROCESSOR_PRAGMA)) {
-        std::string pragma = current.text();
+        std::string pragma(current.text());
         advance();
         return std::make_unique<PreprocessorPragma>(pragma);
     }
 
     // Unknown or unsupported directive
-    std::string unknown = current.text();
+    std::string unknown(current.text());
     std::ostringstream err;
     err << "Unknown or unsupported preprocessor directive: '" << unknown << "' at token '" << current.text() << "' (line " << current.line() << ", col " << current.column() << ")";
     std::cerr << err.str() << std::endl;
@@ -1350,25 +1295,26 @@ std::unique_ptr<ASTNode> Parser::parsePreprocessorDirective() {
 
 // --- parseEnumDecl ---
 std::unique_ptr<ASTNode> Parser::parseEnumDecl() {
-    std::cout << "[DEBUG] :: EnumDecl" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "EnumDecl");
     expect(TokenType::ENUM, "Expected 'enum'");
     expect(TokenType::IDENTIFIER, "Expected enum name");
-    std::string name = previous().text();
+    std::string name(previous().text());
     expect(TokenType::LEFT_BRACE, "Expected '{' after enum name");
     auto enumNode = std::make_unique<EnumDecl>(name);
     int value = 0;
     while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
         expect(TokenType::IDENTIFIER, "Expected enumerator name");
-        std::string enumerator = previous().text();
+        std::string enumerator(previous().text());
         int enumValue = value;
         if (match(TokenType::EQUAL)) {
             // Parse explicit value
             auto valNode = parseExpression();
-            if (valNode->type == ASTNodeType::LITERAL) {
-                enumValue = std::stoi(static_cast<Literal*>(valNode.get())->value);
-            } else {
+            if (valNode->type != ASTNodeType::LITERAL ||
+                static_cast<const Literal*>(valNode.get())->literalType != "int") {
                 throw std::runtime_error("Enum value must be an integer literal");
             }
+            // Decoded by the lexer, so hex, octal, binary and separators all count
+            enumValue = static_cast<int>(static_cast<const Literal*>(valNode.get())->intValue);
             value = enumValue;
         }
         enumNode->enumerators.emplace_back(enumerator, enumValue);
@@ -1384,10 +1330,10 @@ std::unique_ptr<ASTNode> Parser::parseEnumDecl() {
 
 // --- parseNamespaceDecl ---
 std::unique_ptr<ASTNode> Parser::parseNamespaceDecl() {
-    std::cout << "[DEBUG] :: NamespaceDecl" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "NamespaceDecl");
     expect(TokenType::NAMESPACE, "Expected 'namespace'");
     expect(TokenType::IDENTIFIER, "Expected namespace name");
-    std::string name = previous().text();
+    std::string name(previous().text());
     expect(TokenType::LEFT_BRACE, "Expected '{' after namespace name");
     auto nsNode = std::make_unique<NamespaceDecl>(name);
     while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
@@ -1402,11 +1348,11 @@ std::unique_ptr<ASTNode> Parser::parseNamespaceDecl() {
 
 // --- parseUsingDirective ---
 std::unique_ptr<ASTNode> Parser::parseUsingDirective() {
-    std::cout << "[DEBUG] :: UsingDirective" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "UsingDirective");
     expect(TokenType::USING, "Expected 'using' directive");
     if (match(TokenType::NAMESPACE)) {
         expect(TokenType::IDENTIFIER, "Expected namespace name after 'using namespace'");
-        std::string ns = previous().text();
+        std::string ns(previous().text());
         expect(TokenType::SEMICOLON, "Expected ';' after using directive");
         return std::make_unique<UsingDirective>(ns);
     } else {
@@ -1416,7 +1362,7 @@ std::unique_ptr<ASTNode> Parser::parseUsingDirective() {
 
 // --- parseIfStmt ---
 std::unique_ptr<ASTNode> Parser::parseIfStmt() {
-    std::cout << "[DEBUG] :: IfStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "IfStmt");
     expect(TokenType::IF, "Expected 'if'");
     expect(TokenType::LEFT_PAREN, "Expected '(' after 'if'");
     auto condition = parseExpression();
@@ -1431,7 +1377,7 @@ std::unique_ptr<ASTNode> Parser::parseIfStmt() {
 
 // --- parseWhileStmt ---
 std::unique_ptr<ASTNode> Parser::parseWhileStmt() {
-    std::cout << "[DEBUG] :: WhileStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "WhileStmt");
     expect(TokenType::WHILE, "Expected 'while'");
     expect(TokenType::LEFT_PAREN, "Expected '(' after 'while'");
     auto condition = parseExpression();
@@ -1442,7 +1388,7 @@ std::unique_ptr<ASTNode> Parser::parseWhileStmt() {
 
 // --- parseForStmt ---
 std::unique_ptr<ASTNode> Parser::parseForStmt() {
-    std::cout << "[DEBUG] :: ForStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "ForStmt");
     expect(TokenType::FOR, "Expected 'for'");
     expect(TokenType::LEFT_PAREN, "Expected '(' after 'for'");
     std::unique_ptr<ASTNode> init = nullptr;
@@ -1475,7 +1421,7 @@ std::unique_ptr<ASTNode> Parser::parseForStmt() {
 
 // --- parseReturnStmt ---
 std::unique_ptr<ASTNode> Parser::parseReturnStmt() {
-    std::cout << "[DEBUG] :: ReturnStmt" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "ReturnStmt");
     expect(TokenType::RETURN, "Expected 'return'");
     std::unique_ptr<ASTNode> expr = nullptr;
     if (!check(TokenType::SEMICOLON)) {
@@ -1487,7 +1433,7 @@ std::unique_ptr<ASTNode> Parser::parseReturnStmt() {
 
 // --- parseTemplateDecl ---
 std::unique_ptr<ASTNode> Parser::parseTemplateDecl() {
-    std::cout << "[DEBUG] :: TemplateDecl" << std::endl;
+    LOG_DEBUG(LogCategory::Parser, "TemplateDecl");
     expect(TokenType::TEMPLATE, "Expected 'template'");
     expect(TokenType::LESS, "Expected '<' after 'template'");
     // Parse template parameter list (e.g., typename T, class U)
@@ -1495,18 +1441,18 @@ std::unique_ptr<ASTNode> Parser::parseTemplateDecl() {
     std::vector<std::string> paramNames; // For TemplateDecl fallback
     do {
         if ((check(TokenType::CLASS) || current.text() == "typename") &&
-            tokens[currentIndex + 1]->type() == TokenType::IDENTIFIER) {
+            tokens.type(1) == TokenType::IDENTIFIER) {
             advance(); // skip 'class' or 'typename'
             expect(TokenType::IDENTIFIER, "Expected template parameter name");
-            std::string paramName = previous().text();
+            std::string paramName(previous().text());
             templateParams.push_back(std::make_unique<TemplateParam>(paramName, true));
             paramNames.push_back(paramName);
-        } else if (check(TokenType::IDENTIFIER) && tokens[currentIndex + 1]->type() == TokenType::IDENTIFIER) {
+        } else if (check(TokenType::IDENTIFIER) && tokens.type(1) == TokenType::IDENTIFIER) {
             // Accept: template <T U>
-            std::string typeName = current.text();
+            std::string typeName(current.text());
             advance();
             expect(TokenType::IDENTIFIER, "Expected template parameter name");
-            std::string paramName = previous().text();
+            std::string paramName(previous().text());
             templateParams.push_back(std::make_unique<TemplateParam>(paramName, false, typeName));
             paramNames.push_back(paramName);
         } else {
@@ -3,6 +3,7 @@
 #define PARSER_HPP
 
 #include "lexer.hpp"
+#include "token_stream.hpp"
 #include "ast.hpp"
 #include <memory>
 #include <vector>
@@ -11,9 +12,12 @@
 
 class Parser {
 public:
-    explicit Parser(std::vector<std::unique_ptr<Token>>&& tokens);
-    ~Parser();
+    // Logs go to LogCategory::Parser; see log.hpp
+    explicit Parser(TokenBuffer&& tokens);
+    // Pulls tokens from lexer as parsing proceeds instead of taking them all up front
+    explicit Parser(Lexer& lexer);
     std::unique_ptr<Program> parse();
+    size_t tokensRead() const { return tokens.tokensRead(); }
     // std::unique_ptr<Program> parseProgram();
 
     // --- Log storage ---
@@ -21,11 +25,9 @@ public:
     const std::vector<std::string>& getParseLogs() const { return parseLogs; }
 
 private:
-    std::vector<std::unique_ptr<Token>> tokens; // Store all tokens
-    size_t currentIndex = 0; // Index into tokens
+    TokenStream tokens; // Lookahead window over the input
     Token current;
     Token prev;
-    std::ofstream logFile;
 
     void advance();
     bool match(TokenType type);
@@ -0,0 +1,292 @@
+#include "pipeline.hpp"
+#include "cache.hpp"
+#include "header_cache.hpp"
+#include "log.hpp"
+#include "output_sink.hpp"
+#include "prelude.hpp"
+#include "source_file.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "JavaCodeGenerator.hpp"
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Routes one log category to a file for the duration of a run; closing drains pending lines
+class ScopedLogSink {
+public:
+    ScopedLogSink(LogCategory category, const std::string& path) : category_(category), open_(!path.empty()) {
+        if (open_) Logger::openSink(category_, path);
+    }
+    ~ScopedLogSink() {
+        if (open_) Logger::closeSink(category_);
+    }
+    ScopedLogSink(const ScopedLogSink&) = delete;
+    ScopedLogSink& operator=(const ScopedLogSink&) = delete;
+
+private:
+    LogCategory category_;
+    bool open_;
+};
+
+// Below this size, streaming tokens from the lexer into the parser beats lexing in parallel
+constexpr size_t kParallelLexMinBytes = 4 << 20;
+
+} // unnamed namespace
+
+std::string getBaseName(const std::string& path) {
+    // Find last slash or backslash (Windows or Unix paths)
+    size_t lastSlash = path.find_last_of("/\\");
+    std::string filename = (lastSlash == std::string::npos) ? path : path.substr(lastSlash + 1);
+
+    // Find last dot to remove extension
+    size_t dot = filename.find_last_of('.');
+    if (dot != std::string::npos) {
+        return filename.substr(0, dot);
+    }
+    return filename; // No extension found
+}
+
+std::string readSourceFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open source file '" + path + "'");
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+void transpileFile(const std::string& inputPath, const std::string& javaOutputPath,
+                   const PipelineOptions& options) {
+    TraceSpan span("transpileFile", inputPath);
+    FileStats* stats = options.stats;
+    if (stats) stats->path = inputPath;
+    std::optional<SourceFile> input;
+    {
+        PhaseTimer timer(stats, Phase::Read);
+        input.emplace(inputPath);
+    }
+    std::string_view source = input->text();
+    std::string baseName = getBaseName(inputPath);
+    if (stats) stats->inputBytes = source.size();
+
+    if (options.verbose) {
+        std::cout << "Running transpiler on source file: " << inputPath << "\n\n";
+    }
+
+    // A cache hit skips the whole pipeline. Dumps need the intermediate artifacts, so they
+    // bypass the lookup, but the generated Java is still stored for later runs.
+    ResultCache::Key cacheKey;
+    if (options.cache) {
+        uint64_t headers = options.headers ? options.headers->dependencyHash(source, inputPath) : 0;
+        // A computed #include names a header only lexing can tell: such files are not cached
+        if ((!options.headers || headers) && (!options.prelude || options.prelude->cacheable())) {
+            cacheKey = options.cache->key(source, baseName, headers, options.prelude ? options.prelude->hash() : 0);
+        }
+    }
+    bool cached = !cacheKey.name.empty();
+    bool emitJava = !javaOutputPath.empty();
+    if (cached && emitJava && options.tokenDumpPath.empty() && options.astDumpPath.empty()) {
+        std::string javaCode;
+        if (options.cache->lookup(cacheKey, javaCode)) {
+            if (options.verbose) {
+                std::cout << "Using cached Java code.\n";
+                std::cout << "\n--- Generated Java Code ---\n";
+                std::cout << javaCode << std::endl;
+            }
+            PhaseTimer timer(stats, Phase::Write);
+            writeJavaFile(javaOutputPath, javaCode);
+            if (stats) {
+                stats->cacheHit = true;
+                stats->outputBytes = javaCode.size();
+            }
+            return;
+        }
+    }
+
+    ScopedLogSink lexerLog(LogCategory::Lexer, options.lexerLogPath);
+    ScopedLogSink parserLog(LogCategory::Parser, options.parserLogPath);
+    ScopedLogSink codegenLog(LogCategory::Codegen, options.codegenLogPath);
+
+    // Later stages run only if something downstream of them was requested
+    bool needParse = emitJava || !options.astDumpPath.empty() || !options.parserLogPath.empty() ||
+                 !options.codegenLogPath.empty();
+
+    // Lexing; token texts are views into input, which outlives them here. Only the token
+    // dump and parallel lexing of very large files need the whole stream at once; otherwise
+    // the parser pulls tokens from the lexer as it goes, so lexing time is counted under the
+    // parse phase.
+    Lexer lexer(source);
+    if (options.headers) lexer.enableIncludes(*options.headers, inputPath);
+    if (options.prelude) lexer.restoreState(options.prelude->state());
+    bool parallel = options.lexJobs > 1 && source.size() >= kParallelLexMinBytes;
+    bool streaming = needParse && options.tokenDumpPath.empty() && !parallel;
+    TokenBuffer tokens;
+    if (!streaming) {
+        PhaseTimer timer(stats, Phase::Lex);
+        tokens = parallel ? lexer.tokenizeParallel(options.lexJobs) : lexer.tokenize();
+    }
+    if (stats) stats->tokens = tokens.size();
+
+    if (!options.tokenDumpPath.empty()) {
+        PhaseTimer timer(stats, Phase::TokenDump);
+        std::ofstream lexerOut(options.tokenDumpPath, std::ios::trunc);
+        if (!lexerOut) {
+            throw std::runtime_error("Could not open " + options.tokenDumpPath + " for writing");
+        }
+        for (const auto& token : tokens) {
+            lexerOut << token.toString() << '\n';
+        }
+    }
+    if (!needParse) return;
+
+    // Parsing
+    std::unique_ptr<Program> ast;
+    {
+        PhaseTimer timer(stats, Phase::Parse);
+        std::optional<Parser> parser;
+        if (streaming) {
+            parser.emplace(lexer);
+        } else {
+            parser.emplace(std::move(tokens));
+        }
+        ast = parser->parse();
+        if (stats && streaming) stats->tokens = parser->tokensRead();
+    }
+    if (!ast) {
+        throw std::runtime_error("AST is null. Aborting code generation.");
+    }
+
+    if (!options.astDumpPath.empty()) {
+        if (options.verbose) std::cout << "\n--- AST Output ---\n";
+        PhaseTimer timer(stats, Phase::AstDump);
+        std::ofstream astOut(options.astDumpPath, std::ios::trunc);
+        if (!astOut) {
+            throw std::runtime_error("Could not open " + options.astDumpPath + " for writing");
+        }
+        astOut << ast->toString() << std::endl;
+    }
+    if (!emitJava && options.codegenLogPath.empty()) return;
+
+    // Java Code Generation
+    // The Java streams straight into the output file (and the console when verbose) as each
+    // top-level declaration is generated
+    if (options.verbose) {
+        std::cout << "\n About to generate Java code...\n";
+        std::cout << "\n--- Generated Java Code ---\n";
+    }
+    std::optional<FileSink> fileSink;
+    if (emitJava) fileSink.emplace(javaOutputPath);
+    StdoutSink stdoutSink;
+    MemorySink discard;
+    std::vector<OutputSink*> targets;
+    if (fileSink) targets.push_back(&*fileSink);
+    if (options.verbose) targets.push_back(&stdoutSink);
+    if (targets.empty()) targets.push_back(&discard);   // Only the codegen log was requested
+    TeeSink out(std::move(targets));
+    try {
+        {
+            PhaseTimer timer(stats, Phase::Codegen);
+            JavaCodeGenerator codegen;
+            codegen.generateProgram(ast.get(), baseName, out);
+        }
+        PhaseTimer timer(stats, Phase::Write);
+        out.close();
+    } catch (...) {
+        // Never leave a truncated .java behind
+        fileSink.reset();
+        if (emitJava) std::remove(javaOutputPath.c_str());
+        throw;
+    }
+    if (options.verbose) std::cout << "\nJava code generation complete.\n";
+    if (stats) stats->outputBytes = out.bytesWritten();
+    if (cached && emitJava) options.cache->storeFile(cacheKey, javaOutputPath);
+}
+
+void writeJavaFile(const std::string& path, const std::string& javaCode) {
+    FileSink out(path);
+    out.write(javaCode);
+    out.close();
+}
+
+std::vector<TokenBuffer> splitTopLevelDeclarations(TokenBuffer&& tokens, size_t minChunkTokens) {
+    std::vector<TokenBuffer> chunks;
+    if (tokens.empty()) return chunks;
+
+    // The stream always ends in END_OF_FILE; every chunk gets a copy of it. Chunks share
+    // the token text storage, so copying a Token copies no text. Only the dense type column
+    // is scanned; the tokens are copied in order through an iterator, which follows the line
+    // table without searching it.
+    const Token eof = tokens.back();
+    size_t last = tokens.size() - 1;
+    int braceDepth = 0;
+    int parenDepth = 0;
+    TokenBuffer chunk(tokens.storage());
+    auto token = tokens.begin();
+
+    for (size_t i = 0; i < last; ++i, ++token) {
+        TokenType type = tokens.type(i);
+        switch (type) {
+            case TokenType::LEFT_BRACE: braceDepth++; break;
+            case TokenType::RIGHT_BRACE: braceDepth--; break;
+            case TokenType::LEFT_PAREN:
+            case TokenType::LEFT_BRACKET: parenDepth++; break;
+            case TokenType::RIGHT_PAREN:
+            case TokenType::RIGHT_BRACKET: parenDepth--; break;
+            default: break;
+        }
+        chunk.push_back(*token);
+
+        bool boundary = false;
+        if (braceDepth == 0 && parenDepth == 0) {
+            TokenType next = tokens.type(i + 1);
+            if (type == TokenType::SEMICOLON || next == TokenType::HASH) {
+                boundary = true;
+            } else if (type == TokenType::RIGHT_BRACE) {
+                // "};", "} else" and "} while (...)" still belong to the same declaration
+                boundary = next != TokenType::SEMICOLON && next != TokenType::ELSE &&
+                           next != TokenType::WHILE && next != TokenType::COMMA;
+            }
+        }
+        if (boundary && chunk.size() >= minChunkTokens) {
+            chunk.push_back(eof);
+            chunks.push_back(std::move(chunk));
+            chunk = TokenBuffer(tokens.storage());
+        }
+    }
+    chunk.push_back(eof);
+    chunks.push_back(std::move(chunk));
+    tokens.clear();
+    return chunks;
+}
+
+std::string generateChunk(TokenBuffer&& tokens, const std::string& className,
+                          FileStats* stats) {
+    std::unique_ptr<Program> ast;
+    {
+        PhaseTimer timer(stats, Phase::Parse);
+        Parser parser(std::move(tokens));
+        ast = parser.parse();
+    }
+    if (!ast) {
+        throw std::runtime_error("AST is null. Aborting code generation.");
+    }
+    PhaseTimer timer(stats, Phase::Codegen);
+    JavaCodeGenerator codegen;
+    return codegen.generateGlobals(ast.get(), className);
+}
+
+void writeJavaProgram(OutputSink& out, const std::string& className, const std::vector<std::string>& bodies) {
+    JavaCodeGenerator codegen;
+    out.write(codegen.generateProgramHeader(className));
+    for (const auto& body : bodies) out.write(body);
+    out.write("}\n");
+}
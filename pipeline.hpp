@@ -0,0 +1,59 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "lexer.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+class ResultCache;
+class HeaderCache;
+class Prelude;
+class OutputSink;
+struct FileStats;
+
+// Options for a single Lexer -> Parser -> JavaCodeGenerator run
+struct PipelineOptions {
+    bool verbose = true;          // Print progress and the generated Java to stdout
+    std::string tokenDumpPath;    // Token dump file (empty: skip)
+    std::string astDumpPath;      // AST dump file (empty: skip)
+    std::string parserLogPath;    // Parser log file (empty: no log)
+    std::string codegenLogPath;   // Codegen log file (empty: no log)
+    std::string lexerLogPath;     // Lexer and preprocessor log file (empty: warnings go wherever main sent them)
+    ResultCache* cache = nullptr; // Reuse/store generated Java (lookups skipped when dumps are requested)
+    HeaderCache* headers = nullptr; // Follow #include through this cache (null: includes are not followed)
+    const Prelude* prelude = nullptr; // Preprocessor state the file starts from (null: none)
+    FileStats* stats = nullptr;   // Per-phase timings and counters for --stats (null: not collected)
+    unsigned lexJobs = 1;         // Threads for lexing a very large file (1: stream tokens into the parser)
+};
+
+// File name without directory and extension, used as the Java class name
+std::string getBaseName(const std::string& path);
+
+// Read a whole source file into an owned string (see SourceFile for a zero-copy view);
+// throws std::runtime_error if it cannot be opened
+std::string readSourceFile(const std::string& path);
+
+// Transpile one C++ file and write the Java class to javaOutputPath (empty: no Java output).
+// Stages whose results are neither dumped, logged nor needed for the Java are skipped.
+// Throws std::runtime_error on any I/O or parse failure.
+void transpileFile(const std::string& inputPath, const std::string& javaOutputPath,
+                   const PipelineOptions& options);
+
+// Write generated Java to path; throws std::runtime_error if it cannot be opened
+void writeJavaFile(const std::string& path, const std::string& javaCode);
+
+// --- Splitting one file into independently generated chunks ---
+
+// Split tokens at top-level declaration boundaries into chunks of at least minChunkTokens
+// tokens. Every chunk is terminated by its own END_OF_FILE token.
+std::vector<TokenBuffer> splitTopLevelDeclarations(TokenBuffer&& tokens, size_t minChunkTokens);
+
+// Parse and generate one chunk; returns its indented class-body text
+std::string generateChunk(TokenBuffer&& tokens, const std::string& className,
+                          FileStats* stats = nullptr);
+
+// Write chunk bodies to out as the same text generateProgram would produce for the whole file
+void writeJavaProgram(OutputSink& out, const std::string& className, const std::vector<std::string>& bodies);
+
+#endif // PIPELINE_HPP
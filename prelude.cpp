@@ -0,0 +1,131 @@
+#include "prelude.hpp"
+#include "hash.hpp"
+#include "header_cache.hpp"
+#include "log.hpp"
+#include "serialize.hpp"
+#include "version.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// --- On-disk format ---
+// A magic line, the build ID, the prelude's path and hash, then the macros (name and
+// definition text), the open #if groups and the #pragma once headers (see serialize.hpp)
+
+const char kMagic[] = "transpiler-prelude 2\n";
+
+} // unnamed namespace
+
+Prelude::Prelude(const std::string& path, HeaderCache& headers, const std::string& diskDir) {
+    std::error_code ec;
+    // Resolved like an #include, so the prelude's own #pragma once matches later includes of it
+    path_ = fs::weakly_canonical(path, ec).string();
+    if (ec) path_ = path;
+    std::shared_ptr<const HeaderSource> source = headers.source(path_);
+    if (!source) throw std::runtime_error("Could not open prelude '" + path + "'");
+    hash_ = hashString(path_, hashString("prelude"));
+    hash_ = hashBytes(reinterpret_cast<const char*>(&source->hash), sizeof(source->hash), hash_);
+    uint64_t dependencies = headers.dependencyHash(*source->text, path_);
+    hash_ = hashBytes(reinterpret_cast<const char*>(&dependencies), sizeof(dependencies), hash_);
+    cacheable_ = dependencies != 0;
+
+    std::string file;
+    if (!diskDir.empty() && cacheable_) {
+        fs::create_directories(diskDir, ec);
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash_));
+        file = diskDir + "/" + hex + ".pch";
+        if (load(file)) {
+            fromDisk_ = true;
+            return;
+        }
+    }
+
+    // The prelude's tokens are not needed, only what it leaves behind
+    Lexer lexer(*source->text, source->text);
+    lexer.enableIncludes(headers, path_);
+    lexer.tokenize();
+    state_ = lexer.saveState();
+    LOG_INFO(LogCategory::Lexer, "Prelude " << path_ << " defines " << state_.macros->size() << " macro(s)");
+    if (!file.empty()) store(file);
+}
+
+bool Prelude::load(const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return false;
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string bytes = buffer.str();
+    Reader reader(bytes);
+    std::string_view magic;
+    std::string_view build;
+    std::string_view path;
+    uint64_t hash = 0;
+    uint64_t count = 0;
+    if (!reader.string(magic) || magic != kMagic || !reader.string(build) || build != buildId() ||
+        !reader.string(path) || path != path_ || !reader.number(hash) || hash != hash_ || !reader.number(count)) {
+        return false;
+    }
+    PreprocessorState state;
+    auto macros = std::make_shared<MacroTable>();
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        std::string definition;
+        std::string error;
+        if (!reader.string(name) || !reader.string(definition)) return false;
+        auto macro = parseMacroDefinition(name, definition, error);
+        if (!macro) return false;
+        macros->emplace(macro->symbol, std::move(macro));
+    }
+    if (!reader.number(count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t flags = 0;
+        if (!reader.number(flags)) return false;
+        state.conditionals.push_back({(flags & 1) != 0, (flags & 2) != 0});
+    }
+    if (!reader.number(count)) return false;
+    state.onceFiles.resize(count);
+    for (auto& once : state.onceFiles) {
+        if (!reader.string(once)) return false;
+    }
+    state.macros = std::move(macros);
+    state_ = std::move(state);
+    return true;
+}
+
+void Prelude::store(const std::string& file) const {
+    Writer out;
+    out.string(kMagic);
+    out.string(buildId());
+    out.string(path_);
+    out.number(hash_);
+    out.number(state_.macros->size());
+    for (const auto& [symbol, macro] : *state_.macros) {
+        out.string(macro->name);
+        out.string(definitionText(*macro));
+    }
+    out.number(state_.conditionals.size());
+    for (const auto& conditional : state_.conditionals) {
+        out.number((conditional.active ? 1 : 0) | (conditional.taken ? 2 : 0));
+    }
+    out.number(state_.onceFiles.size());
+    for (const auto& once : state_.onceFiles) out.string(once);
+
+    // Private temp file and rename, as for header cache entries
+    std::ostringstream tmpName;
+    tmpName << file << ".tmp" << std::this_thread::get_id();
+    {
+        std::ofstream stream(tmpName.str(), std::ios::binary | std::ios::trunc);
+        if (!stream || !stream.write(out.bytes().data(), out.bytes().size())) return;
+    }
+    std::error_code ec;
+    fs::rename(tmpName.str(), file, ec);
+    if (ec) fs::remove(tmpName.str(), ec);
+}
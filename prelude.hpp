@@ -0,0 +1,39 @@
+#ifndef PRELUDE_HPP
+#define PRELUDE_HPP
+
+#include <cstdint>
+#include <string>
+#include "lexer.hpp"
+
+class HeaderCache;
+
+// A header processed ahead of every input file (--prelude), like a lightweight precompiled
+// header. It is lexed once, following its #includes, and every file's lexer starts from the
+// preprocessor state it leaves instead of rebuilding it. With a directory, that state is also
+// kept on disk as <dir>/<16 hex>.pch, reused until the prelude, a header it may include or
+// the build changes.
+class Prelude {
+public:
+    // Throws std::runtime_error if path cannot be read
+    Prelude(const std::string& path, HeaderCache& headers, const std::string& diskDir = "");
+
+    const PreprocessorState& state() const { return state_; }
+    // Of the prelude and every header it may include; part of the result cache key
+    uint64_t hash() const { return hash_; }
+    bool fromDisk() const { return fromDisk_; }
+    // False if it, or a header it may include, has a computed #include: its state is then not
+    // kept on disk, and results of files that start from it are not cached
+    bool cacheable() const { return cacheable_; }
+
+private:
+    std::string path_;            // Resolved path
+    PreprocessorState state_;
+    uint64_t hash_ = 0;
+    bool fromDisk_ = false;
+    bool cacheable_ = true;
+
+    bool load(const std::string& file);
+    void store(const std::string& file) const;
+};
+
+#endif // PRELUDE_HPP
@@ -0,0 +1,136 @@
+#include "scheduler.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+
+namespace {
+
+double nowSeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // unnamed namespace
+
+WorkStealingScheduler::WorkStealingScheduler(unsigned workers) {
+    if (workers == 0) workers = 1;
+    for (unsigned i = 0; i < workers; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    stats_.resize(workers);
+}
+
+void WorkStealingScheduler::submit(std::vector<SchedulerTask> tasks) {
+    // Largest first, dealt round-robin so every worker starts on one of the biggest jobs
+    std::stable_sort(tasks.begin(), tasks.end(),
+                     [](const SchedulerTask& a, const SchedulerTask& b) { return a.cost > b.cost; });
+    pending_ += tasks.size();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        WorkerQueue& q = *queues_[i % queues_.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.queuedCost += tasks[i].cost;
+        q.tasks.push_back(std::move(tasks[i]));
+    }
+}
+
+void WorkStealingScheduler::spawn(unsigned worker, SchedulerTask task) {
+    WorkerQueue& q = *queues_[worker];
+    ++pending_;
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.queuedCost += task.cost;
+    q.tasks.push_front(std::move(task));
+}
+
+bool WorkStealingScheduler::popLocal(unsigned worker, SchedulerTask& task) {
+    WorkerQueue& q = *queues_[worker];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.front());
+    q.tasks.pop_front();
+    q.queuedCost -= task.cost;
+    return true;
+}
+
+bool WorkStealingScheduler::steal(unsigned thief, SchedulerTask& task) {
+    // Pick the victim with the most queued work; fall back to any non-empty queue
+    unsigned victim = thief;
+    uint64_t best = 0;
+    for (unsigned i = 0; i < queues_.size(); ++i) {
+        if (i == thief) continue;
+        uint64_t cost = queues_[i]->queuedCost.load(std::memory_order_relaxed);
+        if (cost > best) { best = cost; victim = i; }
+    }
+    for (unsigned attempt = 0; attempt < queues_.size(); ++attempt) {
+        unsigned i = (victim + attempt) % queues_.size();
+        if (i == thief) continue;
+        WorkerQueue& q = *queues_[i];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        q.queuedCost -= task.cost;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingScheduler::workerLoop(unsigned worker, double startSeconds) {
+    WorkerStats& st = stats_[worker];
+    unsigned idleSpins = 0;
+    if (Trace::enabled()) Trace::nameThread("worker " + std::to_string(worker));
+    while (pending_.load() > 0) {
+        SchedulerTask task;
+        bool stolen = false;
+        if (!popLocal(worker, task)) {
+            if (!steal(worker, task)) {
+                // Nothing queued anywhere, but a running task may still spawn subtasks
+                if (++idleSpins < 64) std::this_thread::yield();
+                else std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            stolen = true;
+        }
+        idleSpins = 0;
+        double begin = nowSeconds();
+        {
+            // Stolen tasks get their own span so steals stand out in the timeline
+            TraceSpan span(stolen ? "stolen task" : "task");
+            task.run(worker);
+        }
+        double end = nowSeconds();
+        st.tasksRun++;
+        if (stolen) st.tasksStolen++;
+        st.costProcessed += task.cost;
+        st.busySeconds += end - begin;
+        st.lastFinishSeconds = end - startSeconds;
+        // Decrement only after run() so subtasks spawned by this task are already counted
+        pending_--;
+    }
+}
+
+void WorkStealingScheduler::run() {
+    std::fill(stats_.begin(), stats_.end(), WorkerStats{});
+    double start = nowSeconds();
+    std::vector<std::thread> threads;
+    threads.reserve(queues_.size());
+    for (unsigned w = 0; w < queues_.size(); ++w) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this, w, start);
+    }
+    for (auto& t : threads) t.join();
+    wallSeconds_ = nowSeconds() - start;
+}
+
+void WorkStealingScheduler::printUtilisation(std::ostream& out) const {
+    out << "Worker utilisation (wall " << std::fixed << std::setprecision(3) << wallSeconds_ << "s):\n";
+    for (size_t w = 0; w < stats_.size(); ++w) {
+        const WorkerStats& st = stats_[w];
+        double util = wallSeconds_ > 0 ? 100.0 * st.busySeconds / wallSeconds_ : 0.0;
+        out << "  worker " << w << ": " << st.tasksRun << " tasks (" << st.tasksStolen << " stolen), "
+            << "cost " << st.costProcessed << ", busy " << st.busySeconds << "s ("
+            << std::setprecision(1) << util << "%), last finish at "
+            << std::setprecision(3) << st.lastFinishSeconds << "s\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,67 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// A unit of work; cost is an estimate (input bytes) used for largest-first ordering
+struct SchedulerTask {
+    uint64_t cost = 0;
+    std::function<void(unsigned worker)> run;
+};
+
+// Per-worker counters, valid after run() returns
+struct WorkerStats {
+    uint64_t tasksRun = 0;
+    uint64_t tasksStolen = 0;
+    uint64_t costProcessed = 0;       // Sum of task costs; a split file's subtasks each carry a share of its size
+    double busySeconds = 0.0;
+    double lastFinishSeconds = 0.0;   // Time since run() started when this worker finished its last task
+};
+
+// Work-stealing scheduler with one deque per worker.
+// Seeded tasks are dealt largest-first; a worker pops the front of its own deque and, when
+// empty, steals the front of the victim with the most queued cost, so the biggest
+// outstanding work is always started first. Running tasks may spawn() subtasks, which go to
+// the front of the spawning worker's deque and are immediately stealable.
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(unsigned workers);
+
+    // Queue initial tasks (before run())
+    void submit(std::vector<SchedulerTask> tasks);
+    // Queue a subtask from inside a running task
+    void spawn(unsigned worker, SchedulerTask task);
+    // Run until every submitted and spawned task has completed
+    void run();
+
+    unsigned workerCount() const { return static_cast<unsigned>(queues_.size()); }
+    const std::vector<WorkerStats>& stats() const { return stats_; }
+    double wallSeconds() const { return wallSeconds_; }
+    // Per-worker utilisation table for the last run()
+    void printUtilisation(std::ostream& out) const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<SchedulerTask> tasks;
+        std::atomic<uint64_t> queuedCost{0};
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<WorkerStats> stats_;
+    std::atomic<uint64_t> pending_{0};
+    double wallSeconds_ = 0.0;
+
+    bool popLocal(unsigned worker, SchedulerTask& task);
+    bool steal(unsigned thief, SchedulerTask& task);
+    void workerLoop(unsigned worker, double startSeconds);
+};
+
+#endif // SCHEDULER_HPP
@@ -0,0 +1,58 @@
+#ifndef SERIALIZE_HPP
+#define SERIALIZE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Encoding of the on-disk caches (headers, prelude states). Numbers are little-endian u64s
+// and strings are a length followed by the bytes, so token texts may hold any byte.
+
+class Writer {
+public:
+    void number(uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = static_cast<char>(value >> (8 * i));
+        out_.append(bytes, 8);
+    }
+    void string(std::string_view text) {
+        number(text.size());
+        out_.append(text.data(), text.size());
+    }
+    const std::string& bytes() const { return out_; }
+
+private:
+    std::string out_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view in) : in_(in) {}
+
+    bool number(uint64_t& value) {
+        if (in_.size() - pos_ < 8) return false;
+        value = 0;
+        for (int i = 7; i >= 0; --i) value = value << 8 | static_cast<unsigned char>(in_[pos_ + i]);
+        pos_ += 8;
+        return true;
+    }
+    bool string(std::string_view& text) {
+        uint64_t size = 0;
+        if (!number(size) || in_.size() - pos_ < size) return false;
+        text = in_.substr(pos_, size);
+        pos_ += size;
+        return true;
+    }
+    bool string(std::string& text) {
+        std::string_view view;
+        if (!string(view)) return false;
+        text = std::string(view);
+        return true;
+    }
+
+private:
+    std::string_view in_;
+    size_t pos_ = 0;
+};
+
+#endif // SERIALIZE_HPP
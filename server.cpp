@@ -0,0 +1,332 @@
+#include "server.hpp"
+#include "hash.hpp"
+#include "header_cache.hpp"
+#include "log.hpp"
+#include "pipeline.hpp"
+#include "prelude.hpp"
+#include "parser.hpp"
+#include "JavaCodeGenerator.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// --- Framing: "<length>\n<payload>" ---
+
+// Larger frames are refused before their payload is allocated
+constexpr size_t kMaxFrameBytes = size_t(64) << 20;
+
+bool readExact(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::read(fd, data, size);
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeExact(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Returns false on end of input; throws on a malformed or too large length line
+bool readFrame(int fd, std::string& payload) {
+    std::string lengthLine;
+    char c;
+    while (true) {
+        if (::read(fd, &c, 1) != 1) {
+            if (lengthLine.empty()) return false;
+            throw std::runtime_error("Unexpected end of input in frame header");
+        }
+        if (c == '\n') break;
+        if (c == '\r') continue;
+        if (c < '0' || c > '9' || lengthLine.size() > 18) {
+            throw std::runtime_error("Malformed frame length");
+        }
+        lengthLine += c;
+    }
+    if (lengthLine.empty()) throw std::runtime_error("Malformed frame length");
+    unsigned long long length = std::stoull(lengthLine);
+    if (length > kMaxFrameBytes) {
+        throw std::runtime_error("Frame of " + lengthLine + " bytes exceeds the limit of " +
+                                 std::to_string(kMaxFrameBytes) + " bytes");
+    }
+    payload.resize(length);
+    if (!readExact(fd, &payload[0], payload.size())) {
+        throw std::runtime_error("Unexpected end of input in frame payload");
+    }
+    return true;
+}
+
+bool writeFrame(int fd, const std::string& payload) {
+    std::string header = std::to_string(payload.size()) + "\n";
+    return writeExact(fd, header.data(), header.size()) && writeExact(fd, payload.data(), payload.size());
+}
+
+// --- Request / response ---
+
+struct Request {
+    std::unordered_map<std::string, std::string> headers;
+    std::string source;
+};
+
+Request parseRequest(const std::string& payload) {
+    Request request;
+    size_t pos = 0;
+    while (pos < payload.size()) {
+        size_t end = payload.find('\n', pos);
+        if (end == std::string::npos) end = payload.size();
+        std::string line = payload.substr(pos, end - pos);
+        pos = end + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) break;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            throw std::runtime_error("Malformed request header '" + line + "'");
+        }
+        size_t value = line.find_first_not_of(' ', colon + 1);
+        request.headers[line.substr(0, colon)] = value == std::string::npos ? "" : line.substr(value);
+    }
+    if (pos < payload.size()) request.source = payload.substr(pos);
+    return request;
+}
+
+std::string header(const Request& request, const std::string& key) {
+    auto it = request.headers.find(key);
+    return it == request.headers.end() ? "" : it->second;
+}
+
+// --- Warm state: LRU of recent sources keyed by content, path and the headers and prelude ---
+
+struct CachedUnit {
+    std::shared_ptr<const std::string> source;  // Kept to rule out hash collisions; tokens view into it
+    std::string path;                   // Quoted #include names resolve next to it
+    uint64_t context = 0;               // Hash of the headers it may include and of the prelude
+    TokenBuffer tokens;
+    std::unique_ptr<Program> ast;
+    std::string className;              // Class name the cached Java was generated for
+    std::string java;
+    std::vector<std::string> diagnostics;   // Lexer and preprocessor warnings, repeated on every hit
+};
+
+class UnitLru {
+public:
+    explicit UnitLru(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    CachedUnit* find(uint64_t key, const std::string& source, const std::string& path, uint64_t context) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return nullptr;
+        const CachedUnit& unit = it->second->second;
+        if (*unit.source != source || unit.path != path || unit.context != context) return nullptr;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &entries_.front().second;
+    }
+
+    CachedUnit& insert(uint64_t key, CachedUnit unit) {
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+        entries_.emplace_front(key, std::move(unit));
+        index_[key] = entries_.begin();
+        while (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        return entries_.front().second;
+    }
+
+private:
+    size_t capacity_;
+    std::list<std::pair<uint64_t, CachedUnit>> entries_;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, CachedUnit>>::iterator> index_;
+};
+
+CachedUnit buildUnit(const ServeOptions& options, const std::string& source, const std::string& path,
+                     uint64_t context) {
+    CachedUnit unit;
+    unit.source = std::make_shared<const std::string>(source);
+    unit.path = path;
+    unit.context = context;
+    Logger::Capture warnings(LogCategory::Lexer);
+    Lexer lexer(*unit.source, unit.source);
+    if (options.headers) lexer.enableIncludes(*options.headers, path);
+    if (options.prelude) lexer.restoreState(options.prelude->state());
+    unit.tokens = lexer.tokenize();
+    unit.diagnostics = warnings.messages();
+    Parser parser(TokenBuffer(unit.tokens));   // Copies the Token values; the text is shared
+    unit.ast = parser.parse();
+    if (!unit.ast) {
+        throw std::runtime_error("AST is null. Aborting code generation.");
+    }
+    return unit;
+}
+
+std::string handleRequest(const ServeOptions& options, UnitLru& cache, const Request& request) {
+    std::ostringstream head;
+    std::string body;
+    try {
+        std::string path = header(request, "path");
+        std::string source = request.source;
+        if (source.empty() && !path.empty()) source = readSourceFile(path);
+
+        std::string className = header(request, "class");
+        if (className.empty()) className = path.empty() ? "Main" : getBaseName(path);
+        std::string emit = header(request, "emit");
+        if (emit.empty()) emit = "java";
+        if (emit != "java" && emit != "tokens" && emit != "ast") {
+            throw std::runtime_error("Unknown emit kind '" + emit + "'");
+        }
+
+        // Headers are read again for every request, so an edited one changes the key. A
+        // computed #include names a header only lexing can tell: such sources are not kept.
+        uint64_t context = 0;
+        bool keep = !options.prelude || options.prelude->cacheable();
+        if (options.headers) {
+            options.headers->forgetSources();
+            context = options.headers->dependencyHash(source, path);
+            keep = keep && context != 0;
+        }
+        if (options.prelude) {
+            uint64_t prelude = options.prelude->hash();
+            context = hashBytes(reinterpret_cast<const char*>(&prelude), sizeof(prelude), context);
+        }
+        uint64_t key = hashString(path, hashString(source));
+        key = hashBytes(reinterpret_cast<const char*>(&context), sizeof(context), key);
+        CachedUnit* unit = keep ? cache.find(key, source, path, context) : nullptr;
+        bool hit = unit != nullptr;
+        CachedUnit uncached;
+        if (!hit && keep) unit = &cache.insert(key, buildUnit(options, source, path, context));
+        if (!hit && !keep) {
+            uncached = buildUnit(options, source, path, context);
+            unit = &uncached;
+        }
+
+        if (emit == "tokens") {
+            for (const auto& token : unit->tokens) body += token.toString() + "\n";
+        } else if (emit == "ast") {
+            body = unit->ast->toString() + "\n";
+        } else {
+            if (unit->java.empty() || unit->className != className) {
+                JavaCodeGenerator codegen;
+                unit->java = codegen.generateProgram(unit->ast.get(), className);
+                unit->className = className;
+            }
+            body = unit->java;
+        }
+        head << "status: ok\ncache: " << (hit ? "hit" : "miss") << "\n";
+        for (const auto& diagnostic : unit->diagnostics) head << "diagnostic: " << diagnostic << "\n";
+    } catch (const std::exception& ex) {
+        head.str("");
+        head << "status: error\ncache: miss\ndiagnostic: " << ex.what() << "\n";
+        body.clear();
+    }
+    head << "\n";
+    return head.str() + body;
+}
+
+// Serve frames on one input/output pair; returns false once a shutdown was requested
+bool serveStream(const ServeOptions& options, UnitLru& cache, int in, int out) {
+    std::string payload;
+    while (true) {
+        try {
+            if (!readFrame(in, payload)) return true;
+        } catch (const std::exception& ex) {
+            writeFrame(out, std::string("status: error\ncache: miss\ndiagnostic: ") + ex.what() + "\n\n");
+            return true;
+        }
+        std::string response;
+        bool shutdown = false;
+        try {
+            Request request = parseRequest(payload);
+            if (header(request, "command") == "shutdown") {
+                shutdown = true;
+                response = "status: ok\ncache: miss\n\n";
+            } else {
+                response = handleRequest(options, cache, request);
+            }
+        } catch (const std::exception& ex) {
+            response = std::string("status: error\ncache: miss\ndiagnostic: ") + ex.what() + "\n\n";
+        }
+        if (!writeFrame(out, response)) return true;
+        if (shutdown) return false;
+    }
+}
+
+int serveSocket(const ServeOptions& options, UnitLru& cache) {
+    const std::string& socketPath = options.socketPath;
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error("Could not create socket: " + std::string(std::strerror(errno)));
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        ::close(listener);
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    ::unlink(socketPath.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listener, 8) < 0) {
+        std::string err = std::strerror(errno);
+        ::close(listener);
+        throw std::runtime_error("Could not listen on " + socketPath + ": " + err);
+    }
+    std::cerr << "[Server] Listening on " << socketPath << std::endl;
+
+    bool running = true;
+    while (running) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        running = serveStream(options, cache, client, client);
+        ::close(client);
+    }
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    return 0;
+}
+
+} // unnamed namespace
+
+int runServer(const ServeOptions& options) {
+    // A client hanging up mid-response must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+    // Debug output from the pipeline goes to stderr so it never corrupts the protocol stream
+    std::streambuf* coutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    UnitLru cache(options.cacheEntries);
+    int result = 0;
+    try {
+        if (options.socketPath.empty()) {
+            serveStream(options, cache, STDIN_FILENO, STDOUT_FILENO);
+        } else {
+            result = serveSocket(options, cache);
+        }
+    } catch (...) {
+        std::cout.rdbuf(coutBuffer);
+        throw;
+    }
+    std::cout.rdbuf(coutBuffer);
+    return result;
+}
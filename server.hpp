@@ -0,0 +1,39 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <cstddef>
+#include <string>
+
+class HeaderCache;
+class Prelude;
+
+// Options for --serve mode
+struct ServeOptions {
+    std::string socketPath;      // Unix socket to listen on (empty: length-prefixed stdin/stdout)
+    size_t cacheEntries = 64;    // Sources kept in the in-memory LRU
+    HeaderCache* headers = nullptr; // Follow #include through this cache (null: includes are not followed)
+    const Prelude* prelude = nullptr; // Preprocessor state every source starts from (null: none)
+};
+
+// Keep one process alive and answer transpile requests until shutdown or end of input.
+//
+// Every message is a frame: "<payload length in bytes>\n<payload>". A request frame over
+// 64 MiB gets an error response and ends the connection (stdin/stdout: the server); larger
+// sources can be sent by path.
+// A request payload is "key: value" header lines, a blank line, then optional C++ source:
+//   path: <file>        read the source from this file when the body is empty; quoted
+//                       #include names are also looked for next to it
+//   class: <name>       Java class name (default: base name of path, else "Main")
+//   emit: java|tokens|ast  artifact to return (default: java)
+//   command: shutdown   stop the server
+// A response payload has the headers "status: ok|error", "cache: hit|miss" and one
+// "diagnostic: ..." line per problem, a blank line, then the requested artifact.
+// Nothing is written to disk.
+//
+// Identifiers are interned process-wide and never freed, since the prelude, the header cache
+// and the LRU all hold Symbols; memory grows with the distinct identifiers seen over the
+// server's life. The interner stops at 16M of them: after that, a request that brings a new
+// one gets an error response and the server keeps answering the others.
+int runServer(const ServeOptions& options);
+
+#endif // SERVER_HPP
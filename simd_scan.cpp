@@ -0,0 +1,344 @@
+#include "simd_scan.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86 1
+#endif
+
+namespace {
+
+// --- Scalar kernels: the portable fallback, and the tail of every vector loop ---
+
+inline bool isWhitespace(unsigned char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+inline bool isIdentifierByte(unsigned char c) {
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26 || static_cast<unsigned char>(c - '0') < 10 ||
+           c == '_' || c == '$' || c >= 0x80;
+}
+
+const char* whitespaceScalar(const char* p, const char* end) {
+    while (p < end && isWhitespace(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+const char* identifierScalar(const char* p, const char* end) {
+    while (p < end && isIdentifierByte(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+const char* lineEndScalar(const char* p, const char* end) {
+    const void* nl = p < end ? std::memchr(p, '\n', end - p) : nullptr;
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+size_t lineEndCountScalar(const char* p, const char* end) {
+    size_t count = 0;
+    while ((p = lineEndScalar(p, end)) < end) {
+        ++count;
+        ++p;
+    }
+    return count;
+}
+
+const char* blockCommentEndScalar(const char* p, const char* end) {
+    for (; p + 1 < end; ++p) {
+        if (p[0] == '*' && p[1] == '/') return p;
+    }
+    return end;
+}
+
+const char* literalScalar(const char* p, const char* end, char quote) {
+    while (p < end && *p != quote && *p != '\\' && *p != '\n') ++p;
+    return p;
+}
+
+const char* inactiveScalar(const char* p, const char* end) {
+    while (p < end && *p != '#' && *p != '/' && *p != '"' && *p != '\'') ++p;
+    return p;
+}
+
+#ifdef SIMD_SCAN_X86
+
+// --- SSE4.2: 16 bytes per step, string-compare instructions for set membership ---
+
+constexpr int kAnyOf = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT;
+constexpr int kNoneOf = kAnyOf | _SIDD_NEGATIVE_POLARITY;
+constexpr int kOutsideRanges = _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+
+__attribute__((target("sse4.2")))
+const char* whitespaceSse42(const char* p, const char* end) {
+    const __m128i set = _mm_setr_epi8(' ', '\t', '\n', '\v', '\f', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int index = _mm_cmpestri(set, 6, block, 16, kNoneOf);
+        if (index < 16) return p + index;
+    }
+    return whitespaceScalar(p, end);
+}
+
+__attribute__((target("sse4.2")))
+const char* identifierSse42(const char* p, const char* end) {
+    const __m128i ranges = _mm_setr_epi8('a', 'z', 'A', 'Z', '0', '9', '_', '_', '$', '$',
+                                         static_cast<char>(0x80), static_cast<char>(0xff), 0, 0, 0, 0);
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int index = _mm_cmpestri(ranges, 12, block, 16, kOutsideRanges);
+        if (index < 16) return p + index;
+    }
+    return identifierScalar(p, end);
+}
+
+__attribute__((target("sse4.2")))
+const char* lineEndSse42(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return lineEndScalar(p, end);
+}
+
+__attribute__((target("sse4.2,popcnt")))
+size_t lineEndCountSse42(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+    }
+    return count + lineEndCountScalar(p, end);
+}
+
+__attribute__((target("sse4.2")))
+const char* blockCommentEndSse42(const char* p, const char* end) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+    // Each step also reads the byte after the block, to pair a '*' with the following '/'
+    for (; end - p >= 17; p += 16) {
+        __m128i stars = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), star);
+        __m128i slashes = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)), slash);
+        int mask = _mm_movemask_epi8(_mm_and_si128(stars, slashes));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return blockCommentEndScalar(p, end);
+}
+
+__attribute__((target("sse4.2")))
+const char* literalSse42(const char* p, const char* end, char quote) {
+    const __m128i set = _mm_setr_epi8(quote, '\\', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int index = _mm_cmpestri(set, 3, block, 16, kAnyOf);
+        if (index < 16) return p + index;
+    }
+    return literalScalar(p, end, quote);
+}
+
+__attribute__((target("sse4.2")))
+const char* inactiveSse42(const char* p, const char* end) {
+    const __m128i set = _mm_setr_epi8('#', '/', '"', '\'', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int index = _mm_cmpestri(set, 4, block, 16, kAnyOf);
+        if (index < 16) return p + index;
+    }
+    return inactiveScalar(p, end);
+}
+
+// --- AVX2: 32 bytes per step, membership from byte compares and movemask ---
+
+__attribute__((target("avx2")))
+inline unsigned matchMask(__m256i matches) {
+    return static_cast<unsigned>(_mm256_movemask_epi8(matches));
+}
+
+__attribute__((target("avx2")))
+const char* whitespaceAvx2(const char* p, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i controlSpan = _mm256_set1_epi8('\r' - '\t');
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        // '\t'..'\r' are contiguous: c - '\t' <= 4 unsigned, tested as min(x, 4) == x
+        __m256i offset = _mm256_sub_epi8(block, tab);
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, controlSpan), offset);
+        __m256i whitespace = _mm256_or_si256(control, _mm256_cmpeq_epi8(block, space));
+        unsigned mask = ~matchMask(whitespace);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return whitespaceScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* identifierAvx2(const char* p, const char* end) {
+    // Range tests use signed compares: shifting a range to start at -128 turns
+    // "lo <= c <= hi" into one "c' < -128 + width"
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i letterShift = _mm256_set1_epi8(static_cast<char>(-128 - 'a'));
+    const __m256i letterLimit = _mm256_set1_epi8(-128 + 26);
+    const __m256i digitShift = _mm256_set1_epi8(static_cast<char>(-128 - '0'));
+    const __m256i digitLimit = _mm256_set1_epi8(-128 + 10);
+    const __m256i underscore = _mm256_set1_epi8('_');
+    const __m256i dollar = _mm256_set1_epi8('$');
+    const __m256i zero = _mm256_setzero_si256();
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i letters = _mm256_cmpgt_epi8(letterLimit, _mm256_add_epi8(_mm256_or_si256(block, caseBit), letterShift));
+        __m256i digits = _mm256_cmpgt_epi8(digitLimit, _mm256_add_epi8(block, digitShift));
+        __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(block, underscore), _mm256_cmpeq_epi8(block, dollar));
+        __m256i high = _mm256_cmpgt_epi8(zero, block);   // bytes >= 0x80
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(letters, digits), _mm256_or_si256(other, high));
+        unsigned mask = ~matchMask(ident);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return identifierScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* lineEndAvx2(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = matchMask(_mm256_cmpeq_epi8(block, newline));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return lineEndScalar(p, end);
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t lineEndCountAvx2(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        count += __builtin_popcount(matchMask(_mm256_cmpeq_epi8(block, newline)));
+    }
+    return count + lineEndCountScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* blockCommentEndAvx2(const char* p, const char* end) {
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+    for (; end - p >= 33; p += 32) {
+        __m256i stars = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), star);
+        __m256i slashes = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)), slash);
+        unsigned mask = matchMask(_mm256_and_si256(stars, slashes));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return blockCommentEndScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* literalAvx2(const char* p, const char* end, char quote) {
+    const __m256i quotes = _mm256_set1_epi8(quote);
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i stops = _mm256_or_si256(_mm256_cmpeq_epi8(block, quotes),
+                                         _mm256_or_si256(_mm256_cmpeq_epi8(block, backslash),
+                                                         _mm256_cmpeq_epi8(block, newline)));
+        unsigned mask = matchMask(stops);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return literalScalar(p, end, quote);
+}
+
+__attribute__((target("avx2")))
+const char* inactiveAvx2(const char* p, const char* end) {
+    const __m256i hash = _mm256_set1_epi8('#');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i doubleQuote = _mm256_set1_epi8('"');
+    const __m256i singleQuote = _mm256_set1_epi8('\'');
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i stops = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, hash), _mm256_cmpeq_epi8(block, slash)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(block, doubleQuote),
+                                                        _mm256_cmpeq_epi8(block, singleQuote)));
+        unsigned mask = matchMask(stops);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return inactiveScalar(p, end);
+}
+
+#endif // SIMD_SCAN_X86
+
+// --- Dispatch ---
+
+struct ScanKernels {
+    const char* name;
+    const char* (*whitespace)(const char*, const char*);
+    const char* (*identifier)(const char*, const char*);
+    const char* (*lineEnd)(const char*, const char*);
+    size_t (*lineEndCount)(const char*, const char*);
+    const char* (*blockCommentEnd)(const char*, const char*);
+    const char* (*literal)(const char*, const char*, char);
+    const char* (*inactive)(const char*, const char*);
+};
+
+const ScanKernels kScalarKernels = {"scalar", whitespaceScalar, identifierScalar, lineEndScalar,
+                                    lineEndCountScalar, blockCommentEndScalar, literalScalar, inactiveScalar};
+#ifdef SIMD_SCAN_X86
+const ScanKernels kSse42Kernels = {"sse4.2", whitespaceSse42, identifierSse42, lineEndSse42,
+                                   lineEndCountSse42, blockCommentEndSse42, literalSse42, inactiveSse42};
+const ScanKernels kAvx2Kernels = {"avx2", whitespaceAvx2, identifierAvx2, lineEndAvx2,
+                                  lineEndCountAvx2, blockCommentEndAvx2, literalAvx2, inactiveAvx2};
+#endif
+
+const ScanKernels* selectKernels() {
+    const char* forced = std::getenv("TRANSPILER_SIMD");
+    std::string_view choice = forced ? forced : "";
+    if (choice == "scalar") return &kScalarKernels;
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (avx2 && choice != "sse4.2") return &kAvx2Kernels;
+    if (sse42) return &kSse42Kernels;
+#endif
+    return &kScalarKernels;
+}
+
+// Chosen during static initialization; nothing lexes before main()
+const ScanKernels* const kKernels = selectKernels();
+
+} // unnamed namespace
+
+const char* scanWhitespace(const char* p, const char* end) {
+    return kKernels->whitespace(p, end);
+}
+
+const char* scanIdentifier(const char* p, const char* end) {
+    return kKernels->identifier(p, end);
+}
+
+const char* scanLineEnd(const char* p, const char* end) {
+    return kKernels->lineEnd(p, end);
+}
+
+size_t countLineEnds(const char* p, const char* end) {
+    return kKernels->lineEndCount(p, end);
+}
+
+const char* scanBlockCommentEnd(const char* p, const char* end) {
+    return kKernels->blockCommentEnd(p, end);
+}
+
+const char* scanLiteral(const char* p, const char* end, char quote) {
+    return kKernels->literal(p, end, quote);
+}
+
+const char* scanInactive(const char* p, const char* end) {
+    return kKernels->inactive(p, end);
+}
+
+const char* scanKernelName() {
+    return kKernels->name;
+}
@@ -0,0 +1,38 @@
+#ifndef SIMD_SCAN_HPP
+#define SIMD_SCAN_HPP
+
+#include <cstddef>
+
+// Byte-run scanners for the lexer's hot loops. Each returns the first position in [p, end)
+// that ends the run, or end. AVX2 (32 bytes per step), SSE4.2 (16 bytes per step) and
+// scalar implementations exist; the best one the CPU supports is picked once at startup.
+// Set TRANSPILER_SIMD=avx2|sse4.2|scalar to force one (unsupported choices fall back).
+//
+// None of them reads outside [p, end): full vector blocks are only loaded while they fit,
+// and the tail is finished byte by byte.
+
+// Spaces, tabs, '\r', '\v', '\f' and newlines
+const char* scanWhitespace(const char* p, const char* end);
+
+// Identifier bytes: letters, digits, '_', '$' and bytes >= 0x80
+const char* scanIdentifier(const char* p, const char* end);
+
+// First '\n'
+const char* scanLineEnd(const char* p, const char* end);
+
+// Number of '\n' in [p, end) (not a run scanner: always looks at the whole range)
+size_t countLineEnds(const char* p, const char* end);
+
+// First "*/" (returns the position of the '*')
+const char* scanBlockCommentEnd(const char* p, const char* end);
+
+// First quote, backslash or '\n' inside a string (quote '"') or character (quote '\'') literal
+const char* scanLiteral(const char* p, const char* end, char quote);
+
+// First '#', '/', '"' or '\'': in a disabled #if region, where a directive, comment or literal may start
+const char* scanInactive(const char* p, const char* end);
+
+// "avx2", "sse4.2" or "scalar"
+const char* scanKernelName();
+
+#endif // SIMD_SCAN_HPP
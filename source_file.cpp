@@ -0,0 +1,50 @@
+#include "source_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::SourceFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open source file '" + path + "'");
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        mappingSize_ = static_cast<size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            // The lexer walks the file front to back exactly once
+            ::madvise(mapping, mappingSize_, MADV_SEQUENTIAL);
+            mapping_ = mapping;
+            text_ = std::string_view(static_cast<const char*>(mapping_), mappingSize_);
+            ::close(fd);
+            return;
+        }
+        mappingSize_ = 0;
+    }
+
+    // Buffered fallback: pipes, empty files, or filesystems that refuse mmap
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::string err = std::strerror(errno);
+            ::close(fd);
+            throw std::runtime_error("Could not read source file '" + path + "': " + err);
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    text_ = buffer_;
+}
+
+SourceFile::~SourceFile() {
+    if (mapping_) ::munmap(mapping_, mappingSize_);
+}
@@ -0,0 +1,31 @@
+#ifndef SOURCE_FILE_HPP
+#define SOURCE_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of an input file.
+// Regular files are mmap'd, so the bytes are never copied and lexing can start as soon as the
+// file is open. Pipes, character devices and anything mmap refuses fall back to one buffered
+// read into an owned string. The view stays valid for the lifetime of the SourceFile.
+class SourceFile {
+public:
+    // Throws std::runtime_error if the file cannot be opened or read
+    explicit SourceFile(const std::string& path);
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    std::string_view text() const { return text_; }
+    bool isMapped() const { return mapping_ != nullptr; }
+
+private:
+    void* mapping_ = nullptr;     // mmap'd region (null when buffered)
+    size_t mappingSize_ = 0;
+    std::string buffer_;          // Fallback storage for non-mappable inputs
+    std::string_view text_;
+};
+
+#endif // SOURCE_FILE_HPP
@@ -0,0 +1,210 @@
+#include "stats.hpp"
+#include "JavaCodeGenerator.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <new>
+#include <sys/resource.h>
+
+// --- Heap allocation counting ---
+// Every operator new bumps a thread-local counter, so counting costs no shared cache line.
+
+namespace {
+thread_local uint64_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++allocationCount;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+uint64_t threadAllocationCount() {
+    return allocationCount;
+}
+
+namespace {
+
+const char* const kPhaseNames[] = {"read", "lex", "token-dump", "parse", "ast-dump", "codegen", "write"};
+static_assert(sizeof(kPhaseNames) / sizeof(kPhaseNames[0]) == static_cast<size_t>(Phase::Count),
+              "kPhaseNames must name every Phase");
+
+// Span names in --trace output, after the call that does the work
+const char* const kPhaseTraceNames[] = {"read", "Lexer::tokenize", "token dump", "Parser::parse", "AST dump",
+                                        "JavaCodeGenerator::generateProgram", "write"};
+static_assert(sizeof(kPhaseTraceNames) / sizeof(kPhaseTraceNames[0]) == static_cast<size_t>(Phase::Count),
+              "kPhaseTraceNames must name every Phase");
+
+double threadCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double processCpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+uint64_t peakRssBytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in KiB on Linux
+}
+
+// Unnamed node types still get a stable label
+std::string nodeTypeName(size_t index) {
+    std::string name = astNodeTypeToString(static_cast<ASTNodeType>(index));
+    if (name == "UNKNOWN/INVALID") name = "NODE_TYPE_" + std::to_string(index);
+    return name;
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+uint64_t totalNodes(const FileStats& stats) {
+    uint64_t total = 0;
+    for (uint64_t n : stats.astNodes) total += n;
+    return total;
+}
+
+void printText(std::ostream& out, const FileStats& stats, const std::string& title) {
+    out << title << (stats.cacheHit ? " (cached)" : "") << "\n";
+    out << "  input " << stats.inputBytes << " B, " << stats.tokens << " tokens, "
+        << totalNodes(stats) << " AST nodes, output " << stats.outputBytes << " B, "
+        << stats.allocations << " allocations\n";
+    for (int p = 0; p < static_cast<int>(Phase::Count); ++p) {
+        const PhaseTime& t = stats.phases[p];
+        if (t.wallSeconds == 0 && t.cpuSeconds == 0) continue;
+        char line[96];
+        std::snprintf(line, sizeof(line), "  %-11s wall %9.6fs  cpu %9.6fs\n", kPhaseNames[p],
+                      t.wallSeconds, t.cpuSeconds);
+        out << line;
+    }
+    std::string nodes;
+    for (size_t i = 0; i < kASTNodeTypeCount; ++i) {
+        if (!stats.astNodes[i]) continue;
+        nodes += (nodes.empty() ? "" : ", ") + nodeTypeName(i) + "=" + std::to_string(stats.astNodes[i]);
+    }
+    if (!nodes.empty()) out << "  nodes: " << nodes << "\n";
+}
+
+void printJson(std::ostream& out, const FileStats& stats, bool withPath) {
+    out << "{";
+    if (withPath) out << "\"path\":" << jsonString(stats.path) << ",\"cached\":" << (stats.cacheHit ? "true" : "false") << ",";
+    out << "\"input_bytes\":" << stats.inputBytes << ",\"tokens\":" << stats.tokens
+        << ",\"ast_nodes_total\":" << totalNodes(stats) << ",\"output_bytes\":" << stats.outputBytes
+        << ",\"allocations\":" << stats.allocations << ",\"phases\":{";
+    for (int p = 0; p < static_cast<int>(Phase::Count); ++p) {
+        out << (p ? "," : "") << "\"" << kPhaseNames[p] << "\":{\"wall_seconds\":" << stats.phases[p].wallSeconds
+            << ",\"cpu_seconds\":" << stats.phases[p].cpuSeconds << "}";
+    }
+    out << "},\"ast_nodes\":{";
+    bool first = true;
+    for (size_t i = 0; i < kASTNodeTypeCount; ++i) {
+        if (!stats.astNodes[i]) continue;
+        out << (first ? "" : ",") << jsonString(nodeTypeName(i)) << ":" << stats.astNodes[i];
+        first = false;
+    }
+    out << "}}";
+}
+
+} // unnamed namespace
+
+void FileStats::add(const FileStats& other) {
+    for (int p = 0; p < static_cast<int>(Phase::Count); ++p) {
+        phases[p].wallSeconds += other.phases[p].wallSeconds;
+        phases[p].cpuSeconds += other.phases[p].cpuSeconds;
+    }
+    inputBytes += other.inputBytes;
+    tokens += other.tokens;
+    outputBytes += other.outputBytes;
+    allocations += other.allocations;
+    for (size_t i = 0; i < kASTNodeTypeCount; ++i) astNodes[i] += other.astNodes[i];
+}
+
+PhaseTimer::PhaseTimer(FileStats* stats, Phase phase)
+    : stats_(stats), phase_(phase), tracing_(Trace::enabled()) {
+    if (tracing_) traceStartNs_ = Trace::nowNs();
+    if (!stats_) return;
+    std::copy(std::begin(astNodesBuilt), std::end(astNodesBuilt), nodesStart_);
+    allocationsStart_ = allocationCount;
+    cpuStart_ = threadCpuSeconds();
+    wallStart_ = std::chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (tracing_) Trace::record(kPhaseTraceNames[static_cast<int>(phase_)], std::string(), traceStartNs_, Trace::nowNs());
+    if (!stats_) return;
+    PhaseTime& t = stats_->phases[static_cast<int>(phase_)];
+    t.wallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart_).count();
+    t.cpuSeconds += threadCpuSeconds() - cpuStart_;
+    stats_->allocations += allocationCount - allocationsStart_;
+    for (size_t i = 0; i < kASTNodeTypeCount; ++i) stats_->astNodes[i] += astNodesBuilt[i] - nodesStart_[i];
+}
+
+void printStats(std::ostream& out, StatsFormat format, const std::vector<FileStats>& files,
+                double wallSeconds) {
+    FileStats total;
+    size_t cacheHits = 0;
+    for (const auto& file : files) {
+        total.add(file);
+        if (file.cacheHit) ++cacheHits;
+    }
+    double cpuSeconds = processCpuSeconds();
+    uint64_t peakRss = peakRssBytes();
+
+    if (format == StatsFormat::Json) {
+        out << "{\"files\":[";
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (i) out << ",";
+            printJson(out, files[i], true);
+        }
+        out << "],\"total\":";
+        printJson(out, total, false);
+        out << ",\"file_count\":" << files.size() << ",\"cache_hits\":" << cacheHits
+            << ",\"wall_seconds\":" << wallSeconds << ",\"cpu_seconds\":" << cpuSeconds
+            << ",\"peak_rss_bytes\":" << peakRss << "}\n";
+        return;
+    }
+
+    out << "--- Stats ---\n";
+    for (const auto& file : files) printText(out, file, file.path);
+    if (files.size() != 1) printText(out, total, "Total (" + std::to_string(files.size()) + " files)");
+    char line[128];
+    std::snprintf(line, sizeof(line), "Process: wall %.6fs, cpu %.6fs, peak RSS %.1f MiB\n",
+                  wallSeconds, cpuSeconds, peakRss / (1024.0 * 1024.0));
+    out << line;
+}
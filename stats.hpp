@@ -0,0 +1,63 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include "ast.hpp"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Pipeline phases timed by --stats
+enum class Phase { Read, Lex, TokenDump, Parse, AstDump, Codegen, Write, Count };
+
+struct PhaseTime {
+    double wallSeconds = 0;
+    double cpuSeconds = 0;     // CPU time of the thread(s) that ran the phase
+};
+
+// Counters for one file, or the sum over several files
+struct FileStats {
+    std::string path;
+    bool cacheHit = false;
+    PhaseTime phases[static_cast<int>(Phase::Count)];
+    uint64_t inputBytes = 0;
+    uint64_t tokens = 0;
+    uint64_t outputBytes = 0;
+    uint64_t allocations = 0;                    // operator new calls made inside timed phases
+    uint64_t astNodes[kASTNodeTypeCount] = {};   // Nodes built by the parser, per ASTNodeType
+
+    void add(const FileStats& other);
+};
+
+// Times one phase into stats and attributes the heap allocations and AST nodes created on
+// this thread meanwhile to it. Also records the phase as a --trace span. No-op when stats is
+// null and tracing is off.
+class PhaseTimer {
+public:
+    PhaseTimer(FileStats* stats, Phase phase);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    FileStats* stats_;
+    Phase phase_;
+    bool tracing_;
+    uint64_t traceStartNs_ = 0;
+    std::chrono::steady_clock::time_point wallStart_;
+    double cpuStart_ = 0;
+    uint64_t allocationsStart_ = 0;
+    uint64_t nodesStart_[kASTNodeTypeCount];
+};
+
+// operator new calls made by the calling thread since it started
+uint64_t threadAllocationCount();
+
+enum class StatsFormat { Text, Json };
+
+// Report per-file and aggregate counters, plus process wall/CPU time and peak RSS
+void printStats(std::ostream& out, StatsFormat format, const std::vector<FileStats>& files,
+                double wallSeconds);
+
+#endif // STATS_HPP
@@ -0,0 +1,3 @@
+#ifdef X
+#endif
+int a;
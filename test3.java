@@ -0,0 +1,6 @@
+
+public class test3 {
+    // #ifdef X
+    // #endif
+    int a;
+}
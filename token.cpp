@@ -1,4 +1,7 @@
-#include "tokens.hpp"
+#include "token.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <unordered_map>
@@ -274,7 +277,84 @@ const char* getTokenTypeName(TokenType type) {
 
 } // unnamed namespace
 
-Token::Token() = default;
+double Token::float_value() const {
+    if (type_ != TokenType::FLOAT) return 0;
+    double value;
+    std::memcpy(&value, &value_, sizeof(value));
+    return value;
+}
+
+void Token::set_float_value(double value) {
+    std::memcpy(&value_, &value, sizeof(value));
+}
+
+int TokenBuffer::line(size_t i) const {
+    // The last entry whose first token is at or before i
+    auto it = std::upper_bound(lines_.begin(), lines_.end(), i,
+                               [](size_t index, const LineEntry& entry) { return index < entry.first; });
+    return std::prev(it)->line;
+}
+
+void TokenBuffer::reserve(size_t n) {
+    types_.reserve(n);
+    packed_.reserve(n);
+    values_.reserve(n);
+    suffixes_.reserve(n);
+}
+
+void TokenBuffer::push_back(const Token& token) {
+    if (lines_.empty() || lines_.back().line != token.line_) {
+        lines_.push_back({static_cast<uint32_t>(types_.size()), token.line_});
+    }
+    types_.push_back(token.type_);
+    packed_.push_back({token.text_, token.length_, token.column_});
+    values_.push_back(token.value_);
+    suffixes_.push_back(token.suffix_);
+}
+
+void TokenBuffer::append(const TokenBuffer& other) {
+    uint32_t offset = static_cast<uint32_t>(types_.size());
+    for (const LineEntry& entry : other.lines_) {
+        if (!lines_.empty() && lines_.back().line == entry.line) continue;
+        lines_.push_back({entry.first + offset, entry.line});
+    }
+    types_.insert(types_.end(), other.types_.begin(), other.types_.end());
+    packed_.insert(packed_.end(), other.packed_.begin(), other.packed_.end());
+    values_.insert(values_.end(), other.values_.begin(), other.values_.end());
+    suffixes_.insert(suffixes_.end(), other.suffixes_.begin(), other.suffixes_.end());
+}
+
+void TokenBuffer::pop_back() {
+    types_.pop_back();
+    packed_.pop_back();
+    values_.pop_back();
+    suffixes_.pop_back();
+    if (lines_.back().first == types_.size()) lines_.pop_back();
+}
+
+void TokenBuffer::clear() {
+    types_.clear();
+    packed_.clear();
+    values_.clear();
+    suffixes_.clear();
+    lines_.clear();
+}
+
+std::string_view TokenStorage::store(std::string_view text) {
+    constexpr size_t kBlockSize = 16 * 1024;
+    if (text.empty()) return std::string_view();
+    if (text.size() > capacity_ - used_) {
+        // Texts larger than a block get an exactly sized block of their own
+        size_t size = std::max(text.size(), kBlockSize);
+        blocks_.push_back(std::make_unique<char[]>(size));
+        used_ = 0;
+        capacity_ = size;
+    }
+    char* dest = blocks_.back().get() + used_;
+    std::memcpy(dest, text.data(), text.size());
+    used_ += text.size();
+    return std::string_view(dest, text.size());
+}
 std::string Token::toString() const {
     std::ostringstream oss;
     oss << "Token(type=" << getTokenTypeName(type())
@@ -287,7 +367,92 @@ std::string Token::toString() const {
     } else if (type() == TokenType::FLOAT) {
         oss << ", float_value=" << std::fixed << std::setprecision(6) << float_value();
     }
+    if ((type() == TokenType::INTEGER || type() == TokenType::FLOAT) && suffix() != NumberSuffix::None) {
+        oss << ", suffix=" << numberSuffixName(suffix());
+    }
 
     oss << ")";
     return oss.str();
 }
+
+namespace {
+
+// Suffix of a number from the text after its digits
+NumberSuffix numberSuffix(std::string_view text, bool isFloat) {
+    std::string lower;
+    for (char c : text) lower += static_cast<char>(c | 0x20);
+    if (lower.empty()) return NumberSuffix::None;
+    if (isFloat) {
+        if (lower == "f") return NumberSuffix::F;
+        if (lower == "l") return NumberSuffix::L;
+        return NumberSuffix::Other;
+    }
+    static const std::pair<const char*, NumberSuffix> kSuffixes[] = {
+        {"u", NumberSuffix::U},    {"l", NumberSuffix::L},    {"ul", NumberSuffix::UL},
+        {"lu", NumberSuffix::UL},  {"ll", NumberSuffix::LL},  {"ull", NumberSuffix::ULL},
+        {"llu", NumberSuffix::ULL}, {"z", NumberSuffix::Z},   {"uz", NumberSuffix::UZ},
+        {"zu", NumberSuffix::UZ},
+    };
+    for (const auto& [spelling, suffix] : kSuffixes) {
+        if (lower == spelling) return suffix;
+    }
+    return NumberSuffix::Other;
+}
+
+} // unnamed namespace
+
+const char* numberSuffixName(NumberSuffix suffix) {
+    static const char* const kNames[] = {"", "u", "l", "ul", "ll", "ull", "z", "uz", "f", "other"};
+    return kNames[static_cast<int>(suffix)];
+}
+
+bool decodeNumber(Token& token) {
+    bool isFloat = token.type() == TokenType::FLOAT;
+    std::string_view text = token.text();
+    // from_chars knows no digit separators, so a number with them is decoded from a copy
+    std::string digits;
+    if (text.find('\'') != std::string_view::npos) {
+        for (char c : text) {
+            if (c != '\'') digits += c;
+        }
+        text = digits;
+    }
+    const char* first = text.data();
+    const char* last = first + text.size();
+    bool prefixed = text.size() > 1 && text[0] == '0';
+    char prefix = prefixed ? static_cast<char>(text[1] | 0x20) : '\0';
+    auto fail = [&token, isFloat] {
+        isFloat ? token.set_float_value(0) : token.set_int_value(0);
+        token.set_suffix(NumberSuffix::Other);
+        return false;
+    };
+
+    if (isFloat) {
+        double value = 0;
+        auto result = prefix == 'x' ? std::from_chars(first + 2, last, value, std::chars_format::hex)
+                                    : std::from_chars(first, last, value);
+        if (result.ec != std::errc()) return fail();
+        token.set_float_value(value);
+        token.set_suffix(numberSuffix(std::string_view(result.ptr, last - result.ptr), true));
+        return true;
+    }
+
+    int base = 10;
+    if (prefixed) {
+        base = prefix == 'x' ? 16 : prefix == 'b' ? 2 : 8;
+        first += base == 8 ? 1 : 2;
+    }
+    unsigned long long value = 0;
+    auto result = std::from_chars(first, last, value, base);
+    const char* end = result.ptr;
+    if (result.ec == std::errc::invalid_argument) {
+        if (base != 8) return fail();   // "0x" with no digits
+        end = first;                    // "0", perhaps with a suffix
+    } else if (result.ec != std::errc()) {
+        return fail();                  // Does not fit in 64 bits
+    }
+    if (end < last && static_cast<unsigned>(*end - '0') < 10) return fail();   // 089
+    token.set_int_value(static_cast<long long>(value));
+    token.set_suffix(numberSuffix(std::string_view(end, last - end), false));
+    return true;
+}
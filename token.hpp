@@ -1,10 +1,17 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <type_traits>
+#include <vector>
+#include "interner.hpp"
 
-enum class TokenType {
+enum class TokenType : uint16_t {
     END_OF_FILE, ERROR,
 
     IDENTIFIER, INTEGER, FLOAT, STRING, CHARACTER,
@@ -136,40 +143,195 @@ enum class TokenType {
 
 };
 
-
+// Suffix of a numeric literal. Other is anything else, e.g. a user-defined literal's (10ms),
+// and marks malformed numbers.
+enum class NumberSuffix : uint8_t { None, U, L, UL, LL, ULL, Z, UZ, F, Other };
+
+const char* numberSuffixName(NumberSuffix suffix);   // "ull", "f", ...; "" for None
+
+// A token is a 32-byte trivially copyable value. Its text points into the source buffer (or
+// into a TokenStorage arena for text the lexer synthesizes); TokenBuffer keeps whichever it
+// is alive. One 8-byte field holds the interned symbol of an IDENTIFIER or the decoded value
+// of an INTEGER or FLOAT.
+//
+// 32 bytes is the floor for a Token that stands on its own. Tokens leave their buffer (macro
+// bodies, the prelude, included headers, parallel chunks) and mix texts from several sources
+// and arenas, so text() needs a full pointer rather than an offset from a base only the buffer
+// knows; #if and constant folding need the full 64-bit value. Those two fields are 16 bytes
+// before the length, type and position. Stored tokens cost 27 bytes each in TokenBuffer's
+// columns plus the line table, and its hot scans read only the 2-byte types() column.
 class Token {
 public:
-    
-    Token();
-    Token(TokenType type, std::string text, int line, int column)
-        : type_(type), text_(std::move(text)), line_(line), column_(column),
-          int_value_(0), is_float_(false), has_escape_(false) {}
+    Token() = default;
+    Token(TokenType type, std::string_view text, int line, int column, Symbol symbol = sym::None)
+        : text_(text.data()), length_(static_cast<uint32_t>(text.size())), type_(type), line_(line),
+          column_(column), value_(symbol) {}
 
     TokenType type() const { return type_; }
-    const std::string& text() const { return text_; }
+    std::string_view text() const { return std::string_view(text_, length_); }
+    Symbol symbol() const { return isNumber() ? sym::None : static_cast<Symbol>(value_); }   // IDENTIFIER tokens
     int line() const { return line_; }
     int column() const { return column_; }
-    long long int_value() const { return int_value_; }
-    double float_value() const { return float_value_; }
-    bool is_float() const { return is_float_; }
-    bool has_escape() const { return has_escape_; }
+    long long int_value() const { return type_ == TokenType::INTEGER ? static_cast<long long>(value_) : 0; }
+    double float_value() const;
+    bool is_float() const { return type_ == TokenType::FLOAT; }
+    NumberSuffix suffix() const { return suffix_; }   // INTEGER and FLOAT tokens
+
+    void set_int_value(long long value) { value_ = static_cast<uint64_t>(value); }
+    void set_float_value(double value);
+    void set_suffix(NumberSuffix suffix) { suffix_ = suffix; }
+
+    // The same token with another text and position, e.g. a macro's body token placed at the
+    // macro's use site; a number keeps its decoded value
+    Token moved(std::string_view text, int line, int column) const {
+        Token token = *this;
+        token.text_ = text.data();
+        token.length_ = static_cast<uint32_t>(text.size());
+        token.line_ = line;
+        token.column_ = column;
+        return token;
+    }
+
+    // For diagnostics (--emit=tokens, debug logs) only
+    std::string toString() const;
 
-    void set_int_value(long long value) { int_value_ = value; is_float_ = false; }
-    void set_float_value(double value) { float_value_ = value; is_float_ = true; }
+private:
+    friend class TokenBuffer;
 
-    std::string toString() const;
+    const char* text_ = nullptr;
+    uint32_t length_ = 0;
+    TokenType type_ = TokenType::END_OF_FILE;
+    NumberSuffix suffix_ = NumberSuffix::None;
+    int32_t line_ = 0;
+    int32_t column_ = 0;
+    uint64_t value_ = 0;   // Symbol, long long or the bits of a double
+
+    bool isNumber() const { return type_ == TokenType::INTEGER || type_ == TokenType::FLOAT; }
+};
+
+static_assert(sizeof(Token) == 32, "Token is copied by value everywhere; see above before growing it");
+static_assert(std::is_trivially_copyable<Token>::value, "TokenBuffer and TokenStream copy Tokens as plain bytes");
+
+// Decode an INTEGER or FLOAT token's text into its value and suffix: decimal, 0x hex, 0b
+// binary and 0 octal integers, decimal and hex floats, ' digit separators. Integers that do
+// not fit in 64 bits, and malformed digits, leave the value 0 and return false.
+bool decodeNumber(Token& token);
+
+// Owns the bytes token texts point into: the source (through owner, which may be null if
+// the caller guarantees the source outlives the tokens) and an append-only arena for text
+// that is not in the source, such as macro expansions and rewritten raw strings.
+class TokenStorage {
+public:
+    explicit TokenStorage(std::shared_ptr<const void> owner) : owner_(std::move(owner)) {}
+    TokenStorage(const TokenStorage&) = delete;
+    TokenStorage& operator=(const TokenStorage&) = delete;
+
+    // Copy text into the arena; the returned view stays valid as long as this storage
+    std::string_view store(std::string_view text);
+    // Keep other (e.g. the storage of tokens lexed separately and merged in) alive as long as this
+    void adopt(std::shared_ptr<TokenStorage> other) { adopted_.push_back(std::move(other)); }
 
 private:
-    TokenType type_;
-    std::string text_;
-    int line_;
-    int column_;
-    union {
-        long long int_value_;
-        double float_value_;
+    std::shared_ptr<const void> owner_;
+    std::vector<std::shared_ptr<TokenStorage>> adopted_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t used_ = 0;        // Bytes used in blocks_.back()
+    size_t capacity_ = 0;    // Size of blocks_.back()
+};
+
+// Tokens stored column by column (struct of arrays), plus shared ownership of their text.
+// Scans that only look at types (the parser's lookahead, splitTopLevelDeclarations, include
+// guard detection) read the dense types() array, 2 bytes a token; text and column are one
+// 16-byte record, and lines are kept in a table with an entry only where the line changes.
+// operator[] and the iterators assemble Token values. Copies and sub-ranges (see
+// splitTopLevelDeclarations) share the same storage.
+class TokenBuffer {
+public:
+    // Where a token's text is, and its column
+    struct PackedToken {
+        const char* text;
+        uint32_t length;
+        int32_t column;
+    };
+    // Tokens from index first on (up to the next entry) are on line
+    struct LineEntry {
+        uint32_t first;
+        int32_t line;
     };
-    bool is_float_;
-    bool has_escape_;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Token;
+
+        const_iterator(const TokenBuffer* buffer, size_t index, size_t lineEntry)
+            : buffer_(buffer), index_(index), lineEntry_(lineEntry) {}
+        Token operator*() const { return buffer_->token(index_, buffer_->lines_[lineEntry_].line); }
+        const_iterator& operator++() {
+            ++index_;
+            buffer_->advanceLine(index_, lineEntry_);
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const TokenBuffer* buffer_;
+        size_t index_;
+        size_t lineEntry_;
+    };
+
+    TokenBuffer() = default;
+    explicit TokenBuffer(std::shared_ptr<TokenStorage> storage) : storage_(std::move(storage)) {}
+
+    size_t size() const { return types_.size(); }
+    bool empty() const { return types_.empty(); }
+    TokenType type(size_t i) const { return types_[i]; }
+    const TokenType* types() const { return types_.data(); }
+    int line(size_t i) const;   // Binary search of the line table
+    Token operator[](size_t i) const { return token(i, line(i)); }
+    Token back() const { return token(size() - 1, lines_.back().line); }
+    // Token i, keeping lineEntry (start at 0) on its line table entry: O(1) when i only grows
+    Token at(size_t i, size_t& lineEntry) const {
+        advanceLine(i, lineEntry);
+        return token(i, lines_[lineEntry].line);
+    }
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, size(), 0); }
+
+    void reserve(size_t n);
+    void push_back(const Token& token);
+    void append(const TokenBuffer& other);   // Column by column; other's storage is not adopted
+    void pop_back();
+    void clear();
+
+    const std::shared_ptr<TokenStorage>& storage() const { return storage_; }
+
+private:
+    std::vector<TokenType> types_;
+    std::vector<PackedToken> packed_;
+    std::vector<uint64_t> values_;           // Token::value_
+    std::vector<NumberSuffix> suffixes_;
+    std::vector<LineEntry> lines_;
+    std::shared_ptr<TokenStorage> storage_;
+
+    Token token(size_t i, int line) const {
+        Token token;
+        token.text_ = packed_[i].text;
+        token.length_ = packed_[i].length;
+        token.type_ = types_[i];
+        token.suffix_ = suffixes_[i];
+        token.line_ = line;
+        token.column_ = packed_[i].column;
+        token.value_ = values_[i];
+        return token;
+    }
+    void advanceLine(size_t i, size_t& lineEntry) const {
+        while (lineEntry + 1 < lines_.size() && lines_[lineEntry + 1].first <= i) ++lineEntry;
+    }
 };
 
 #endif
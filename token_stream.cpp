@@ -0,0 +1,82 @@
+#include "token_stream.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kInitialRingSize = 16;   // Enough for the parser's lookahead without checkpoints
+
+} // unnamed namespace
+
+TokenStream::TokenStream(Lexer& lexer) : lexer_(&lexer), ring_(kInitialRingSize), types_(kInitialRingSize) {}
+
+TokenStream::TokenStream(TokenBuffer tokens)
+    : buffer_(std::move(tokens)), ring_(kInitialRingSize), types_(kInitialRingSize) {}
+
+Token TokenStream::pull() {
+    if (lexer_) return lexer_->next();
+    if (bufferPos_ < buffer_.size()) return buffer_.at(bufferPos_++, bufferLine_);
+    // Exhausted (or empty) buffer: repeat its END_OF_FILE, or make one
+    if (!buffer_.empty() && buffer_.back().type() == TokenType::END_OF_FILE) return buffer_.back();
+    int line = buffer_.empty() ? 1 : buffer_.back().line();
+    return Token(TokenType::END_OF_FILE, "", line, 0);
+}
+
+size_t TokenStream::oldestNeeded() const {
+    size_t oldest = position_;
+    for (Mark mark : marks_) oldest = std::min(oldest, mark);
+    return oldest;
+}
+
+void TokenStream::fill(size_t end) {
+    while (filled_ < end) {
+        size_t oldest = oldestNeeded();
+        if (filled_ - oldest == ring_.size()) {
+            // A checkpoint pins more tokens than the ring holds: double it, keeping each
+            // buffered token at its position modulo the new size
+            std::vector<Token> grown(ring_.size() * 2);
+            std::vector<TokenType> grownTypes(grown.size());
+            for (size_t i = oldest; i < filled_; ++i) {
+                grown[i & (grown.size() - 1)] = at(i);
+                grownTypes[i & (grown.size() - 1)] = at(i).type();
+            }
+            ring_.swap(grown);
+            types_.swap(grownTypes);
+        }
+        size_t slot = filled_ & (ring_.size() - 1);
+        ring_[slot] = pull();
+        types_[slot] = ring_[slot].type();
+        ++filled_;
+    }
+}
+
+const Token& TokenStream::peek(size_t k) {
+    fill(position_ + k + 1);
+    return at(position_ + k);
+}
+
+void TokenStream::advance() {
+    if (type() != TokenType::END_OF_FILE) ++position_;
+}
+
+TokenStream::Mark TokenStream::mark() {
+    marks_.push_back(position_);
+    return position_;
+}
+
+void TokenStream::rewind(Mark mark) {
+    release(mark);
+    position_ = mark;
+}
+
+void TokenStream::release(Mark mark) {
+    auto it = std::find(marks_.rbegin(), marks_.rend(), mark);
+    if (it == marks_.rend()) throw std::runtime_error("TokenStream: release of a checkpoint that is not open");
+    marks_.erase(std::next(it).base());
+}
+
+std::string TokenStream::textSince(Mark mark) const {
+    std::string text;
+    for (size_t i = mark; i < position_; ++i) text += at(i).text();
+    return text;
+}
@@ -0,0 +1,64 @@
+#ifndef TOKEN_STREAM_HPP
+#define TOKEN_STREAM_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+#include "token.hpp"
+
+// The parser's view of its input: the current token, bounded lookahead and checkpoints for
+// backtracking. Tokens come either from a Lexer pulled on demand or from an already
+// materialised TokenBuffer. Only the tokens from the oldest open checkpoint (or the current
+// token) up to the furthest peek are buffered, in a ring that grows only when a checkpoint
+// spans more tokens than it holds, so token memory does not depend on file size.
+class TokenStream {
+public:
+    using Mark = size_t;   // Absolute position of a checkpointed token
+
+    // The lexer must outlive the stream
+    explicit TokenStream(Lexer& lexer);
+    explicit TokenStream(TokenBuffer tokens);
+
+    // Token k positions past the current one (END_OF_FILE past the end). The reference is
+    // valid until the next call on the stream.
+    const Token& peek(size_t k = 0);
+    // Type of token k positions past the current one, from a dense ring of types alone
+    TokenType type(size_t k = 0) {
+        fill(position_ + k + 1);
+        return types_[(position_ + k) & (ring_.size() - 1)];
+    }
+    // Move to the next token; stays put on END_OF_FILE
+    void advance();
+    size_t position() const { return position_; }
+
+    // Keep the current token and everything after it buffered until rewind or release
+    Mark mark();
+    // Make the checkpointed token current again, and drop the checkpoint
+    void rewind(Mark mark);
+    void release(Mark mark);
+    // Texts of the tokens from mark up to (not including) the current one, concatenated
+    std::string textSince(Mark mark) const;
+
+    // Tokens taken from the source so far (including lookahead)
+    size_t tokensRead() const { return filled_; }
+
+private:
+    Lexer* lexer_ = nullptr;
+    TokenBuffer buffer_;          // Source when constructed from a TokenBuffer
+    size_t bufferPos_ = 0;
+    size_t bufferLine_ = 0;       // buffer_'s line table entry for bufferPos_
+
+    std::vector<Token> ring_;     // Size is a power of two; token n lives at n & (size - 1)
+    std::vector<TokenType> types_;   // ring_[i].type(), kept apart so type checks read 2 bytes a token
+    size_t position_ = 0;         // Current token
+    size_t filled_ = 0;           // One past the last buffered token
+    std::vector<Mark> marks_;     // Open checkpoints
+
+    Token pull();
+    void fill(size_t end);        // Buffer tokens up to position end - 1
+    size_t oldestNeeded() const;
+    const Token& at(size_t position) const { return ring_[position & (ring_.size() - 1)]; }
+};
+
+#endif // TOKEN_STREAM_HPP
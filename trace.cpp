@@ -0,0 +1,125 @@
+#include "trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    std::string detail;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+// One per thread that recorded anything; kept alive after the thread exits
+struct ThreadTrace {
+    unsigned tid = 0;
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadTrace>> threads;
+unsigned nextTid = 1;
+std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+ThreadTrace& threadTrace() {
+    thread_local std::shared_ptr<ThreadTrace> trace;
+    if (!trace) {
+        trace = std::make_shared<ThreadTrace>();
+        trace->events.reserve(1024);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        trace->tid = nextTid++;
+        threads.push_back(trace);
+    }
+    return *trace;
+}
+
+void appendJsonString(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+} // unnamed namespace
+
+void Trace::start() {
+    origin = std::chrono::steady_clock::now();
+    nameThread("main");
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Trace::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin).count());
+}
+
+void Trace::nameThread(const std::string& name) {
+    ThreadTrace& trace = threadTrace();
+    if (trace.name.empty()) trace.name = name;
+}
+
+void Trace::record(const char* name, const std::string& detail, uint64_t startNs, uint64_t endNs) {
+    threadTrace().events.push_back({name, detail, startNs, endNs - startNs});
+}
+
+void Trace::write(const std::string& path) {
+    enabled_.store(false, std::memory_order_relaxed);
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+
+    // Timestamps are microseconds; all spans are complete ("X") events of one process
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char number[64];
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& thread : threads) {
+        if (!thread->name.empty()) {
+            json += first ? "" : ",";
+            first = false;
+            json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + std::to_string(thread->tid) +
+                    ",\"args\":{\"name\":";
+            appendJsonString(json, thread->name);
+            json += "}}";
+        }
+        for (const auto& event : thread->events) {
+            json += first ? "\n" : ",\n";
+            first = false;
+            json += "{\"ph\":\"X\",\"name\":";
+            appendJsonString(json, event.name);
+            std::snprintf(number, sizeof(number), ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                          thread->tid, event.startNs / 1e3, event.durationNs / 1e3);
+            json += number;
+            if (!event.detail.empty()) {
+                json += ",\"args\":{\"detail\":";
+                appendJsonString(json, event.detail);
+                json += "}";
+            }
+            json += "}";
+        }
+        if (json.size() > (1 << 20)) {
+            out << json;
+            json.clear();
+        }
+    }
+    json += "\n]}\n";
+    out << json;
+}
@@ -0,0 +1,52 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline recorder for --trace, written in Chrome trace-event format (loads in Perfetto
+// and chrome://tracing). Each thread appends complete ("X") events to its own buffer, so a
+// span costs two clock reads and one vector push; nothing is shared until write().
+class Trace {
+public:
+    // Begin recording; spans before this call are ignored
+    static void start();
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Label the calling thread in the timeline (first name wins)
+    static void nameThread(const std::string& name);
+
+    // Serialize every recorded span; throws std::runtime_error if path cannot be written
+    static void write(const std::string& path);
+
+    // Record a finished span; name must be a string literal, detail is shown as args.detail
+    static void record(const char* name, const std::string& detail, uint64_t startNs, uint64_t endNs);
+    static uint64_t nowNs();
+
+private:
+    static inline std::atomic<bool> enabled_{false};
+};
+
+// Records [construction, destruction) as one span when tracing is enabled
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, std::string detail = std::string())
+        : name_(Trace::enabled() ? name : nullptr) {
+        if (!name_) return;
+        detail_ = std::move(detail);
+        startNs_ = Trace::nowNs();
+    }
+    ~TraceSpan() {
+        if (name_) Trace::record(name_, detail_, startNs_, Trace::nowNs());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    std::string detail_;
+    uint64_t startNs_ = 0;
+};
+
+#endif // TRACE_HPP
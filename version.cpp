@@ -0,0 +1,9 @@
+#include "version.hpp"
+
+// __DATE__ and __TIME__ are this translation unit's compile time; expanding them in each cache's
+// own file would give each a different ID whenever the files are compiled a second apart
+#ifndef TRANSPILER_BUILD_ID
+#define TRANSPILER_BUILD_ID TRANSPILER_VERSION " " __DATE__ " " __TIME__
+#endif
+
+const char* buildId() { return TRANSPILER_BUILD_ID; }
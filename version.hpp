@@ -0,0 +1,11 @@
+#ifndef VERSION_HPP
+#define VERSION_HPP
+
+#define TRANSPILER_VERSION "0.2.0"
+
+// Identifies the transpiler build in cache keys, so results from an older binary are never reused.
+// Defined in version.cpp alone, so every cache in one binary agrees on it; override with
+// -DTRANSPILER_BUILD_ID=... for reproducible builds.
+const char* buildId();
+
+#endif // VERSION_HPP